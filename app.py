@@ -1,15 +1,84 @@
+import glob
+import os
+import struct
+import sys
+
+import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
 
-# Read original strikes and mid IVs
-original_data = pd.read_csv('original_strikes_mid_iv.csv')
-original_strikes = original_data['Strike']
-mid_ivs = original_data['IV']
+# Usage: python app.py [output file]
+#        python app.py --store TICKER [START_MS END_MS]
+# Plots the given smile output (a .bin file or either CSV of a pair), or the newest one in OUTPUT_DIR.
+# With --store, plots the smiles of TICKER fitted within the time range from SURFACE_STORE_DIR instead.
+output_dir = os.environ.get('OUTPUT_DIR', 'output')
+store_dir = os.environ.get('SURFACE_STORE_DIR', 'store')
+
+
+def newest_output():
+    files = glob.glob(os.path.join(output_dir, '*.bin')) + glob.glob(os.path.join(output_dir, '*_original.csv'))
+    if not files:
+        sys.exit('No smile outputs in ' + output_dir)
+    return max(files, key=os.path.getmtime)
+
+
+def read_binary(path):
+    with open(path, 'rb') as file:
+        data = file.read()
+    if data[:8] != b'OKBSMIL1':
+        sys.exit(path + ' is not a smile output')
+    offset = 8
+    for _ in range(3):  # ticker, date, option type
+        (length,) = struct.unpack_from('<I', data, offset)
+        offset += 4 + length
+    _, original_count, interpolated_count = struct.unpack_from('<qII', data, offset)
+    offset += 16
+    original = np.frombuffer(data, '<f8', 2 * original_count, offset).reshape(2, original_count)
+    offset += 16 * original_count
+    interpolated = np.frombuffer(data, '<f8', 2 * interpolated_count, offset).reshape(2, interpolated_count)
+    return original[0], original[1], interpolated[0], interpolated[1]
+
+
+def read_csv_pair(path):
+    prefix = path.rsplit('_', 1)[0]
+    original_data = pd.read_csv(prefix + '_original.csv')
+    interpolated_data = pd.read_csv(prefix + '_interpolated.csv')
+    return original_data['Strike'], original_data['IV'], interpolated_data['Strike'], interpolated_data['IV']
+
+
+def plot_store(ticker, start_ms, end_ms, max_smiles=10):
+    import surface_store
+
+    smiles = surface_store.query(store_dir, ticker, start_ms, end_ms)
+    if smiles.empty:
+        sys.exit('No smiles of ' + ticker + ' in ' + store_dir + ' in that time range')
+
+    plt.figure(figsize=(10, 6))
+    picks = np.unique(np.linspace(0, len(smiles) - 1, min(max_smiles, len(smiles))).astype(int))
+    colors = plt.cm.viridis(np.linspace(0, 1, len(picks)))
+    for color, i in zip(colors, picks):
+        smile = smiles.iloc[i]
+        label = str(pd.to_datetime(smile['timestamp_ms'], unit='ms', utc=True)) + ' exp ' + str(smile['expiry'])
+        plt.plot(smile['grid_strikes'], smile['grid_ivs'], color=color, label=label, zorder=3)
+        plt.scatter(smile['strikes'], smile['strike_ivs'], color=color, s=8, zorder=5)
+
+    plt.title(ticker + ': ' + str(len(smiles)) + ' stored smiles, ' + str(len(picks)) + ' shown')
+    plt.xlabel('Strike Price')
+    plt.ylabel('Implied Volatility')
+    plt.legend(fontsize='small')
+    plt.grid(True)
+    plt.show()
+
+
+if len(sys.argv) > 2 and sys.argv[1] == '--store':
+    plot_store(sys.argv[2], int(sys.argv[3]) if len(sys.argv) > 3 else 0, int(sys.argv[4]) if len(sys.argv) > 4 else 253402300799999)
+    sys.exit(0)
 
-# Read new strikes and interpolated IVs
-interpolated_data = pd.read_csv('interpolated_strikes_iv.csv')
-new_strikes = interpolated_data['Strike']
-interpolated_ivs = interpolated_data['IV']
+path = sys.argv[1] if len(sys.argv) > 1 else newest_output()
+if path.endswith('.bin'):
+    original_strikes, mid_ivs, new_strikes, interpolated_ivs = read_binary(path)
+else:
+    original_strikes, mid_ivs, new_strikes, interpolated_ivs = read_csv_pair(path)
 
 # Plot the data
 plt.figure(figsize=(10, 6))
@@ -21,7 +90,7 @@ plt.scatter(original_strikes, mid_ivs, color='red', label='Original Mid IVs', zo
 plt.plot(new_strikes, interpolated_ivs, color='blue', label='Interpolated IVs', zorder=3)
 
 # Adding labels and legend
-plt.title('Original and Interpolated IVs')
+plt.title('Original and Interpolated IVs (' + os.path.basename(path) + ')')
 plt.xlabel('Strike Price')
 plt.ylabel('Implied Volatility')
 plt.legend()
@@ -0,0 +1,437 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "data.h"
+#include "filters.h"
+#include "helpers.h"
+#include "interpolations.h"
+#include "minimize.h"
+#include "models.h"
+#include "option_chain.h"
+#include "rbf.h"
+#include "smile_surface.h"
+#include "synthetic_chain.h"
+
+/**
+ * @brief Strikes and model prices of a synthetic chain, for the scalar pricing kernels.
+ */
+struct PricingInputs
+{
+    std::vector<double> strikes;
+    std::vector<double> prices;
+    std::vector<double> ivs;
+
+    explicit PricingInputs(std::size_t count)
+    {
+        OptionChain chain;
+        make_synthetic_chain(count, chain);
+        strikes = chain.strike;
+        prices = chain.mid;
+        ivs.assign(count, 0.0);
+    }
+};
+
+static void BM_NormalCdf(benchmark::State &state)
+{
+    std::vector<double> x(1024);
+    for (std::size_t i = 0; i < x.size(); ++i)
+    {
+        x[i] = -4.0 + 8.0 * static_cast<double>(i) / static_cast<double>(x.size());
+    }
+
+    for (auto _ : state)
+    {
+        double sum = 0.0;
+        for (double value : x)
+        {
+            sum += normal_cdf(value);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(x.size()));
+}
+BENCHMARK(BM_NormalCdf);
+
+static void BM_BaroneAdesiWhaley(benchmark::State &state)
+{
+    PricingInputs inputs(100);
+    for (auto _ : state)
+    {
+        for (double K : inputs.strikes)
+        {
+            benchmark::DoNotOptimize(barone_adesi_whaley_american_option_price(BENCH_S, K, BENCH_T, BENCH_R, 0.25, BENCH_Q, "calls"));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.strikes.size()));
+}
+BENCHMARK(BM_BaroneAdesiWhaley);
+
+static void BM_BawPriceChainConstants(benchmark::State &state)
+{
+    PricingInputs inputs(100);
+    ChainPricingConstants constants = make_chain_pricing_constants(BENCH_S, BENCH_R, BENCH_T, BENCH_Q);
+    std::vector<double> log_strikes(inputs.strikes.size());
+    for (std::size_t i = 0; i < log_strikes.size(); ++i)
+    {
+        log_strikes[i] = std::log(inputs.strikes[i]);
+    }
+
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < inputs.strikes.size(); ++i)
+        {
+            benchmark::DoNotOptimize(baw_price<OptionKind::Call>(constants, inputs.strikes[i], log_strikes[i], 0.25));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.strikes.size()));
+}
+BENCHMARK(BM_BawPriceChainConstants);
+
+static void BM_CalculateImpliedVolatilityBaw(benchmark::State &state)
+{
+    PricingInputs inputs(100);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < inputs.strikes.size(); ++i)
+        {
+            benchmark::DoNotOptimize(calculate_implied_volatility_baw(inputs.prices[i], BENCH_S, inputs.strikes[i], BENCH_R, BENCH_T, BENCH_Q, "calls"));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.strikes.size()));
+}
+BENCHMARK(BM_CalculateImpliedVolatilityBaw);
+
+static void BM_CalculateImpliedVolatilityBawNewton(benchmark::State &state)
+{
+    PricingInputs inputs(100);
+    for (auto _ : state)
+    {
+        for (std::size_t i = 0; i < inputs.strikes.size(); ++i)
+        {
+            benchmark::DoNotOptimize(calculate_implied_volatility_baw_newton(inputs.prices[i], BENCH_S, inputs.strikes[i], BENCH_R, BENCH_T, BENCH_Q, "calls"));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.strikes.size()));
+}
+BENCHMARK(BM_CalculateImpliedVolatilityBawNewton);
+
+static void BM_ImpliedVolatilityBatch(benchmark::State &state)
+{
+    PricingInputs inputs(static_cast<std::size_t>(state.range(0)));
+    IVSolverMode mode = state.range(1) ? IVSolverMode::Newton : IVSolverMode::Bisection;
+    for (auto _ : state)
+    {
+        calculate_implied_volatility_baw_batch(inputs.prices.data(), inputs.strikes.data(), inputs.ivs.data(), inputs.strikes.size(), BENCH_S, BENCH_R, BENCH_T, BENCH_Q, OptionKind::Call, 100, 1e-8, mode);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ImpliedVolatilityBatch)->ArgNames({"strikes", "newton"})->ArgsProduct({{20, 200, 2000}, {0, 1}});
+
+static void BM_GreeksFiniteDifference(benchmark::State &state)
+{
+    PricingInputs inputs(100);
+    for (auto _ : state)
+    {
+        for (double K : inputs.strikes)
+        {
+            // Price, bumped-spot gamma and bumped-volatility vega, as the greeks were computed before
+            const double h = 1e-4;
+            double price = baw_price<OptionKind::Call>(BENCH_S, K, BENCH_T, BENCH_R, 0.25, BENCH_Q);
+            double gamma = (baw_price<OptionKind::Call>(BENCH_S + h, K, BENCH_T, BENCH_R, 0.25, BENCH_Q) - 2 * price + baw_price<OptionKind::Call>(BENCH_S - h, K, BENCH_T, BENCH_R, 0.25, BENCH_Q)) / (h * h);
+            double vega = (baw_price<OptionKind::Call>(BENCH_S, K, BENCH_T, BENCH_R, 0.25 + h, BENCH_Q) - baw_price<OptionKind::Call>(BENCH_S, K, BENCH_T, BENCH_R, 0.25 - h, BENCH_Q)) / (2 * h);
+            benchmark::DoNotOptimize(gamma);
+            benchmark::DoNotOptimize(vega);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.strikes.size()));
+}
+BENCHMARK(BM_GreeksFiniteDifference);
+
+static void BM_GreeksBatch(benchmark::State &state)
+{
+    PricingInputs inputs(static_cast<std::size_t>(state.range(0)));
+    std::vector<double> ivs(inputs.strikes.size(), 0.25);
+    std::vector<OptionGreeks> greeks(inputs.strikes.size());
+    for (auto _ : state)
+    {
+        calculate_greeks_baw_batch(inputs.strikes.data(), ivs.data(), greeks.data(), greeks.size(), BENCH_S, BENCH_R, BENCH_T, BENCH_Q, OptionKind::Call);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_GreeksBatch)->Arg(100)->Arg(2000);
+
+static void BM_SensitivitiesForwardDiff(benchmark::State &state)
+{
+    PricingInputs inputs(100);
+    for (auto _ : state)
+    {
+        for (double K : inputs.strikes)
+        {
+            benchmark::DoNotOptimize(calculate_sensitivities_baw(OptionKind::Call, BENCH_S, K, BENCH_T, BENCH_R, 0.25, BENCH_Q));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(inputs.strikes.size()));
+}
+BENCHMARK(BM_SensitivitiesForwardDiff);
+
+/**
+ * @brief Log-moneyness and a smooth smile, as SmileSurface feeds them to the RBF.
+ *
+ * @param count Number of centers.
+ * @param k Receives the centers.
+ * @param y Receives the values.
+ */
+static void make_rbf_inputs(Eigen::Index count, Eigen::VectorXd &k, Eigen::VectorXd &y)
+{
+    k = Eigen::VectorXd::LinSpaced(count, std::log(0.5), std::log(1.5));
+    y = (0.25 - 0.1 * k.array() + 0.8 * k.array().square()).matrix();
+}
+
+static void BM_RBFConstruct(benchmark::State &state)
+{
+    Eigen::VectorXd k, y;
+    make_rbf_inputs(state.range(0), k, y);
+    for (auto _ : state)
+    {
+        RBFInterpolator rbf(k, y, 0.5);
+        benchmark::DoNotOptimize(rbf.epsilon());
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_RBFConstruct)->RangeMultiplier(4)->Range(20, 1280)->Complexity(benchmark::oNCubed)->Unit(benchmark::kMicrosecond);
+
+static void BM_RBFInterpolate(benchmark::State &state)
+{
+    Eigen::VectorXd k, y;
+    make_rbf_inputs(state.range(0), k, y);
+    RBFInterpolator rbf(k, y, 0.5);
+    Eigen::VectorXd grid = Eigen::VectorXd::LinSpaced(800, std::log(0.5), std::log(1.5));
+    for (auto _ : state)
+    {
+        Eigen::VectorXd values = rbf.interpolate(grid);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * grid.size());
+}
+BENCHMARK(BM_RBFInterpolate)->RangeMultiplier(4)->Range(20, 1280);
+
+/**
+ * @brief Checks a refitted interpolator against one factorized from scratch on the same data.
+ *
+ * The kernel matrix is ill-conditioned, so weights of two exact solves already differ in the
+ * third digit; the interpolants they define agree far closer, and that is what is compared.
+ *
+ * @param refitted Interpolator after refit(k, y).
+ * @param k Centers it was refitted to.
+ * @param y Values it was refitted to.
+ * @param error Receives a description of the mismatch.
+ * @return bool True if the interpolants agree to 1e-7 over the smile range.
+ */
+static bool matches_fresh_fit(const RBFInterpolator &refitted, const Eigen::VectorXd &k, const Eigen::VectorXd &y, std::string &error)
+{
+    RBFInterpolator fresh(k, y, refitted.epsilon());
+    Eigen::VectorXd grid = Eigen::VectorXd::LinSpaced(800, std::log(0.5), std::log(1.5));
+    double difference = (refitted.interpolate(grid) - fresh.interpolate(grid)).cwiseAbs().maxCoeff();
+    if (refitted.weights().size() == k.size() && difference < 1e-7)
+        return true;
+
+    error = "refit to " + std::to_string(k.size()) + " centers differs from a fresh factorization by " + std::to_string(difference);
+    return false;
+}
+
+/**
+ * @brief Refits an interpolator back and forth between two chains, checking each refit first.
+ *
+ * Arguments: the strike count and the edit between the chains. 0 only moves the IVs (a
+ * back-substitution), 1 adds a strike inside the range and 2 removes one (bordered solves
+ * against the factor of the original chain), 3 adds a strike above the range, which moves
+ * every center through the SmileSurface normalization and refactorizes. Each iteration
+ * performs the edit and its reverse.
+ */
+static void BM_RBFRefit(benchmark::State &state)
+{
+    Eigen::Index count = state.range(0);
+    Eigen::VectorXd strikes = Eigen::VectorXd::LinSpaced(count, 400.0, 700.0);
+    Eigen::VectorXd edited_strikes = strikes;
+    if (state.range(1) == 1)
+    {
+        edited_strikes.resize(count + 1);
+        edited_strikes << strikes.head(count / 2), 0.5 * (strikes(count / 2 - 1) + strikes(count / 2)), strikes.tail(count - count / 2);
+    }
+    else if (state.range(1) == 2)
+    {
+        edited_strikes.resize(count - 1);
+        edited_strikes << strikes.head(count / 2), strikes.tail(count - count / 2 - 1);
+    }
+    else if (state.range(1) == 3)
+    {
+        edited_strikes.resize(count + 1);
+        edited_strikes << strikes, 700.0 + 300.0 / (count - 1);
+    }
+
+    auto smile = [](const Eigen::VectorXd &k, double shift) -> Eigen::VectorXd
+    { return (0.25 + shift - 0.1 * k.array() + 0.8 * k.array().square()).matrix(); };
+    Eigen::VectorXd k = make_smile_coordinates(strikes).log_x_normalized;
+    Eigen::VectorXd edited_k = make_smile_coordinates(edited_strikes).log_x_normalized;
+    Eigen::VectorXd y = smile(k, 0.0);
+    Eigen::VectorXd edited_y = smile(edited_k, 0.01);
+
+    RBFInterpolator rbf(k, y, 0.5);
+    std::string error;
+    rbf.refit(edited_k, edited_y);
+    bool matches = matches_fresh_fit(rbf, edited_k, edited_y, error);
+    rbf.refit(k, y);
+    if (!matches || !matches_fresh_fit(rbf, k, y, error))
+    {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        rbf.refit(edited_k, edited_y);
+        rbf.refit(k, y);
+        benchmark::DoNotOptimize(rbf.weights().data());
+    }
+}
+BENCHMARK(BM_RBFRefit)->ArgNames({"strikes", "edit"})->ArgsProduct({{50, 200}, {0, 1, 2, 3}})->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief IVs of a synthetic chain with a bid/ask band around them, as fit_model receives them.
+ */
+struct SmileInputs
+{
+    Eigen::VectorXd x;
+    Eigen::VectorXd mid;
+    Eigen::VectorXd bid;
+    Eigen::VectorXd ask;
+
+    explicit SmileInputs(Eigen::Index count)
+    {
+        x = Eigen::VectorXd::LinSpaced(count, 0.5, 1.5);
+        Eigen::ArrayXd m = x.array().log();
+        mid = (0.25 - 0.1 * m + 0.8 * m.square()).matrix();
+        bid = (mid.array() - 0.01).matrix();
+        ask = (mid.array() + 0.01).matrix();
+    }
+};
+
+static void BM_FitModelCold(benchmark::State &state)
+{
+    SmileInputs inputs(state.range(0));
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fit_model(inputs.x, inputs.mid, inputs.bid, inputs.ask).data());
+    }
+}
+BENCHMARK(BM_FitModelCold)->Arg(40)->Arg(400)->Unit(benchmark::kMicrosecond);
+
+static void BM_FitModelWarm(benchmark::State &state)
+{
+    SmileInputs inputs(state.range(0));
+    fit_model(inputs.x, inputs.mid, inputs.bid, inputs.ask, "bench");
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(fit_model(inputs.x, inputs.mid, inputs.bid, inputs.ask, "bench").data());
+    }
+}
+BENCHMARK(BM_FitModelWarm)->Arg(40)->Arg(400)->Unit(benchmark::kMicrosecond);
+
+static void BM_MinimizeRosenbrock(benchmark::State &state)
+{
+    const Eigen::Index n = 5;
+    auto rosenbrock = [](const Eigen::VectorXd &x, Eigen::VectorXd &grad)
+    {
+        double f = 0.0;
+        grad.setZero(x.size());
+        for (Eigen::Index i = 0; i + 1 < x.size(); ++i)
+        {
+            double a = x[i + 1] - x[i] * x[i];
+            double b = 1.0 - x[i];
+            f += 100.0 * a * a + b * b;
+            grad[i] += -400.0 * a * x[i] - 2.0 * b;
+            grad[i + 1] += 200.0 * a;
+        }
+        return f;
+    };
+    Eigen::VectorXd x0 = Eigen::VectorXd::Constant(n, -0.5);
+    std::vector<std::pair<double, double>> bounds(n, {-2.0, 2.0});
+
+    for (auto _ : state)
+    {
+        MinimizeResult result = minimize(rosenbrock, x0, bounds);
+        benchmark::DoNotOptimize(result.fun);
+    }
+}
+BENCHMARK(BM_MinimizeRosenbrock)->Unit(benchmark::kMicrosecond);
+
+static void BM_MinimizeRosenbrockForwardDiff(benchmark::State &state)
+{
+    constexpr int n = 5;
+    auto rosenbrock = [](const std::array<Dual<n>, n> &x)
+    {
+        Dual<n> f;
+        for (int i = 0; i + 1 < n; ++i)
+        {
+            Dual<n> a = x[i + 1] - x[i] * x[i];
+            Dual<n> b = 1.0 - x[i];
+            f += 100.0 * a * a + b * b;
+        }
+        return f;
+    };
+    ForwardDiffObjective<n, decltype(rosenbrock)> objective{rosenbrock};
+    Eigen::Matrix<double, n, 1> x0 = Eigen::Matrix<double, n, 1>::Constant(-0.5);
+    std::vector<std::pair<double, double>> bounds(n, {-2.0, 2.0});
+    LBFGSWorkspace<n> workspace;
+
+    for (auto _ : state)
+    {
+        StaticMinimizeResult<n> result = minimize_lbfgs(objective, x0, bounds, workspace);
+        benchmark::DoNotOptimize(result.fun);
+    }
+}
+BENCHMARK(BM_MinimizeRosenbrockForwardDiff)->Unit(benchmark::kMicrosecond);
+
+static void BM_Interp1d(benchmark::State &state)
+{
+    Eigen::VectorXd xp = Eigen::VectorXd::LinSpaced(state.range(0), 0.0, 1.0);
+    Eigen::VectorXd fp = xp.array().sin().matrix();
+    Eigen::VectorXd x = Eigen::VectorXd::LinSpaced(800, -0.1, 1.1);
+    for (auto _ : state)
+    {
+        Eigen::VectorXd y = interp1d(x, xp, fp);
+        benchmark::DoNotOptimize(y.data());
+    }
+    state.SetItemsProcessed(state.iterations() * x.size());
+}
+BENCHMARK(BM_Interp1d)->Arg(40)->Arg(800);
+
+static void BM_Filters(benchmark::State &state)
+{
+    OptionChain chain;
+    make_synthetic_chain(static_cast<std::size_t>(state.range(0)), chain);
+    calculate_implied_volatility_baw_batch(chain.mid.data(), chain.strike.data(), chain.mid_iv.data(), chain.size(), BENCH_S, BENCH_R, BENCH_T, BENCH_Q);
+    ChainSelection selection;
+    OptionChain selected;
+
+    for (auto _ : state)
+    {
+        select_all(chain, selection);
+        refine_selection(chain, selection, all_of(strike_range(chain.strike, BENCH_S, 1.25), NonZeroBid{}));
+        refine_selection(chain, selection, MidIVAbove{0.005});
+        select_rows(chain, selection.rows, selected);
+        select_all(selected, selection);
+        refine_selection(selected, selection, OpenInterestAtLeast{100.0});
+        benchmark::DoNotOptimize(selection.rows.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Filters)->RangeMultiplier(10)->Range(20, 2000);
@@ -0,0 +1,329 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <filesystem>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "data.h"
+#include "load_env.h"
+#include "pipeline.h"
+#include "scheduler.h"
+#include "snapshot_log.h"
+#include "surface_store.h"
+#include "synthetic_chain.h"
+#include "vol_surface.h"
+
+/**
+ * @brief Stream that drops everything, so the benchmarks time the pipeline and not its logging.
+ */
+static std::ostream null_stream(nullptr);
+
+/**
+ * @brief Builds a snapshot around a chain with the benchmark pricing inputs.
+ *
+ * The pipeline benchmarks run the snapshot once before timing, so they measure the steady
+ * state of a chain that is repriced every cycle, with the RBF and RFV caches warm.
+ *
+ * @param ticker Ticker, which also keys the RBF and RFV warm-start caches.
+ * @param snapshot Receives the watch-list entry and pricing inputs; the chain is left to the caller.
+ */
+static void make_snapshot(const std::string &ticker, ChainSnapshot &snapshot)
+{
+    snapshot.timestamp_ms = 0;
+    snapshot.entry = WatchListEntry{ticker, 0, "null", OptionKind::Call, 0.25, 0.05, 100.0};
+    snapshot.S = BENCH_S;
+    snapshot.T = BENCH_T;
+    snapshot.q = BENCH_Q;
+    snapshot.r = BENCH_R;
+}
+
+static void BM_PipelineDataChain(benchmark::State &state)
+{
+    write_csv_output = false;
+    initialize_quote_data();
+
+    ChainSnapshot snapshot;
+    make_snapshot("data", snapshot);
+    load_option_chain(quote_data, snapshot.chain);
+    perform_option_interpolation(null_stream, snapshot);
+
+    for (auto _ : state)
+    {
+        perform_option_interpolation(null_stream, snapshot);
+    }
+}
+BENCHMARK(BM_PipelineDataChain)->Unit(benchmark::kMicrosecond);
+
+static void BM_PipelineSyntheticChain(benchmark::State &state)
+{
+    write_csv_output = false;
+
+    ChainSnapshot snapshot;
+    make_snapshot("synthetic" + std::to_string(state.range(0)), snapshot);
+    make_synthetic_chain(static_cast<std::size_t>(state.range(0)), snapshot.chain);
+    perform_option_interpolation(null_stream, snapshot);
+
+    for (auto _ : state)
+    {
+        perform_option_interpolation(null_stream, snapshot);
+    }
+    state.SetComplexityN(state.range(0));
+}
+BENCHMARK(BM_PipelineSyntheticChain)->Arg(20)->Arg(100)->Arg(500)->Arg(1000)->Arg(2000)->Complexity()->Unit(benchmark::kMicrosecond);
+
+static void BM_PipelineSyntheticChainTaskGraph(benchmark::State &state)
+{
+    write_csv_output = false;
+    WorkStealingPool pool(static_cast<unsigned int>(state.range(1)));
+
+    ChainSnapshot snapshot;
+    make_snapshot("graph" + std::to_string(state.range(0)), snapshot);
+    make_synthetic_chain(static_cast<std::size_t>(state.range(0)), snapshot.chain);
+    perform_option_interpolation(null_stream, snapshot, &pool);
+
+    for (auto _ : state)
+    {
+        perform_option_interpolation(null_stream, snapshot, &pool);
+    }
+}
+BENCHMARK(BM_PipelineSyntheticChainTaskGraph)->ArgNames({"strikes", "workers"})->ArgsProduct({{100, 2000}, {1, 4}})->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Builds a smile record the size of one the pipeline stores.
+ *
+ * @param strikes Number of fitted strikes.
+ * @param timestamp_ms Timestamp of the smile.
+ * @param record Receives the smile.
+ */
+static void make_smile_record(Eigen::Index strikes, std::int64_t timestamp_ms, SmileRecord &record)
+{
+    record.ticker = "store";
+    record.row = SurfaceStoreRow{timestamp_ms, 20240920, 0, BENCH_S, BENCH_T, BENCH_R, BENCH_Q, 1e-4, 400.0, 700.0, {0.2, 0.3, 0.1, 0.2, 0.1}, 0.5, 0, 0, 0, 0};
+    record.strikes = Eigen::VectorXd::LinSpaced(strikes, 400.0, 700.0);
+    record.strike_ivs = Eigen::VectorXd::Constant(strikes, 0.3);
+    record.rbf_weights = Eigen::VectorXd::Constant(strikes, 0.01);
+    record.grid_ivs = Eigen::VectorXd::Constant(800, 0.3);
+}
+
+static void BM_SurfaceStoreAppend(benchmark::State &state)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "okb_bench_surface_store";
+    std::filesystem::remove_all(directory);
+
+    {
+        SurfaceStore store;
+        store.open(directory.string());
+        SmileRecord record;
+        make_smile_record(state.range(0), 0, record);
+        for (auto _ : state)
+        {
+            ++record.row.timestamp_ms;
+            store.append(record);
+        }
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(sizeof(SurfaceStoreRow) + (3 * state.range(0) + 800) * sizeof(double)));
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_SurfaceStoreAppend)->Arg(50)->Arg(500);
+
+static void BM_SurfaceStoreQuery(benchmark::State &state)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "okb_bench_surface_store";
+    std::filesystem::remove_all(directory);
+
+    {
+        SurfaceStore store;
+        store.open(directory.string());
+        SmileRecord record;
+        make_smile_record(50, 0, record);
+        for (std::int64_t i = 0; i < state.range(0); ++i)
+        {
+            record.row.timestamp_ms = i * 1000;
+            store.append(record);
+        }
+    }
+
+    SurfaceStoreReader reader(directory.string());
+    std::vector<SmileRecord> records;
+    for (auto _ : state)
+    {
+        records.clear();
+        reader.query("store", 0, state.range(0) * 500, records);
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(records.size()));
+    std::filesystem::remove_all(directory);
+}
+BENCHMARK(BM_SurfaceStoreQuery)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+
+/**
+ * @brief Builds a smile that is flat at sigma over 21 strikes from 400 to 700, 550 among them.
+ *
+ * Both fits are flat: the RFV parameters are [sigma, 0, 0, 0, 0] and the RBF interpolates a
+ * constant, so the smile returns sigma at every fitted strike.
+ *
+ * @param sigma Implied volatility of the smile.
+ * @return std::shared_ptr<const SmileSurface> The smile.
+ */
+static std::shared_ptr<const SmileSurface> make_flat_smile(double sigma)
+{
+    SmileCoordinates coordinates = make_smile_coordinates(Eigen::VectorXd::LinSpaced(21, 400.0, 700.0));
+    Eigen::VectorXd rfv_params = Eigen::VectorXd::Zero(5);
+    rfv_params[0] = sigma;
+    auto rbf = std::make_shared<const RBFInterpolator>(coordinates.log_x_normalized, Eigen::VectorXd::Constant(21, sigma), 0.5);
+    return std::make_shared<const SmileSurface>(coordinates, rfv_params, rbf);
+}
+
+/**
+ * @brief Checks VolSurface queries against hand-computed volatilities, then times them.
+ *
+ * A surface with flat smiles of 20% at T = 0.1 and 30% at T = 0.5 is published and read back
+ * through current_vol_surface. Between the expiries the total variance is linear in T, so at
+ * T = 0.3 it is 0.2^2 * 0.1 + 0.5 * (0.3^2 * 0.5 - 0.2^2 * 0.1) = 0.0245; outside them the
+ * nearest smile holds. A second surface starting at a slice with T = -0.1 (of a kind the
+ * quote book never lists) makes the interpolated variance negative at T = 0.01, where the
+ * surface must return 0.
+ */
+static void BM_VolSurfaceImpliedVolatility(benchmark::State &state)
+{
+    auto published = std::make_shared<VolSurface>("volsurface", OptionKind::Call, BENCH_S);
+    published->add_slice(20240920, 0.5, make_flat_smile(0.3));
+    published->add_slice(20240816, 0.1, make_flat_smile(0.2));
+    publish_vol_surface(published);
+    std::shared_ptr<const VolSurface> surface = current_vol_surface("volsurface", OptionKind::Call);
+
+    VolSurface negative("volsurface", OptionKind::Put, BENCH_S);
+    negative.add_slice(20240801, -0.1, make_flat_smile(0.3));
+    negative.add_slice(20240816, 0.1, make_flat_smile(0.1));
+
+    struct Check
+    {
+        const VolSurface *surface;
+        double strike;
+        double T;
+        double expected;
+    };
+    const Check checks[] = {
+        {surface.get(), 550.0, 0.3, std::sqrt(0.0245 / 0.3)},
+        {surface.get(), 550.0, 0.05, 0.2},
+        {surface.get(), 550.0, 1.0, 0.3},
+        {surface.get(), 300.0, 0.05, 0.2},
+        {&negative, 550.0, 0.01, 0.0},
+    };
+    for (const Check &check : checks)
+    {
+        double sigma = check.surface ? check.surface->implied_volatility(check.strike, check.T) : -1.0;
+        if (!(std::abs(sigma - check.expected) < 1e-9))
+        {
+            state.SkipWithError(("implied_volatility(" + std::to_string(check.strike) + ", " + std::to_string(check.T) + ") = " +
+                                 std::to_string(sigma) + ", expected " + std::to_string(check.expected))
+                                    .c_str());
+            return;
+        }
+    }
+
+    Eigen::VectorXd strikes = Eigen::VectorXd::LinSpaced(64, 350.0, 750.0);
+    Eigen::VectorXd times = Eigen::VectorXd::LinSpaced(64, 0.01, 1.0);
+    for (auto _ : state)
+    {
+        double sum = 0.0;
+        for (Eigen::Index i = 0; i < strikes.size(); ++i)
+        {
+            sum += surface->implied_volatility(strikes[i], times[i]);
+        }
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * strikes.size());
+}
+BENCHMARK(BM_VolSurfaceImpliedVolatility);
+
+/**
+ * @brief Whether two snapshots hold the same inputs, compared bit for bit. IV columns are not stored.
+ *
+ * @param a First snapshot.
+ * @param b Second snapshot.
+ * @return bool True if every stored field matches.
+ */
+static bool same_snapshot(const ChainSnapshot &a, const ChainSnapshot &b)
+{
+    return a.timestamp_ms == b.timestamp_ms && a.entry.ticker == b.entry.ticker && a.entry.date_index == b.entry.date_index &&
+           a.entry.date == b.entry.date && a.entry.option_kind == b.entry.option_kind && a.entry.min_overpriced == b.entry.min_overpriced &&
+           a.entry.min_underpriced == b.entry.min_underpriced && a.entry.min_oi == b.entry.min_oi && a.S == b.S && a.T == b.T &&
+           a.q == b.q && a.r == b.r && a.chain.strike == b.chain.strike && a.chain.bid == b.chain.bid && a.chain.ask == b.chain.ask &&
+           a.chain.mid == b.chain.mid && a.chain.open_interest == b.chain.open_interest;
+}
+
+/**
+ * @brief Encodes and decodes a snapshot, after checking the encoding and the log round-trip it exactly.
+ *
+ * The synthetic strikes are fractions of S, which no fixed-point scale represents, so they take
+ * the raw-column fallback, while bid and ask (cents), mid (half cents) and open interest are
+ * delta-encoded. A log of three records whose last one is cut short must read back as the
+ * first two, and a record missing its last byte must not decode.
+ */
+static void BM_SnapshotLogRoundTrip(benchmark::State &state)
+{
+    ChainSnapshot snapshot;
+    make_snapshot("snapshot", snapshot);
+    snapshot.timestamp_ms = 1726840800000;
+    snapshot.entry.option_kind = OptionKind::Put;
+    make_synthetic_chain(static_cast<std::size_t>(state.range(0)), snapshot.chain);
+
+    std::string encoded;
+    encode_chain_snapshot(snapshot, encoded);
+    ChainSnapshot decoded;
+    if (!decode_chain_snapshot(encoded.data(), encoded.size(), decoded) || !same_snapshot(snapshot, decoded))
+    {
+        state.SkipWithError("decode_chain_snapshot does not reproduce the encoded snapshot");
+        return;
+    }
+    if (decode_chain_snapshot(encoded.data(), encoded.size() - 1, decoded))
+    {
+        state.SkipWithError("decode_chain_snapshot accepted a truncated record");
+        return;
+    }
+
+    std::filesystem::path path = std::filesystem::temp_directory_path() / "okb_bench_snapshots.bin";
+    std::filesystem::remove(path);
+    {
+        SnapshotRecorder recorder(path.string());
+        for (int i = 0; i < 3; ++i)
+        {
+            recorder.append(snapshot);
+            ++snapshot.timestamp_ms;
+        }
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1);
+
+    int records = 0;
+    {
+        SnapshotReader reader(path.string());
+        while (reader.next(decoded))
+        {
+            snapshot.timestamp_ms = 1726840800000 + records;
+            if (!same_snapshot(snapshot, decoded))
+                break;
+            ++records;
+        }
+    }
+    std::filesystem::remove(path);
+    if (records != 2)
+    {
+        state.SkipWithError(("read " + std::to_string(records) + " intact records from a log of three with the last cut short, expected 2").c_str());
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        encode_chain_snapshot(snapshot, encoded);
+        decode_chain_snapshot(encoded.data(), encoded.size(), decoded);
+        benchmark::DoNotOptimize(decoded.chain.strike.data());
+    }
+    state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(encoded.size()));
+    state.counters["bytes_per_strike"] = static_cast<double>(encoded.size()) / static_cast<double>(state.range(0));
+}
+BENCHMARK(BM_SnapshotLogRoundTrip)->Arg(100)->Arg(2000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,50 @@
+#ifndef SYNTHETIC_CHAIN_H
+#define SYNTHETIC_CHAIN_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "models.h"
+#include "option_chain.h"
+
+/**
+ * @brief Pricing inputs of the chain in data.cpp, shared by every benchmark.
+ */
+constexpr double BENCH_S = 566.345;
+constexpr double BENCH_T = 0.015708354371353372;
+constexpr double BENCH_Q = 0.0035192;
+constexpr double BENCH_R = 0.0531;
+
+/**
+ * @brief Fills a call chain with quotes priced off a skewed smile.
+ *
+ * Strikes are evenly spaced over 70% to 130% of S. Bid and ask straddle the model price with
+ * a spread that widens with the price, rounded to cents, and every strike has open interest.
+ *
+ * @param strikes Number of strikes.
+ * @param chain Receives the chain.
+ */
+inline void make_synthetic_chain(std::size_t strikes, OptionChain &chain)
+{
+    chain.clear();
+    chain.reserve(strikes);
+
+    for (std::size_t i = 0; i < strikes; ++i)
+    {
+        double K = BENCH_S * (0.7 + 0.6 * static_cast<double>(i) / static_cast<double>(std::max<std::size_t>(strikes - 1, 1)));
+        double m = std::log(K / BENCH_S);
+        double sigma = 0.25 - 0.1 * m + 0.8 * m * m;
+        double price = baw_price<OptionKind::Call>(BENCH_S, K, BENCH_T, BENCH_R, sigma, BENCH_Q);
+        double half_spread = 0.02 + 0.01 * price;
+
+        QuoteData quote;
+        quote.bid = std::max(0.01, std::floor((price - half_spread) * 100) / 100);
+        quote.ask = std::ceil((price + half_spread) * 100) / 100;
+        quote.mid = (quote.bid + quote.ask) / 2;
+        quote.open_interest = 500.0;
+        quote.bid_IV = quote.ask_IV = quote.mid_IV = 0.0;
+        chain.push_back(K, quote);
+    }
+}
+
+#endif
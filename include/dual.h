@@ -0,0 +1,261 @@
+#ifndef DUAL_H
+#define DUAL_H
+
+#include <array>
+#include <cmath>
+#include <type_traits>
+
+/**
+ * @brief Forward-mode automatic differentiation number carrying N partial derivatives.
+ *
+ * Every operation propagates the value and its gradient with respect to N independent
+ * variables, so one evaluation of a function templated on its scalar type returns the
+ * value and all N exact partial derivatives. Comparisons only look at the value, so
+ * branches take the same path as with plain doubles.
+ *
+ * @tparam N Number of independent variables.
+ */
+template <int N>
+struct Dual
+{
+    double value;
+    std::array<double, N> grad;
+
+    /**
+     * @brief A constant: the value with a zero gradient.
+     *
+     * @param constant Value of the constant.
+     */
+    Dual(double constant = 0.0)
+        : value(constant), grad{}
+    {
+    }
+
+    /**
+     * @brief An independent variable: the value with a unit gradient in one direction.
+     *
+     * @param value Value of the variable.
+     * @param index Index of the variable, below N.
+     * @return Dual The seeded variable.
+     */
+    static Dual variable(double value, int index)
+    {
+        Dual x(value);
+        x.grad[index] = 1.0;
+        return x;
+    }
+
+    /**
+     * @brief Compound arithmetic, propagating the derivatives with the sum, product and quotient rules.
+     */
+    Dual &operator+=(const Dual &rhs)
+    {
+        value += rhs.value;
+        for (int i = 0; i < N; ++i)
+            grad[i] += rhs.grad[i];
+        return *this;
+    }
+
+    Dual &operator-=(const Dual &rhs)
+    {
+        value -= rhs.value;
+        for (int i = 0; i < N; ++i)
+            grad[i] -= rhs.grad[i];
+        return *this;
+    }
+
+    Dual &operator*=(const Dual &rhs)
+    {
+        for (int i = 0; i < N; ++i)
+            grad[i] = grad[i] * rhs.value + value * rhs.grad[i];
+        value *= rhs.value;
+        return *this;
+    }
+
+    Dual &operator/=(const Dual &rhs)
+    {
+        double inverse = 1.0 / rhs.value;
+        value /= rhs.value;
+        for (int i = 0; i < N; ++i)
+            grad[i] = (grad[i] - value * rhs.grad[i]) * inverse;
+        return *this;
+    }
+};
+
+/**
+ * @brief Whether a type is a Dual number.
+ */
+template <typename T>
+struct is_dual : std::false_type
+{
+};
+
+template <int N>
+struct is_dual<Dual<N>> : std::true_type
+{
+};
+
+/**
+ * @brief Scalar types the templated pricing and model code can be instantiated with.
+ */
+template <typename T>
+concept PricingScalar = std::is_floating_point_v<T> || is_dual<T>::value;
+
+/**
+ * @brief Value of a plain scalar.
+ *
+ * @param x Scalar.
+ * @return double The scalar itself.
+ */
+inline double value_of(double x)
+{
+    return x;
+}
+
+/**
+ * @brief Value part of a dual number.
+ *
+ * @param x Dual number.
+ * @return double Its value, without the derivatives.
+ */
+template <int N>
+inline double value_of(const Dual<N> &x)
+{
+    return x.value;
+}
+
+/**
+ * @brief Applies the chain rule for a unary function with the given value and derivative.
+ *
+ * @param x Argument.
+ * @param value f(x.value).
+ * @param derivative f'(x.value).
+ * @return Dual<N> f(x) with its gradient.
+ */
+template <int N>
+inline Dual<N> chain_rule(const Dual<N> &x, double value, double derivative)
+{
+    Dual<N> result(value);
+    for (int i = 0; i < N; ++i)
+        result.grad[i] = derivative * x.grad[i];
+    return result;
+}
+
+/**
+ * @brief Arithmetic between dual numbers and with plain constants.
+ */
+template <int N>
+inline Dual<N> operator+(Dual<N> lhs, const Dual<N> &rhs) { return lhs += rhs; }
+template <int N>
+inline Dual<N> operator-(Dual<N> lhs, const Dual<N> &rhs) { return lhs -= rhs; }
+template <int N>
+inline Dual<N> operator*(Dual<N> lhs, const Dual<N> &rhs) { return lhs *= rhs; }
+template <int N>
+inline Dual<N> operator/(Dual<N> lhs, const Dual<N> &rhs) { return lhs /= rhs; }
+
+template <int N>
+inline Dual<N> operator+(Dual<N> lhs, double rhs)
+{
+    lhs.value += rhs;
+    return lhs;
+}
+template <int N>
+inline Dual<N> operator+(double lhs, Dual<N> rhs)
+{
+    rhs.value += lhs;
+    return rhs;
+}
+template <int N>
+inline Dual<N> operator-(Dual<N> lhs, double rhs)
+{
+    lhs.value -= rhs;
+    return lhs;
+}
+template <int N>
+inline Dual<N> operator-(double lhs, const Dual<N> &rhs) { return chain_rule(rhs, lhs - rhs.value, -1.0); }
+template <int N>
+inline Dual<N> operator*(const Dual<N> &lhs, double rhs) { return chain_rule(lhs, lhs.value * rhs, rhs); }
+template <int N>
+inline Dual<N> operator*(double lhs, const Dual<N> &rhs) { return chain_rule(rhs, lhs * rhs.value, lhs); }
+template <int N>
+inline Dual<N> operator/(const Dual<N> &lhs, double rhs) { return chain_rule(lhs, lhs.value / rhs, 1.0 / rhs); }
+template <int N>
+inline Dual<N> operator/(double lhs, const Dual<N> &rhs)
+{
+    double value = lhs / rhs.value;
+    return chain_rule(rhs, value, -value / rhs.value);
+}
+template <int N>
+inline Dual<N> operator-(const Dual<N> &x) { return chain_rule(x, -x.value, -1.0); }
+
+/**
+ * @brief Comparisons, on the value only.
+ */
+template <int N>
+inline bool operator<(const Dual<N> &lhs, const Dual<N> &rhs) { return lhs.value < rhs.value; }
+template <int N>
+inline bool operator<(const Dual<N> &lhs, double rhs) { return lhs.value < rhs; }
+template <int N>
+inline bool operator<(double lhs, const Dual<N> &rhs) { return lhs < rhs.value; }
+template <int N>
+inline bool operator>(const Dual<N> &lhs, const Dual<N> &rhs) { return lhs.value > rhs.value; }
+template <int N>
+inline bool operator>(const Dual<N> &lhs, double rhs) { return lhs.value > rhs; }
+template <int N>
+inline bool operator>(double lhs, const Dual<N> &rhs) { return lhs > rhs.value; }
+template <int N>
+inline bool operator<=(const Dual<N> &lhs, const Dual<N> &rhs) { return lhs.value <= rhs.value; }
+template <int N>
+inline bool operator<=(const Dual<N> &lhs, double rhs) { return lhs.value <= rhs; }
+template <int N>
+inline bool operator<=(double lhs, const Dual<N> &rhs) { return lhs <= rhs.value; }
+template <int N>
+inline bool operator>=(const Dual<N> &lhs, const Dual<N> &rhs) { return lhs.value >= rhs.value; }
+template <int N>
+inline bool operator>=(const Dual<N> &lhs, double rhs) { return lhs.value >= rhs; }
+template <int N>
+inline bool operator>=(double lhs, const Dual<N> &rhs) { return lhs >= rhs.value; }
+
+/**
+ * @brief Elementary functions, found by argument-dependent lookup next to their std:: counterparts.
+ */
+template <int N>
+inline Dual<N> exp(const Dual<N> &x)
+{
+    double value = std::exp(x.value);
+    return chain_rule(x, value, value);
+}
+
+template <int N>
+inline Dual<N> log(const Dual<N> &x) { return chain_rule(x, std::log(x.value), 1.0 / x.value); }
+
+template <int N>
+inline Dual<N> sqrt(const Dual<N> &x)
+{
+    double value = std::sqrt(x.value);
+    return chain_rule(x, value, 0.5 / value);
+}
+
+template <int N>
+inline Dual<N> fabs(const Dual<N> &x) { return x.value < 0 ? -x : x; }
+
+template <int N>
+inline Dual<N> pow(const Dual<N> &base, double exponent)
+{
+    double value = std::pow(base.value, exponent);
+    return chain_rule(base, value, exponent * value / base.value);
+}
+
+template <int N>
+inline Dual<N> pow(const Dual<N> &base, const Dual<N> &exponent)
+{
+    double value = std::pow(base.value, exponent.value);
+    double d_base = exponent.value * value / base.value;
+    double d_exponent = value * std::log(base.value);
+    Dual<N> result(value);
+    for (int i = 0; i < N; ++i)
+        result.grad[i] = d_base * base.grad[i] + d_exponent * exponent.grad[i];
+    return result;
+}
+
+#endif
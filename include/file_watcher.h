@@ -0,0 +1,34 @@
+#ifndef FILE_WATCHER_H
+#define FILE_WATCHER_H
+
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Calls a callback on a background thread whenever a file is rewritten.
+ *
+ * On Linux the file's directory is watched with inotify, which also catches editors that
+ * save by writing a new file and renaming it over the old one. Elsewhere the modification
+ * time is polled once per second.
+ */
+class FileWatcher
+{
+public:
+    FileWatcher(const std::string &file_path, std::function<void()> on_change);
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher &) = delete;
+    FileWatcher &operator=(const FileWatcher &) = delete;
+
+private:
+    void run();
+
+    std::string file_path_;
+    std::function<void()> on_change_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+#endif
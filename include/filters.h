@@ -1,17 +1,139 @@
 #ifndef FILTERS_H
 #define FILTERS_H
 
+#include <cstddef>
+#include <tuple>
 #include <vector>
-#include <map>
-#include "data.h"
+#include "option_chain.h"
+
+/**
+ * @brief Ordered set of selected rows of an OptionChain.
+ *
+ * Filters narrow the selection in place instead of copying the chain, so one selection
+ * buffer can be reused for every chain and the chain is compacted at most once, with
+ * select_rows, after the last filter.
+ */
+struct ChainSelection
+{
+    std::vector<std::size_t> rows;
+
+    std::size_t size() const { return rows.size(); }
+    const std::size_t *data() const { return rows.data(); }
+};
+
+/**
+ * @brief Keeps strikes within [lower, upper].
+ */
+struct StrikeInRange
+{
+    double lower;
+    double upper;
+
+    bool operator()(const OptionChain &chain, std::size_t row) const
+    {
+        return (chain.strike[row] >= lower) & (chain.strike[row] <= upper);
+    }
+};
+
+/**
+ * @brief Keeps quotes with a non-zero bid.
+ */
+struct NonZeroBid
+{
+    bool operator()(const OptionChain &chain, std::size_t row) const
+    {
+        return chain.bid[row] != 0.0;
+    }
+};
+
+/**
+ * @brief Keeps quotes whose mid IV is above a threshold.
+ */
+struct MidIVAbove
+{
+    double threshold;
+
+    bool operator()(const OptionChain &chain, std::size_t row) const
+    {
+        return chain.mid_iv[row] > threshold;
+    }
+};
+
+/**
+ * @brief Keeps quotes whose open interest is at least a minimum.
+ */
+struct OpenInterestAtLeast
+{
+    double minimum;
+
+    bool operator()(const OptionChain &chain, std::size_t row) const
+    {
+        return chain.open_interest[row] >= minimum;
+    }
+};
+
+/**
+ * @brief Conjunction of several row predicates, evaluated without short-circuiting.
+ *
+ * @tparam Predicates Row predicate types.
+ */
+template <typename... Predicates>
+struct AllOf
+{
+    std::tuple<Predicates...> predicates;
+
+    bool operator()(const OptionChain &chain, std::size_t row) const
+    {
+        return std::apply([&](const Predicates &...predicate)
+                          { return (true & ... & predicate(chain, row)); },
+                          predicates);
+    }
+};
+
+/**
+ * @brief Combines row predicates so that a single pass applies all of them.
+ *
+ * @param predicates Row predicates.
+ * @return AllOf<Predicates...> Predicate keeping the rows every predicate keeps.
+ */
+template <typename... Predicates>
+AllOf<Predicates...> all_of(Predicates... predicates)
+{
+    return AllOf<Predicates...>{std::tuple<Predicates...>(predicates...)};
+}
+
+/**
+ * @brief Narrows a selection to the rows a predicate keeps, preserving their order.
+ *
+ * Every row is written unconditionally and the output position only advances when the row
+ * is kept, so the loop has no data-dependent branch.
+ *
+ * @tparam Predicate Callable with signature bool(const OptionChain &, std::size_t row).
+ * @param chain Chain the selection refers to.
+ * @param selection Selection to narrow.
+ * @param keep Predicate deciding which rows stay.
+ */
+template <typename Predicate>
+void refine_selection(const OptionChain &chain, ChainSelection &selection, Predicate keep)
+{
+    std::size_t kept = 0;
+    std::size_t *rows = selection.rows.data();
+    std::size_t count = selection.rows.size();
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        std::size_t row = rows[i];
+        rows[kept] = row;
+        kept += static_cast<std::size_t>(keep(chain, row));
+    }
+    selection.rows.resize(kept);
+}
 
 double calculate_standard_deviation(const std::vector<double> &strikes);
-std::vector<double> filter_strikes(
+StrikeInRange strike_range(
     const std::vector<double> &strikes,
     double S,
     double num_stdev = 1.25,
     bool two_sigma_move = false);
-std::map<double, QuoteData> filter_by_bid_price(const std::map<double, QuoteData> &data);
-std::map<double, QuoteData> filter_by_mid_iv(const std::map<double, QuoteData> &data);
+void select_all(const OptionChain &chain, ChainSelection &selection);
 
 #endif
@@ -1,10 +1,72 @@
 #ifndef FRED_H
 #define FRED_H
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
 #include <string>
+#include <thread>
 
-extern double risk_free_rate;
+/**
+ * @brief Latest risk-free rate (SOFR, as a fraction), published by the RiskFreeRateService.
+ */
+extern std::atomic<double> risk_free_rate;
 
-void fetch_risk_free_rate(const std::string &api_key);
+/**
+ * @brief Settings of the risk-free rate service.
+ */
+struct RateServiceConfig
+{
+    std::string api_key;
+    std::string base_url = "https://api.stlouisfed.org";
+    std::string cache_file;
+    std::chrono::milliseconds refresh_interval = std::chrono::hours(1);
+};
+
+/**
+ * @brief One SOFR observation.
+ */
+struct RateObservation
+{
+    double rate;
+    std::string date;
+};
+
+bool fetch_risk_free_rate(const std::string &base_url, const std::string &api_key, RateObservation &observation, const std::atomic<bool> *cancel = nullptr);
+
+/**
+ * @brief Keeps risk_free_rate up to date from FRED without blocking startup.
+ *
+ * The last good observation is persisted to a cache file and published as soon as the service
+ * starts. A background thread then fetches the latest SOFR observation right away and again
+ * on every refresh interval (sooner after a failed request), publishes it and updates the cache.
+ */
+class RiskFreeRateService
+{
+public:
+    explicit RiskFreeRateService(RateServiceConfig config);
+    ~RiskFreeRateService();
+
+    RiskFreeRateService(const RiskFreeRateService &) = delete;
+    RiskFreeRateService &operator=(const RiskFreeRateService &) = delete;
+
+    bool wait_for_rate(std::chrono::milliseconds timeout);
+
+private:
+    bool refresh();
+    bool load_cache();
+    void save_cache(const RateObservation &observation) const;
+    void publish(const RateObservation &observation, const char *source);
+
+    RateServiceConfig config_;
+    std::string last_date_;
+    std::atomic<bool> stopping_;
+    std::mutex mutex_;
+    std::condition_variable stop_;
+    std::condition_variable rate_ready_;
+    bool has_rate_;
+    std::thread thread_;
+};
 
 #endif
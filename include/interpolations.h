@@ -3,20 +3,87 @@
 
 #include <Eigen/Dense>
 #include <functional>
+#include <memory>
+#include <string>
+
+class RBFInterpolator;
+
+/**
+ * @brief Work done by one RFV fit, summed over the warm-started and cold attempts.
+ */
+struct RFVFitStats
+{
+    int nfev;
+    int nit;
+};
+
+/**
+ * @brief Counters describing how often RFV fits were warm-started from cached parameters.
+ */
+struct RFVWarmStartStats
+{
+    long long hits;
+    long long misses;
+    long long fallbacks;
+    long long iterations_saved;
+};
 
 std::function<Eigen::VectorXd(const Eigen::VectorXd &)> rbf_model(
     const Eigen::VectorXd &k,
     const Eigen::VectorXd &y,
     double epsilon);
 
+std::function<Eigen::VectorXd(const Eigen::VectorXd &)> rbf_model(
+    const Eigen::VectorXd &k,
+    const Eigen::VectorXd &y,
+    double epsilon,
+    const std::string &cache_key);
+
+std::shared_ptr<const RBFInterpolator> fit_rbf(
+    const Eigen::VectorXd &k,
+    const Eigen::VectorXd &y,
+    double epsilon,
+    const std::string &cache_key);
+
+/**
+ * @brief Computes the Rational Function Volatility (RFV) model value at a single point.
+ *
+ * Generic over the parameter scalar: with std::array<Dual<5>, 5> parameters the value also
+ * carries its exact derivatives with respect to [a, b, c, d, e].
+ *
+ * @tparam Params Indexable parameter vector [a, b, c, d, e].
+ * @param k Log-moneyness.
+ * @param params Parameter vector [a, b, c, d, e] for the RFV model.
+ * @return The computed RFV model value, in the scalar type of the parameters.
+ */
+template <typename Params>
+inline auto rfv_model(double k, const Params &params)
+{
+    auto numerator = params[0] + params[1] * k + params[2] * k * k;
+    auto denominator = 1.0 + params[3] * k + params[4] * k * k;
+    return numerator / denominator;
+}
+
+double rfv_model(double k, const Eigen::VectorXd &params);
+
 Eigen::VectorXd rfv_model(
     const Eigen::VectorXd &k,
     const Eigen::VectorXd &params);
 
 Eigen::VectorXd fit_model(
-    const Eigen::VectorXd &x,
-    const Eigen::VectorXd &y_mid,
-    const Eigen::VectorXd &y_bid,
-    const Eigen::VectorXd &y_ask);
+    const Eigen::Ref<const Eigen::VectorXd> &x,
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_bid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_ask);
+
+Eigen::VectorXd fit_model(
+    const Eigen::Ref<const Eigen::VectorXd> &x,
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_bid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_ask,
+    const std::string &cache_key,
+    RFVFitStats *fit_stats = nullptr);
+
+RFVWarmStartStats get_rfv_warm_start_stats();
 
 #endif
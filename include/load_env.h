@@ -10,6 +10,25 @@ extern std::string account_hash;
 extern std::string fred_api_key;
 extern bool dry_run;
 extern int time_to_rest;
+extern bool write_csv_output;
+extern int num_workers;
+extern int job_deadline_ms;
+extern std::string stream_url;
+extern std::string stream_access_token;
+extern std::string stream_customer_id;
+extern std::string stream_correl_id;
+extern std::string stream_option_symbols;
+extern std::string stream_record_file;
+extern std::string snapshot_file;
+extern std::string metrics_file;
+extern int metrics_interval_ms;
+extern std::string trace_file;
+extern std::string output_dir;
+extern std::string output_format;
+extern std::string surface_store_dir;
+extern std::string fred_url;
+extern std::string rate_cache_file;
+extern int rate_refresh_ms;
 
 void load_env_file(const std::string &file_path);
 
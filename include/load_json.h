@@ -1,22 +1,31 @@
 #ifndef LOAD_JSON_H
 #define LOAD_JSON_H
 
+#include <memory>
 #include <string>
+#include <vector>
+#include "models.h"
 
-struct StockNode
+/**
+ * @brief One (ticker, expiry, option type) entry of the watch list, parsed once at load.
+ */
+struct WatchListEntry
 {
     std::string ticker;
-    std::string date_index;
+    int date_index;
     std::string date;
-    std::string option_type;
-    std::string min_overpriced;
-    std::string min_underpriced;
-    std::string min_oi;
-    StockNode *next;
+    OptionKind option_kind;
+    double min_overpriced;
+    double min_underpriced;
+    double min_oi;
 };
 
-extern StockNode *stocks_data_head;
+using WatchList = std::vector<WatchListEntry>;
 
-void load_json_file(const std::string &file_path);
+std::shared_ptr<const WatchList> parse_watch_list(const std::string &file_path);
+
+bool load_json_file(const std::string &file_path);
+
+std::shared_ptr<const WatchList> current_watch_list();
 
 #endif
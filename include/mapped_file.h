@@ -0,0 +1,47 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief A file mapped into memory, read-only or growable for appending.
+ *
+ * A writable mapping is resized with resize(), which extends the file and remaps it, so
+ * pointers returned by data() are invalidated by every resize.
+ */
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &file_path, bool writable);
+    bool resize(std::size_t size);
+    void close();
+
+    bool is_open() const { return open_; }
+    char *data() { return data_; }
+    const char *data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    bool map();
+    void unmap();
+
+#ifdef _WIN32
+    void *file_;
+    void *mapping_;
+#else
+    int fd_;
+#endif
+    char *data_;
+    std::size_t size_;
+    bool writable_;
+    bool open_;
+};
+
+#endif
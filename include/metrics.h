@@ -0,0 +1,150 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Timed stages of perform_option_interpolation, in pipeline order.
+ */
+enum class PipelineStage
+{
+    StrikeFilter,
+    IVSolve,
+    IVFilter,
+    RBFBuild,
+    RFVFit,
+    GridEval,
+    MispricingScan,
+    CSVWrite,
+    Total
+};
+
+constexpr std::size_t PIPELINE_STAGE_COUNT = static_cast<std::size_t>(PipelineStage::Total) + 1;
+
+const char *pipeline_stage_name(PipelineStage stage);
+
+/**
+ * @brief Lock-free log-linear latency histogram in the style of HdrHistogram.
+ *
+ * Values below 128 ns get one bucket each; every power of two above that is split into 64
+ * linear buckets, so any recorded value is reported within 1.6% of its true value. Values
+ * beyond 2^40 ns (about 18 minutes) are clamped. Recording is a few relaxed atomic
+ * increments, so any number of threads can record while another one reads.
+ */
+class LatencyHistogram
+{
+public:
+    LatencyHistogram();
+
+    void record(std::uint64_t nanoseconds);
+    std::uint64_t count() const;
+    std::uint64_t sum() const;
+    std::uint64_t max() const;
+    std::uint64_t percentile(double percent) const;
+
+private:
+    static constexpr int LINEAR_BITS = 7;
+    static constexpr int MAX_VALUE_BITS = 40;
+    static constexpr std::size_t SUB_BUCKETS = std::size_t{1} << (LINEAR_BITS - 1);
+    static constexpr std::size_t BUCKET_COUNT = (std::size_t{1} << LINEAR_BITS) + (MAX_VALUE_BITS - LINEAR_BITS) * SUB_BUCKETS;
+
+    static std::size_t bucket_index(std::uint64_t value);
+    static std::uint64_t bucket_upper_bound(std::size_t index);
+
+    std::array<std::atomic<std::uint64_t>, BUCKET_COUNT> buckets_;
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> sum_;
+    std::atomic<std::uint64_t> max_;
+};
+
+/**
+ * @brief Latency histograms and work counters of one ticker.
+ */
+struct TickerMetrics
+{
+    std::array<LatencyHistogram, PIPELINE_STAGE_COUNT> stages;
+    std::atomic<std::uint64_t> runs{0};
+    std::atomic<std::uint64_t> iv_evaluations{0};
+    std::atomic<std::uint64_t> rfv_nfev{0};
+    std::atomic<std::uint64_t> rfv_nit{0};
+};
+
+TickerMetrics &ticker_metrics(const std::string &ticker);
+
+void write_metrics_prometheus(std::ostream &out);
+
+/**
+ * @brief Times consecutive pipeline stages with one clock read per stage.
+ */
+class StageClock
+{
+public:
+    explicit StageClock(TickerMetrics &metrics);
+    StageClock(TickerMetrics &metrics, std::chrono::steady_clock::duration elapsed);
+
+    void lap(PipelineStage stage);
+    void restart();
+    void finish();
+    std::chrono::steady_clock::duration elapsed() const;
+
+private:
+    TickerMetrics &metrics_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point lap_start_;
+};
+
+/**
+ * @brief Times one stage over the lifetime of a scope, for stages that run concurrently.
+ */
+class StageTimer
+{
+public:
+    StageTimer(TickerMetrics &metrics, PipelineStage stage);
+    ~StageTimer();
+
+    StageTimer(const StageTimer &) = delete;
+    StageTimer &operator=(const StageTimer &) = delete;
+
+private:
+    TickerMetrics &metrics_;
+    PipelineStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief Periodically writes every ticker's metrics to a file in Prometheus text format.
+ *
+ * The file is replaced atomically (written to a temporary file and renamed), so it can be
+ * served by node_exporter's textfile collector or read at any time. A final dump is written
+ * on destruction.
+ */
+class MetricsDumper
+{
+public:
+    MetricsDumper(const std::string &file_path, std::chrono::milliseconds interval);
+    ~MetricsDumper();
+
+    MetricsDumper(const MetricsDumper &) = delete;
+    MetricsDumper &operator=(const MetricsDumper &) = delete;
+
+private:
+    void dump() const;
+
+    std::string file_path_;
+    std::chrono::milliseconds interval_;
+    std::mutex mutex_;
+    std::condition_variable stop_;
+    bool stopping_;
+    std::thread thread_;
+};
+
+#endif
@@ -2,9 +2,15 @@
 #define MINIMIZE_H
 
 #include <Eigen/Dense>
+#include <algorithm>
+#include <array>
+#include <cmath>
 #include <functional>
+#include <limits>
 #include <string>
 #include <vector>
+#include "dual.h"
+#include "trace.h"
 
 struct MinimizeResult
 {
@@ -16,6 +22,292 @@ struct MinimizeResult
     std::string message;
 };
 
+/**
+ * @brief Result of minimize_lbfgs, sized at compile time like the problem itself.
+ *
+ * @tparam N Problem dimension, or Eigen::Dynamic.
+ */
+template <int N>
+struct StaticMinimizeResult
+{
+    Eigen::Matrix<double, N, 1> x;
+    double fun;
+    int nfev;
+    int nit;
+    int status;
+    const char *message;
+};
+
+/**
+ * @brief Reusable storage for minimize_lbfgs.
+ *
+ * Holds the curvature pairs in a fixed ring buffer together with every vector used by an
+ * iteration, so that once the workspace has been sized for a problem, running the optimizer
+ * performs no heap allocations. For a fixed N nothing is ever allocated.
+ *
+ * @tparam N Problem dimension, or Eigen::Dynamic.
+ * @tparam M Number of curvature pairs kept.
+ */
+template <int N, int M = 10>
+struct LBFGSWorkspace
+{
+    using Vector = Eigen::Matrix<double, N, 1>;
+
+    std::array<Vector, M> s;
+    std::array<Vector, M> y;
+    std::array<double, M> rho;
+    std::array<double, M> alpha;
+    Vector x;
+    Vector grad;
+    Vector q;
+    Vector p;
+    Vector x_new;
+    Vector grad_new;
+    int oldest = 0;
+    int count = 0;
+
+    /**
+     * @brief Sizes every vector for an n-dimensional problem and clears the history.
+     *
+     * Dynamic-size vectors are only reallocated when n changes.
+     *
+     * @param n Problem dimension.
+     */
+    void reset(Eigen::Index n)
+    {
+        if constexpr (N == Eigen::Dynamic)
+        {
+            if (x.size() != n)
+            {
+                for (int i = 0; i < M; ++i)
+                {
+                    s[i].resize(n);
+                    y[i].resize(n);
+                }
+                x.resize(n);
+                grad.resize(n);
+                q.resize(n);
+                p.resize(n);
+                x_new.resize(n);
+                grad_new.resize(n);
+            }
+        }
+        oldest = 0;
+        count = 0;
+    }
+};
+
+/**
+ * @brief Perform bound-constrained minimization using the L-BFGS-B algorithm without heap allocations.
+ *
+ * Same algorithm as minimize, with the objective passed by type so it can be inlined and all
+ * iteration state kept in a caller-owned workspace.
+ *
+ * @tparam N Problem dimension, or Eigen::Dynamic.
+ * @tparam M Number of curvature pairs kept.
+ * @tparam FuncGrad Callable with signature double(const Vector &x, Vector &grad).
+ * @param func_grad Function that computes the objective function and its gradient.
+ * @param x0 Initial guess for the variables.
+ * @param bounds Vector of pairs specifying the lower and upper bounds for each variable.
+ * @param workspace Reusable iteration storage.
+ * @param maxiter Maximum number of iterations allowed.
+ * @param ftol Relative tolerance for the function value convergence criterion.
+ * @param gtol Tolerance for the gradient norm convergence criterion.
+ * @return StaticMinimizeResult<N> Structure containing the optimization results.
+ */
+template <int N, int M, typename FuncGrad>
+StaticMinimizeResult<N> minimize_lbfgs(
+    FuncGrad &func_grad,
+    const Eigen::Matrix<double, N, 1> &x0,
+    const std::vector<std::pair<double, double>> &bounds,
+    LBFGSWorkspace<N, M> &workspace,
+    int maxiter = 15000,
+    double ftol = 1e-8,
+    double gtol = 1e-5)
+{
+    LBFGSWorkspace<N, M> &ws = workspace;
+    Eigen::Index n = x0.size();
+    ws.reset(n);
+
+    ws.x = x0;
+    double f = func_grad(ws.x, ws.grad);
+
+    int iter = 0;
+    int nfev = 1;
+    int status = 0;
+    const char *message = "Optimization terminated successfully.";
+    double prev_f = f;
+
+    while (iter < maxiter)
+    {
+        TRACE_SCOPE("lbfgs_iteration");
+        ws.q = ws.grad;
+
+        for (int i = ws.count - 1; i >= 0; --i)
+        {
+            int slot = (ws.oldest + i) % M;
+            ws.alpha[slot] = ws.rho[slot] * ws.s[slot].dot(ws.q);
+            ws.q -= ws.alpha[slot] * ws.y[slot];
+        }
+
+        for (int i = 0; i < ws.count; ++i)
+        {
+            int slot = (ws.oldest + i) % M;
+            double beta = ws.rho[slot] * ws.y[slot].dot(ws.q);
+            ws.q += ws.s[slot] * (ws.alpha[slot] - beta);
+        }
+
+        ws.p = -ws.q;
+
+        for (Eigen::Index i = 0; i < n; ++i)
+        {
+            if (bounds[i].first == bounds[i].second)
+            {
+                ws.p[i] = 0.0;
+            }
+            else
+            {
+                if (ws.x[i] <= bounds[i].first && ws.p[i] < 0)
+                    ws.p[i] = 0.0;
+                if (ws.x[i] >= bounds[i].second && ws.p[i] > 0)
+                    ws.p[i] = 0.0;
+            }
+        }
+
+        double alpha_step = 1.0;
+        double c1 = 1e-4;
+        double c2 = 0.9;
+        int max_linesearch = 20;
+        bool success = false;
+        double f_new = f;
+        double grad_dot_p = ws.grad.dot(ws.p);
+        {
+            TRACE_SCOPE("lbfgs_line_search");
+            for (int ls_iter = 0; ls_iter < max_linesearch; ++ls_iter)
+            {
+                ws.x_new.noalias() = ws.x + alpha_step * ws.p;
+
+                for (Eigen::Index i = 0; i < n; ++i)
+                {
+                    if (bounds[i].first > -std::numeric_limits<double>::infinity())
+                        ws.x_new[i] = std::max(ws.x_new[i], bounds[i].first);
+                    if (bounds[i].second < std::numeric_limits<double>::infinity())
+                        ws.x_new[i] = std::min(ws.x_new[i], bounds[i].second);
+                }
+
+                f_new = func_grad(ws.x_new, ws.grad_new);
+                nfev++;
+
+                if (f_new <= f + c1 * alpha_step * grad_dot_p)
+                {
+                    if (ws.grad_new.dot(ws.p) >= c2 * grad_dot_p)
+                    {
+                        success = true;
+                        break;
+                    }
+                }
+
+                alpha_step *= 0.5;
+            }
+        }
+
+        if (!success)
+        {
+            status = 1;
+            message = "Line search failed.";
+            break;
+        }
+
+        double ys = (ws.grad_new - ws.grad).dot(ws.x_new - ws.x);
+        if (ys > 1e-10)
+        {
+            int slot;
+            if (ws.count == M)
+            {
+                slot = ws.oldest;
+                ws.oldest = (ws.oldest + 1) % M;
+            }
+            else
+            {
+                slot = (ws.oldest + ws.count) % M;
+                ws.count++;
+            }
+            ws.s[slot] = ws.x_new - ws.x;
+            ws.y[slot] = ws.grad_new - ws.grad;
+            ws.rho[slot] = 1.0 / ys;
+        }
+
+        ws.x.swap(ws.x_new);
+        ws.grad.swap(ws.grad_new);
+        f = f_new;
+
+        if (ws.grad.cwiseAbs().maxCoeff() < gtol)
+        {
+            status = 0;
+            message = "Optimization terminated successfully (gtol).";
+            break;
+        }
+
+        if (std::abs(f - prev_f) < ftol * (1.0 + std::abs(f)))
+        {
+            status = 0;
+            message = "Optimization terminated successfully (ftol).";
+            break;
+        }
+
+        prev_f = f;
+        iter++;
+    }
+
+    if (iter >= maxiter)
+    {
+        status = 1;
+        message = "Maximum number of iterations exceeded.";
+    }
+
+    StaticMinimizeResult<N> result;
+    result.x = ws.x;
+    result.fun = f;
+    result.nfev = nfev;
+    result.nit = iter;
+    result.status = status;
+    result.message = message;
+
+    return result;
+}
+
+/**
+ * @brief Objective for minimize_lbfgs whose gradient comes from forward-mode automatic differentiation.
+ *
+ * The wrapped function is written once, generic over its scalar type, and evaluated with
+ * Dual<N> variables, so a single call returns the value and the exact gradient without
+ * hand-derived derivative code.
+ *
+ * @tparam N Problem dimension.
+ * @tparam Func Callable taking const std::array<Dual<N>, N> & and returning Dual<N>.
+ */
+template <int N, typename Func>
+struct ForwardDiffObjective
+{
+    Func func;
+
+    double operator()(const Eigen::Matrix<double, N, 1> &x, Eigen::Matrix<double, N, 1> &grad)
+    {
+        std::array<Dual<N>, N> variables;
+        for (int i = 0; i < N; ++i)
+        {
+            variables[i] = Dual<N>::variable(x[i], i);
+        }
+
+        Dual<N> f = func(variables);
+        for (int i = 0; i < N; ++i)
+        {
+            grad[i] = f.grad[i];
+        }
+        return f.value;
+    }
+};
+
 MinimizeResult minimize(
     const std::function<double(const Eigen::VectorXd &, Eigen::VectorXd &)> &func_grad,
     const Eigen::VectorXd &x0,
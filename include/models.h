@@ -1,7 +1,355 @@
 #ifndef MODELS_H
 #define MODELS_H
 
+#include <cmath>
+#include <cstddef>
 #include <string>
+#include "dual.h"
+
+/**
+ * @brief Option type, resolved once from the "calls"/"puts" configuration strings.
+ */
+enum class OptionKind
+{
+    Call,
+    Put
+};
+
+/**
+ * @brief Pricing inputs shared by every strike of a single option chain.
+ *
+ * The exponentials, square root and logarithm only depend on the chain, so they
+ * are computed once by make_chain_pricing_constants instead of on every pricing call.
+ */
+struct ChainPricingConstants
+{
+    double S;
+    double r;
+    double T;
+    double q;
+    double sqrt_T;
+    double log_S;
+    double discount_r;
+    double discount_q;
+};
+
+/**
+ * @brief Price and first-order sensitivities of one option.
+ *
+ * Theta is the change in value per year of calendar time (divide by 365 for a daily theta).
+ */
+struct OptionGreeks
+{
+    double price;
+    double delta;
+    double gamma;
+    double vega;
+    double theta;
+};
+
+/**
+ * @brief Price of one option and its exact first-order sensitivities to every pricing input.
+ *
+ * Computed by forward-mode automatic differentiation through the Barone-Adesi Whaley price.
+ * Like baw_greeks these are European sensitivities: with the q2 root the pricer uses, the
+ * early-exercise premium is never applied, so the price is the European one.
+ * Theta is the change in value per year of calendar time (divide by 365 for a daily theta).
+ */
+struct OptionSensitivities
+{
+    double price;
+    double delta;
+    double vega;
+    double rho;
+    double theta;
+    double dividend_rho;
+};
+
+/**
+ * @brief Root finder used to solve implied volatilities.
+ */
+enum class IVSolverMode
+{
+    Bisection,
+    Newton
+};
+
+OptionKind parse_option_kind(const std::string &option_type);
+const char *option_kind_name(OptionKind kind);
+
+ChainPricingConstants make_chain_pricing_constants(double S, double r, double T, double q = 0.0);
+
+/**
+ * @brief Approximation of the error function (erf) using a high-precision method.
+ *
+ * @tparam Scalar double, or a Dual number to propagate derivatives.
+ * @param x The input value for which the error function is to be calculated.
+ * @return Scalar The calculated error function value.
+ */
+template <PricingScalar Scalar>
+inline Scalar approx_erf(Scalar x)
+{
+    using std::exp;
+    using std::fabs;
+
+    const double a1 = 0.254829592;
+    const double a2 = -0.284496736;
+    const double a3 = 1.421413741;
+    const double a4 = -1.453152027;
+    const double a5 = 1.061405429;
+    const double p = 0.3275911;
+
+    double sign = (x >= 0) ? 1.0 : -1.0;
+    x = fabs(x);
+
+    Scalar t = 1.0 / (1.0 + p * x);
+    Scalar y = 1.0 - (((((a5 * t + a4) * t + a3) * t + a2) * t + a1) * t * exp(-x * x));
+
+    return sign * y;
+}
+
+/**
+ * @brief Approximation of the cumulative distribution function (CDF) for a standard normal distribution.
+ *
+ * @tparam Scalar double, or a Dual number to propagate derivatives.
+ * @param x The input value for which the CDF is to be calculated.
+ * @return Scalar The CDF value.
+ */
+template <PricingScalar Scalar>
+inline Scalar normal_cdf(Scalar x)
+{
+    return 0.5 * (1.0 + approx_erf(x / std::sqrt(2.0)));
+}
+
+/**
+ * @brief Standard normal probability density function.
+ *
+ * @tparam Scalar double, or a Dual number to propagate derivatives.
+ * @param x The input value.
+ * @return Scalar The density value.
+ */
+template <PricingScalar Scalar>
+inline Scalar normal_pdf(Scalar x)
+{
+    using std::exp;
+
+    return 0.3989422804014327 * exp(-0.5 * x * x);
+}
+
+/**
+ * @brief Early-exercise part of the Barone-Adesi Whaley price.
+ *
+ * @tparam Kind Option type.
+ * @tparam Scalar double, or a Dual number to propagate derivatives.
+ * @param S Current stock price.
+ * @param K Strike price of the option.
+ * @param q2 Root of the BAW characteristic equation.
+ * @param european_price European price of the option.
+ * @return Scalar The American option price.
+ */
+template <OptionKind Kind, PricingScalar Scalar>
+inline Scalar baw_early_exercise_price(const Scalar &S, const Scalar &K, const Scalar &q2, const Scalar &european_price)
+{
+    using std::pow;
+
+    if constexpr (Kind == OptionKind::Call)
+    {
+        Scalar S_critical = K / (1 - 1 / q2);
+        if (S >= S_critical)
+            return S - K;
+        Scalar A2 = (S_critical - K) * pow(S_critical, -q2);
+        return european_price + A2 * pow(S / S_critical, q2);
+    }
+    else
+    {
+        Scalar S_critical = K / (1 + 1 / q2);
+        if (S <= S_critical)
+            return K - S;
+        Scalar A2 = (K - S_critical) * pow(S_critical, -q2);
+        return european_price + A2 * pow(S / S_critical, q2);
+    }
+}
+
+/**
+ * @brief Barone-Adesi Whaley price from precomputed chain constants.
+ *
+ * @tparam Kind Option type.
+ * @param c Chain-level pricing constants.
+ * @param K Strike price of the option.
+ * @param log_K Natural logarithm of the strike price.
+ * @param sigma Implied volatility.
+ * @return double The calculated option price.
+ */
+template <OptionKind Kind>
+inline double baw_price(const ChainPricingConstants &c, double K, double log_K, double sigma)
+{
+    constexpr double sign = Kind == OptionKind::Call ? 1.0 : -1.0;
+
+    double sigma2 = sigma * sigma;
+    double M = 2 * (c.r - c.q) / sigma2;
+    double n = 2 * (c.r - c.q - 0.5 * sigma2) / sigma2;
+    double q2 = (-(n - 1) - std::sqrt((n - 1) * (n - 1) + 4 * M)) / 2;
+
+    double sigma_sqrt_T = sigma * c.sqrt_T;
+    double d1 = (c.log_S - log_K + (c.r - c.q + 0.5 * sigma2) * c.T) / sigma_sqrt_T;
+    double d2 = d1 - sigma_sqrt_T;
+
+    double european_price = sign * (c.S * c.discount_q * normal_cdf(sign * d1) - K * c.discount_r * normal_cdf(sign * d2));
+    if (c.q >= c.r || q2 < 0)
+        return european_price;
+    return baw_early_exercise_price<Kind>(c.S, K, q2, european_price);
+}
+
+/**
+ * @brief Barone-Adesi Whaley price and greeks from precomputed chain constants, in one pass.
+ *
+ * The derivatives are analytic and share d1, d2, the normal terms and the discounted spot
+ * and strike, so the cost is close to a single baw_price call. These are the European greeks:
+ * with the q2 root baw_price uses, r > q gives q2 < 0 and r <= q returns early, so the
+ * early-exercise premium is never applied and the price is the European one, as here.
+ *
+ * @tparam Kind Option type.
+ * @param c Chain-level pricing constants.
+ * @param K Strike price of the option.
+ * @param log_K Natural logarithm of the strike price.
+ * @param sigma Implied volatility.
+ * @return OptionGreeks The price, delta, gamma, vega and theta of the option.
+ */
+template <OptionKind Kind>
+inline OptionGreeks baw_greeks(const ChainPricingConstants &c, double K, double log_K, double sigma)
+{
+    constexpr double sign = Kind == OptionKind::Call ? 1.0 : -1.0;
+
+    double sigma_sqrt_T = sigma * c.sqrt_T;
+    double d1 = (c.log_S - log_K + (c.r - c.q + 0.5 * sigma * sigma) * c.T) / sigma_sqrt_T;
+    double d2 = d1 - sigma_sqrt_T;
+
+    double N_d1 = normal_cdf(sign * d1);
+    double N_d2 = normal_cdf(sign * d2);
+    double spot_discounted = c.S * c.discount_q;
+    double strike_discounted = K * c.discount_r;
+    double spot_density = spot_discounted * normal_pdf(d1);
+
+    OptionGreeks greeks;
+    greeks.price = sign * (spot_discounted * N_d1 - strike_discounted * N_d2);
+    greeks.delta = sign * c.discount_q * N_d1;
+    greeks.gamma = spot_density / (c.S * c.S * sigma_sqrt_T);
+    greeks.vega = spot_density * c.sqrt_T;
+    greeks.theta = -spot_density * sigma / (2 * c.sqrt_T) - sign * (c.r * strike_discounted * N_d2 - c.q * spot_discounted * N_d1);
+    return greeks;
+}
+
+/**
+ * @brief Calculate the price of an American option using the Barone-Adesi Whaley model with dividends.
+ *
+ * Instantiated with a Dual number, one evaluation also returns the exact partial derivatives
+ * of the price with respect to every input seeded as a variable.
+ *
+ * @tparam Kind Option type.
+ * @tparam Scalar double, or a Dual number to propagate derivatives.
+ * @param S Current stock price.
+ * @param K Strike price of the option.
+ * @param T Time to expiration in years.
+ * @param r Risk-free interest rate.
+ * @param sigma Implied volatility.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @return Scalar The calculated option price.
+ */
+template <OptionKind Kind, PricingScalar Scalar>
+inline Scalar baw_price(Scalar S, Scalar K, Scalar T, Scalar r, Scalar sigma, Scalar q = Scalar(0.0))
+{
+    using std::exp;
+    using std::log;
+    using std::sqrt;
+
+    constexpr double sign = Kind == OptionKind::Call ? 1.0 : -1.0;
+
+    Scalar M = 2 * (r - q) / (sigma * sigma);
+    Scalar n = 2 * (r - q - 0.5 * sigma * sigma) / (sigma * sigma);
+    Scalar q2 = (-(n - 1) - sqrt((n - 1) * (n - 1) + 4 * M)) / 2;
+
+    Scalar d1 = (log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / (sigma * sqrt(T));
+    Scalar d2 = d1 - sigma * sqrt(T);
+
+    Scalar european_price = sign * (S * exp(-q * T) * normal_cdf(sign * d1) - K * exp(-r * T) * normal_cdf(sign * d2));
+    if (q >= r || q2 < 0)
+        return european_price;
+    return baw_early_exercise_price<Kind>(S, K, q2, european_price);
+}
+
+/**
+ * @brief Barone-Adesi Whaley price with the option type chosen at runtime.
+ *
+ * @param kind Option type.
+ * @param S Current stock price.
+ * @param K Strike price of the option.
+ * @param T Time to expiration in years.
+ * @param r Risk-free interest rate.
+ * @param sigma Implied volatility.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @return double The calculated option price.
+ */
+inline double baw_price(OptionKind kind, double S, double K, double T, double r, double sigma, double q = 0.0)
+{
+    return kind == OptionKind::Call ? baw_price<OptionKind::Call>(S, K, T, r, sigma, q)
+                                    : baw_price<OptionKind::Put>(S, K, T, r, sigma, q);
+}
+
+double barone_adesi_whaley_american_option_price(
+    double S,
+    double K,
+    double T,
+    double r,
+    double sigma,
+    double q = 0.0,
+    const std::string &option_type = "calls");
+
+OptionGreeks calculate_greeks_baw(OptionKind kind, double S, double K, double T, double r, double sigma, double q = 0.0);
+
+OptionSensitivities calculate_sensitivities_baw(OptionKind kind, double S, double K, double T, double r, double sigma, double q = 0.0);
+
+void calculate_greeks_baw_batch(
+    const double *strikes,
+    const double *implied_vols,
+    OptionGreeks *greeks,
+    std::size_t count,
+    double S,
+    double r,
+    double T,
+    double q = 0.0,
+    OptionKind option_kind = OptionKind::Call);
+
+template <OptionKind Kind>
+double calculate_delta(double S, double K, double T, double r, double sigma, double q = 0.0);
+
+template <OptionKind Kind>
+double calculate_gamma(double S, double K, double T, double r, double sigma, double q = 0.0);
+
+template <OptionKind Kind>
+double calculate_vega(double S, double K, double T, double r, double sigma, double q = 0.0);
+
+template <OptionKind Kind>
+double implied_volatility_baw(
+    double option_price,
+    double S,
+    double K,
+    double r,
+    double T,
+    double q = 0.0,
+    int max_iterations = 100,
+    double tolerance = 1e-8);
+
+template <OptionKind Kind>
+double implied_volatility_baw_newton(
+    double option_price,
+    double S,
+    double K,
+    double r,
+    double T,
+    double q = 0.0,
+    int *evaluations = nullptr,
+    int max_iterations = 50,
+    double tolerance = 1e-8);
 
 double calculate_implied_volatility_baw(
     double option_price,
@@ -14,13 +362,47 @@ double calculate_implied_volatility_baw(
     int max_iterations = 100,
     double tolerance = 1e-8);
 
-inline double barone_adesi_whaley_american_option_price(
+double calculate_implied_volatility_baw_newton(
+    double option_price,
     double S,
     double K,
+    double r,
+    double T,
+    double q = 0.0,
+    const std::string &option_type = "calls",
+    int *evaluations = nullptr,
+    int max_iterations = 50,
+    double tolerance = 1e-8);
+
+void calculate_implied_volatility_baw_batch(
+    const double *option_prices,
+    const double *strikes,
+    double *implied_vols,
+    std::size_t count,
+    double S,
+    double r,
     double T,
+    double q = 0.0,
+    OptionKind option_kind = OptionKind::Call,
+    int max_iterations = 100,
+    double tolerance = 1e-8,
+    IVSolverMode mode = IVSolverMode::Bisection,
+    int *evaluations = nullptr);
+
+void calculate_implied_volatility_baw_selection(
+    const double *option_prices,
+    const double *strikes,
+    double *implied_vols,
+    const std::size_t *rows,
+    std::size_t count,
+    double S,
     double r,
-    double sigma,
+    double T,
     double q = 0.0,
-    const std::string &option_type = "calls");
+    OptionKind option_kind = OptionKind::Call,
+    int max_iterations = 100,
+    double tolerance = 1e-8,
+    IVSolverMode mode = IVSolverMode::Bisection,
+    int *evaluations = nullptr);
 
 #endif
@@ -0,0 +1,48 @@
+#ifndef OPTION_CHAIN_H
+#define OPTION_CHAIN_H
+
+#include <cstddef>
+#include <map>
+#include <vector>
+#include <Eigen/Dense>
+#include "data.h"
+
+/**
+ * @brief Option chain stored column-wise and sorted by strike.
+ *
+ * Every column holds one value per strike in the same row order, so a column can be handed
+ * to the IV solver as a plain array or viewed as an Eigen vector with column_view.
+ */
+struct OptionChain
+{
+    std::vector<double> strike;
+    std::vector<double> bid;
+    std::vector<double> ask;
+    std::vector<double> mid;
+    std::vector<double> open_interest;
+    std::vector<double> bid_iv;
+    std::vector<double> ask_iv;
+    std::vector<double> mid_iv;
+
+    std::size_t size() const;
+    bool empty() const;
+    void clear();
+    void reserve(std::size_t n);
+    void resize(std::size_t n);
+    void push_back(double strike_price, const QuoteData &quote);
+};
+
+using ChainColumn = Eigen::Map<Eigen::VectorXd>;
+using ConstChainColumn = Eigen::Map<const Eigen::VectorXd>;
+
+ChainColumn mutable_column_view(std::vector<double> &column);
+ConstChainColumn column_view(const std::vector<double> &column);
+
+void load_option_chain(const std::map<double, QuoteData> &quotes, OptionChain &chain);
+
+void select_rows(
+    const OptionChain &chain,
+    const std::vector<std::size_t> &rows,
+    OptionChain &selected);
+
+#endif
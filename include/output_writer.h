@@ -0,0 +1,103 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <Eigen/Dense>
+#include "surface_store.h"
+
+/**
+ * @brief File format of the smile output.
+ */
+enum class OutputFormat
+{
+    CSV,
+    Binary
+};
+
+/**
+ * @brief What the OutputWriter writes and where.
+ */
+struct OutputWriterConfig
+{
+    bool write_files;
+    std::string directory;
+    OutputFormat format;
+    std::string store_directory;
+};
+
+/**
+ * @brief Fitted smile of one chain at one point in time, handed to the OutputWriter.
+ *
+ * The writer takes ownership of the buffers, so the job that produced them can move on
+ * without waiting for formatting or disk I/O.
+ */
+struct SmileOutput
+{
+    std::string ticker;
+    std::string date;
+    std::string option_type;
+    std::int64_t timestamp_ms;
+    Eigen::VectorXd original_strikes;
+    Eigen::VectorXd original_ivs;
+    Eigen::VectorXd interpolated_strikes;
+    Eigen::VectorXd interpolated_ivs;
+};
+
+/**
+ * @brief Writes smile outputs to disk on a background thread.
+ *
+ * Jobs hand over records through a lock-free multi-producer queue (a linked list whose head
+ * producers swap atomically), so submitting never blocks on the writer or on other jobs. Each
+ * record goes to files named <ticker>_<date>_<option type>_<timestamp> in the output
+ * directory: _original.csv and _interpolated.csv, or a single .bin file holding both series.
+ * Smile records are appended to the surface store. Until start() is called, submit() writes
+ * files on the calling thread instead and drops smile records.
+ */
+class OutputWriter
+{
+public:
+    OutputWriter();
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter &) = delete;
+    OutputWriter &operator=(const OutputWriter &) = delete;
+
+    void start(const OutputWriterConfig &config);
+    void stop();
+    void submit(std::unique_ptr<SmileOutput> output);
+    void submit(std::unique_ptr<SmileRecord> record);
+    bool store_open() const;
+    std::uint64_t files_written() const;
+
+private:
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        std::unique_ptr<SmileOutput> output;
+        std::unique_ptr<SmileRecord> record;
+    };
+
+    void push(Node *node);
+    void writer_loop();
+    void write(const SmileOutput &output);
+
+    OutputWriterConfig config_;
+    SurfaceStore store_;
+    std::atomic<Node *> head_;
+    Node *tail_;
+    std::atomic<std::uint64_t> submitted_;
+    std::atomic<std::uint64_t> files_written_;
+    std::atomic<bool> running_;
+    std::atomic<bool> stopping_;
+    std::thread thread_;
+};
+
+extern OutputWriter output_writer;
+
+OutputFormat parse_output_format(const std::string &format);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <memory>
+#include <ostream>
+#include <vector>
+#include "filters.h"
+#include "load_json.h"
+#include "metrics.h"
+#include "option_chain.h"
+#include "scheduler.h"
+#include "smile_surface.h"
+#include "snapshot_log.h"
+
+/**
+ * @brief Quotes a smile was fitted to and the fitted smile, kept for the mispricing scan.
+ *
+ * Also holds the selection and IV evaluation counts of the fit, so that a FittedChain reused
+ * from run to run keeps their capacity.
+ */
+struct FittedChain
+{
+    OptionChain fit_chain;
+    std::shared_ptr<const SmileSurface> smile;
+    double rmse;
+    ChainSelection selection;
+    std::vector<int> iv_evaluations;
+};
+
+void acquire_chain_snapshot(std::ostream &out, const WatchListEntry &entry, ChainSnapshot &snapshot);
+
+bool fit_chain_smile(
+    std::ostream &out,
+    ChainSnapshot &snapshot,
+    FittedChain &fitted,
+    StageClock &clock,
+    WorkStealingPool *pool = nullptr);
+
+void scan_mispricings(
+    std::ostream &out,
+    const ChainSnapshot &snapshot,
+    const WatchListEntry &entry,
+    const FittedChain &fitted,
+    StageClock &clock);
+
+void perform_option_interpolation(std::ostream &out, ChainSnapshot &snapshot, WorkStealingPool *pool = nullptr);
+
+void perform_surface_interpolation(
+    std::ostream &out,
+    WorkStealingPool &pool,
+    const std::vector<const WatchListEntry *> &entries,
+    SnapshotRecorder *recorder);
+
+#endif
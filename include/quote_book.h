@@ -0,0 +1,126 @@
+#ifndef QUOTE_BOOK_H
+#define QUOTE_BOOK_H
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "models.h"
+#include "option_chain.h"
+
+/**
+ * @brief Fields of a Schwab option symbol such as "AAPL  240809C00095000".
+ */
+struct OptionSymbol
+{
+    std::string underlying;
+    int expiry;
+    OptionKind kind;
+    double strike;
+};
+
+/**
+ * @brief Flags marking which fields of a QuoteUpdate carry a value.
+ */
+enum QuoteUpdateField : unsigned int
+{
+    QUOTE_BID = 1u << 0,
+    QUOTE_ASK = 1u << 1,
+    QUOTE_LAST = 1u << 2,
+    QUOTE_OPEN_INTEREST = 1u << 3
+};
+
+/**
+ * @brief Level-1 delta: only the fields flagged in fields changed.
+ */
+struct QuoteUpdate
+{
+    unsigned int fields;
+    double bid;
+    double ask;
+    double last;
+    double open_interest;
+};
+
+/**
+ * @brief One expiry of an underlying copied out of the quote book.
+ */
+struct ExpiryChain
+{
+    int expiry;
+    double T;
+    OptionChain chain;
+};
+
+/**
+ * @brief Live option chains and underlying prices, updated in place by the streaming client.
+ *
+ * Each (underlying, expiry, option type) chain is an OptionChain sorted by strike with its
+ * own mutex, so an update only locks the chain it touches and a job copying one chain out
+ * does not block updates of the others.
+ */
+class QuoteBook
+{
+public:
+    void apply_option_update(const OptionSymbol &symbol, const QuoteUpdate &update);
+    void apply_equity_update(const std::string &symbol, const QuoteUpdate &update);
+    void set_as_of(std::int64_t epoch_ms);
+
+    bool snapshot_chain(
+        const std::string &underlying,
+        int date_index,
+        OptionKind kind,
+        OptionChain &chain,
+        double &S,
+        double &T,
+        int &expiry) const;
+    bool snapshot_expiries(
+        const std::string &underlying,
+        OptionKind kind,
+        std::vector<ExpiryChain> &chains,
+        double &S) const;
+    bool empty() const;
+
+private:
+    struct ChainId
+    {
+        std::string underlying;
+        OptionKind kind;
+        int expiry;
+
+        bool operator<(const ChainId &other) const;
+    };
+
+    struct LiveChain
+    {
+        mutable std::mutex mutex;
+        OptionChain chain;
+    };
+
+    struct EquityQuote
+    {
+        double bid = 0.0;
+        double ask = 0.0;
+        double last = 0.0;
+    };
+
+    bool underlying_price(const std::string &symbol, double &S, std::int64_t &as_of_ms) const;
+
+    mutable std::shared_mutex chains_mutex_;
+    std::map<ChainId, std::unique_ptr<LiveChain>> chains_;
+    mutable std::mutex equities_mutex_;
+    std::unordered_map<std::string, EquityQuote> equities_;
+    std::int64_t as_of_ms_ = 0;
+};
+
+extern QuoteBook quote_book;
+
+bool parse_option_symbol(const std::string &symbol, OptionSymbol &parsed);
+
+double year_fraction_to_expiry(int expiry, std::int64_t as_of_ms);
+
+#endif
@@ -1,8 +1,19 @@
 #ifndef RBF_H
 #define RBF_H
 
+#include <memory>
 #include <Eigen/Dense>
 
+/**
+ * @brief How the current centers differ from the centers that were factorized.
+ */
+enum class RBFCenterEdit
+{
+    None,
+    Added,
+    Removed
+};
+
 class RBFInterpolator
 {
 public:
@@ -10,13 +21,35 @@ public:
         const Eigen::VectorXd &k,
         const Eigen::VectorXd &y,
         double epsilon);
-    Eigen::VectorXd interpolate(const Eigen::VectorXd &x);
+    void refit(const Eigen::VectorXd &k, const Eigen::VectorXd &y);
+    double interpolate(double x) const;
+    Eigen::VectorXd interpolate(const Eigen::Ref<const Eigen::VectorXd> &x) const;
+    double epsilon() const;
+    const Eigen::VectorXd &weights() const;
+    std::shared_ptr<const RBFInterpolator> snapshot() const;
 
 private:
+    RBFInterpolator() = default;
+    double kernel(double r) const;
+    void factorize(const Eigen::VectorXd &k);
+    bool match_centers(const Eigen::VectorXd &k);
+    void solve_weights();
+    void interpolate_range(
+        const Eigen::Ref<const Eigen::VectorXd> &x,
+        Eigen::Index begin,
+        Eigen::Index end,
+        Eigen::VectorXd &result) const;
+
     Eigen::VectorXd k_;
     Eigen::VectorXd y_;
     Eigen::VectorXd weights_;
-    Eigen::MatrixXd A_;
+    Eigen::VectorXd base_k_;
+    Eigen::LDLT<Eigen::MatrixXd> ldlt_;
+    RBFCenterEdit edit_;
+    Eigen::Index edit_index_;
+    Eigen::VectorXd edit_column_;
+    Eigen::VectorXd edit_solution_;
+    double edit_schur_;
     double epsilon_;
     double smoothing_;
 };
@@ -0,0 +1,25 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstddef>
+#include <string>
+#include "scheduler.h"
+
+/**
+ * @brief Outcome of a replay run.
+ */
+struct ReplayStats
+{
+    std::size_t snapshots;
+    double elapsed_ms;
+    double recorded_ms;
+};
+
+bool replay_snapshot_log(
+    const std::string &file_path,
+    WorkStealingPool &pool,
+    double speed,
+    bool quiet,
+    ReplayStats &stats);
+
+#endif
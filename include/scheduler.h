@@ -0,0 +1,129 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Thread pool in which every worker owns a task deque and idle workers steal from the others.
+ *
+ * A worker runs its own deque in submission order and, once it is empty, steals from the back
+ * of the other deques starting with its right neighbour, taking the work their owners would
+ * reach last. Tasks submitted from outside the pool are dealt to the deques round-robin;
+ * tasks submitted from a worker go to that worker's deque.
+ */
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(unsigned int num_workers = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+    void submit(std::function<void()> task);
+    bool run_pending_task();
+    void wait_idle();
+    unsigned int worker_count() const;
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    void worker_loop(unsigned int index);
+    bool pop_local(unsigned int index, std::function<void()> &task);
+    bool steal(unsigned int thief, std::function<void()> &task);
+    void run_task(std::function<void()> &task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::vector<std::thread> threads_;
+    std::atomic<bool> stopping_;
+    std::atomic<std::size_t> next_queue_;
+    std::atomic<std::size_t> queued_;
+    std::atomic<std::size_t> unfinished_;
+    std::mutex wake_mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+};
+
+/**
+ * @brief Dependency graph of tasks, each run as soon as every task it depends on has finished.
+ *
+ * A node may only depend on nodes added before it, so the graph is acyclic by construction
+ * and insertion order is a valid serial order. A finishing node runs the first successor it
+ * made ready itself and queues the others on the graph's ready list, submitting one pool task
+ * per queued node to take it, so a chain of dependent nodes stays on one thread while
+ * independent branches are taken by idle workers. The calling thread helps by taking nodes
+ * from the same list, and only this graph's nodes, sleeping while all of them are running.
+ */
+class TaskGraph
+{
+public:
+    using NodeId = std::size_t;
+
+    NodeId add(const char *name, std::function<void()> task, std::initializer_list<NodeId> dependencies = {});
+    void run(WorkStealingPool *pool);
+    std::size_t size() const;
+
+private:
+    struct Node
+    {
+        const char *name;
+        std::function<void()> task;
+        std::vector<NodeId> successors;
+        int dependency_count = 0;
+        std::atomic<int> pending{0};
+    };
+
+    /**
+     * @brief Nodes that are ready but not yet taken by a thread.
+     *
+     * Shared with the pool tasks submitted for them, which may run after the graph is gone
+     * and then find the list empty.
+     */
+    struct ReadyList
+    {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<NodeId> nodes;
+    };
+
+    void run_from(WorkStealingPool &pool, NodeId id);
+    void enqueue(WorkStealingPool &pool, NodeId id);
+    static bool take(ReadyList &ready, NodeId &id);
+
+    std::vector<std::unique_ptr<Node>> nodes_;
+    std::atomic<std::size_t> remaining_{0};
+    std::shared_ptr<ReadyList> ready_ = std::make_shared<ReadyList>();
+};
+
+/**
+ * @brief Outcome of one scheduling cycle.
+ */
+struct CycleStats
+{
+    std::size_t completed;
+    std::size_t expired;
+    std::size_t overran;
+    double elapsed_ms;
+};
+
+CycleStats run_job_cycle(
+    WorkStealingPool &pool,
+    const std::vector<std::function<void()>> &jobs,
+    std::size_t rotation,
+    std::chrono::milliseconds deadline);
+
+#endif
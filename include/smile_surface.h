@@ -0,0 +1,91 @@
+#ifndef SMILE_SURFACE_H
+#define SMILE_SURFACE_H
+
+#include <memory>
+#include <string>
+#include <Eigen/Dense>
+#include "interpolations.h"
+#include "rbf.h"
+
+/**
+ * @brief Weight of the RFV fit in the blended smile; the RBF fit gets the remainder.
+ */
+constexpr double SMILE_RFV_WEIGHT = 0.75;
+
+/**
+ * @brief Time spent in each fit of a SmileSurface and the work done by the RFV minimizer.
+ */
+struct SmileFitTrace
+{
+    long long rbf_ns;
+    long long rfv_ns;
+    RFVFitStats rfv;
+};
+
+/**
+ * @brief Strikes of a chain mapped to the coordinates the smile models are fitted in.
+ */
+struct SmileCoordinates
+{
+    double x_min;
+    double x_max;
+    Eigen::VectorXd x_normalized;
+    Eigen::VectorXd log_x_normalized;
+};
+
+SmileCoordinates make_smile_coordinates(const Eigen::Ref<const Eigen::VectorXd> &strikes);
+
+std::shared_ptr<const RBFInterpolator> fit_smile_rbf(
+    const SmileCoordinates &coordinates,
+    const Eigen::Ref<const Eigen::VectorXd> &mid_iv,
+    const std::string &cache_key);
+
+Eigen::VectorXd fit_smile_rfv(
+    const SmileCoordinates &coordinates,
+    const Eigen::Ref<const Eigen::VectorXd> &mid_iv,
+    const Eigen::Ref<const Eigen::VectorXd> &bid_iv,
+    const Eigen::Ref<const Eigen::VectorXd> &ask_iv,
+    const std::string &cache_key,
+    RFVFitStats *fit_stats = nullptr);
+
+/**
+ * @brief Fitted implied volatility smile of one option chain.
+ *
+ * Strikes are normalized to [0.5, 1.5] over the fitted strike range and mapped to
+ * log-moneyness, where an RFV fit and an RBF fit are blended. The smile can be evaluated at
+ * any strike directly; strikes outside the fitted range are clamped to its ends. The two fits
+ * are independent, so they can also be run separately and combined afterwards.
+ */
+class SmileSurface
+{
+public:
+    SmileSurface(
+        const Eigen::Ref<const Eigen::VectorXd> &strikes,
+        const Eigen::Ref<const Eigen::VectorXd> &mid_iv,
+        const Eigen::Ref<const Eigen::VectorXd> &bid_iv,
+        const Eigen::Ref<const Eigen::VectorXd> &ask_iv,
+        const std::string &cache_key,
+        SmileFitTrace *trace = nullptr);
+    SmileSurface(
+        const SmileCoordinates &coordinates,
+        Eigen::VectorXd rfv_params,
+        std::shared_ptr<const RBFInterpolator> rbf);
+    double evaluate(double strike) const;
+    Eigen::VectorXd evaluate(const Eigen::Ref<const Eigen::VectorXd> &strikes) const;
+    Eigen::VectorXd strike_grid(Eigen::Index points) const;
+    double min_strike() const;
+    double max_strike() const;
+    const Eigen::VectorXd &rfv_params() const;
+    const RBFInterpolator &rbf() const;
+    std::shared_ptr<const SmileSurface> snapshot() const;
+
+private:
+    double log_moneyness(double strike) const;
+
+    double x_min_;
+    double x_max_;
+    Eigen::VectorXd rfv_params_;
+    std::shared_ptr<const RBFInterpolator> rbf_;
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef SNAPSHOT_LOG_H
+#define SNAPSHOT_LOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include "load_json.h"
+#include "mapped_file.h"
+#include "option_chain.h"
+
+/**
+ * @brief Everything one pipeline run consumes: the watch-list entry, the quotes and the pricing inputs.
+ */
+struct ChainSnapshot
+{
+    std::int64_t timestamp_ms;
+    WatchListEntry entry;
+    double S;
+    double T;
+    double q;
+    double r;
+    OptionChain chain;
+};
+
+/**
+ * @brief Appends chain snapshots to a memory-mapped binary log.
+ *
+ * Each record is a 4-byte length followed by the snapshot. Quote columns are delta-encoded
+ * from strike to strike as zigzag varints of fixed-point ticks, using the fewest decimals
+ * that represent the column exactly. The length is written last, so a record cut short
+ * by a crash reads as the end of the log.
+ */
+class SnapshotRecorder
+{
+public:
+    explicit SnapshotRecorder(const std::string &file_path);
+    ~SnapshotRecorder();
+
+    SnapshotRecorder(const SnapshotRecorder &) = delete;
+    SnapshotRecorder &operator=(const SnapshotRecorder &) = delete;
+
+    bool is_open() const { return file_.is_open(); }
+    std::size_t bytes_written() const { return used_; }
+    void append(const ChainSnapshot &snapshot);
+
+private:
+    std::mutex mutex_;
+    MappedFile file_;
+    std::size_t used_;
+    std::string scratch_;
+};
+
+/**
+ * @brief Reads the snapshots of a log written by SnapshotRecorder, in order.
+ */
+class SnapshotReader
+{
+public:
+    explicit SnapshotReader(const std::string &file_path);
+
+    bool is_open() const { return valid_; }
+    bool next(ChainSnapshot &snapshot);
+
+private:
+    MappedFile file_;
+    std::size_t offset_;
+    bool valid_;
+};
+
+void encode_chain_snapshot(const ChainSnapshot &snapshot, std::string &out);
+bool decode_chain_snapshot(const char *data, std::size_t length, ChainSnapshot &snapshot);
+
+#endif
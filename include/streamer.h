@@ -0,0 +1,73 @@
+#ifndef STREAMER_H
+#define STREAMER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+#include "websocket.h"
+
+/**
+ * @brief Connection and subscription settings of the Schwab streamer.
+ */
+struct StreamerConfig
+{
+    std::string url;
+    std::string access_token;
+    std::string customer_id;
+    std::string correl_id;
+    std::string channel = "N9";
+    std::string function_id = "APIAPP";
+    std::vector<std::string> equity_symbols;
+    std::vector<std::string> option_symbols;
+    std::string record_file;
+};
+
+/**
+ * @brief Streams level-1 equity and option quotes into the global quote book.
+ *
+ * A dedicated I/O thread owns the connection: it performs the WebSocket handshake, logs in,
+ * subscribes, and applies every data message to quote_book as it arrives. Lost connections
+ * are re-established with exponential backoff.
+ */
+class StreamerClient
+{
+public:
+    explicit StreamerClient(StreamerConfig config);
+    ~StreamerClient();
+
+    StreamerClient(const StreamerClient &) = delete;
+    StreamerClient &operator=(const StreamerClient &) = delete;
+
+    bool wait_for_data(std::chrono::milliseconds timeout);
+
+private:
+    void run();
+    bool connect();
+    void disconnect();
+    bool send_all(const std::string &data);
+    bool send_frame(WebSocketOpcode opcode, const std::string &payload);
+    bool receive_some();
+    bool wait_socket(bool for_write, int timeout_ms);
+    bool stream();
+    void handle_message(const std::string &message);
+
+    StreamerConfig config_;
+    CURL *curl_;
+    std::string buffer_;
+    std::string fragments_;
+    int request_id_;
+    std::ofstream record_;
+    std::atomic<bool> stopping_;
+    std::mutex data_mutex_;
+    std::condition_variable data_ready_;
+    bool has_data_;
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef SURFACE_STORE_H
+#define SURFACE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <Eigen/Dense>
+
+/**
+ * @brief Fixed-width row of the surface store, one per fitted smile.
+ *
+ * Rows are stored as is, little-endian, so a reader can map the row file as an array of them.
+ * expiry is YYYYMMDD (0 for the static chain) and option_kind is 0 for calls and 1 for puts.
+ * The offsets and counts locate the smile's values in the column files of its partition, in
+ * elements: the fitted strikes, their mid IVs and the RBF weights share strike_offset, and
+ * the grid IVs start at grid_offset. The grid strikes are not stored; they are grid_count
+ * evenly spaced strikes from x_min to x_max.
+ */
+struct SurfaceStoreRow
+{
+    std::int64_t timestamp_ms;
+    std::int32_t expiry;
+    std::int32_t option_kind;
+    double S;
+    double T;
+    double r;
+    double q;
+    double rmse;
+    double x_min;
+    double x_max;
+    double rfv_params[5];
+    double rbf_epsilon;
+    std::uint64_t strike_offset;
+    std::uint32_t strike_count;
+    std::uint32_t grid_count;
+    std::uint64_t grid_offset;
+};
+
+static_assert(sizeof(SurfaceStoreRow) == 144, "SurfaceStoreRow is part of the on-disk format");
+
+/**
+ * @brief One fitted smile as appended to and read back from the surface store.
+ *
+ * The offsets of the row are assigned by the store on append.
+ */
+struct SmileRecord
+{
+    std::string ticker;
+    SurfaceStoreRow row;
+    Eigen::VectorXd strikes;
+    Eigen::VectorXd strike_ivs;
+    Eigen::VectorXd rbf_weights;
+    Eigen::VectorXd grid_ivs;
+};
+
+Eigen::VectorXd stored_grid_strikes(const SmileRecord &record);
+
+class SurfacePartition;
+
+/**
+ * @brief Append-only, memory-mapped columnar store of fitted smiles.
+ *
+ * Partitioned as <directory>/<ticker>/<YYYYMMDD>/ by the UTC day of each smile's timestamp.
+ * A partition holds rows.bin, a header (magic, version, row size and committed row count)
+ * followed by SurfaceStoreRow records, and the float64 column files strikes.f64,
+ * strike_ivs.f64, rbf_weights.f64 and grid_ivs.f64. The columns and the row are written
+ * before the row count, so a smile cut short by a crash is not visible to readers.
+ */
+class SurfaceStore
+{
+public:
+    SurfaceStore();
+    ~SurfaceStore();
+
+    SurfaceStore(const SurfaceStore &) = delete;
+    SurfaceStore &operator=(const SurfaceStore &) = delete;
+
+    bool open(const std::string &directory);
+    void close();
+    bool is_open() const { return !directory_.empty(); }
+    void append(SmileRecord &record);
+
+private:
+    std::mutex mutex_;
+    std::string directory_;
+    std::map<std::string, std::unique_ptr<SurfacePartition>> partitions_;
+};
+
+/**
+ * @brief Reads smiles back from a surface store, one time range of one ticker at a time.
+ *
+ * Only the partitions of the days in the range are mapped, and only rows the writer has
+ * committed are returned, so the store can be read while the bot appends to it.
+ */
+class SurfaceStoreReader
+{
+public:
+    explicit SurfaceStoreReader(const std::string &directory);
+
+    std::vector<std::string> tickers() const;
+    std::size_t query(
+        const std::string &ticker,
+        std::int64_t from_ms,
+        std::int64_t to_ms,
+        std::vector<SmileRecord> &records) const;
+
+private:
+    std::string directory_;
+};
+
+#endif
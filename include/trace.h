@@ -0,0 +1,77 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief Whether TRACE_SCOPE records events. Off by default.
+ */
+extern std::atomic<bool> trace_enabled;
+
+void set_trace_thread_name(const std::string &name);
+
+void record_trace_event(const char *name, std::int64_t begin_ns, std::int64_t end_ns);
+
+bool write_chrome_trace(const std::string &file_path);
+
+/**
+ * @brief Current time on the trace clock.
+ *
+ * @return std::int64_t Nanoseconds on the steady clock.
+ */
+inline std::int64_t trace_clock_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Records the lifetime of a scope as one complete trace event.
+ *
+ * When tracing is off the constructor costs a relaxed load and a branch, and no clock is read.
+ */
+class TraceScope
+{
+public:
+    /**
+     * @brief Opens the event.
+     *
+     * @param name Event name; must outlive the trace (a string literal).
+     */
+    explicit TraceScope(const char *name)
+        : name_(trace_enabled.load(std::memory_order_relaxed) ? name : nullptr), begin_ns_(name_ ? trace_clock_ns() : 0)
+    {
+    }
+
+    /**
+     * @brief Closes the event and stores it in the calling thread's buffer.
+     */
+    ~TraceScope()
+    {
+        if (name_)
+            record_trace_event(name_, begin_ns_, trace_clock_ns());
+    }
+
+    TraceScope(const TraceScope &) = delete;
+    TraceScope &operator=(const TraceScope &) = delete;
+
+private:
+    const char *name_;
+    std::int64_t begin_ns_;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+/**
+ * @brief Traces the enclosing scope under the given name. Compiled out with OKB_DISABLE_TRACING.
+ */
+#ifdef OKB_DISABLE_TRACING
+#define TRACE_SCOPE(name) ((void)0)
+#else
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+#endif
+
+#endif
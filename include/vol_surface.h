@@ -0,0 +1,52 @@
+#ifndef VOL_SURFACE_H
+#define VOL_SURFACE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "models.h"
+#include "smile_surface.h"
+
+/**
+ * @brief Fitted smile of one expiry within a VolSurface.
+ */
+struct VolSurfaceSlice
+{
+    int expiry;
+    double T;
+    std::shared_ptr<const SmileSurface> smile;
+};
+
+/**
+ * @brief Term-structured implied volatility surface of one underlying and option type.
+ *
+ * Holds one fitted smile per expiry, ordered by time to expiry. Between two expiries the
+ * total variance sigma^2 T is interpolated linearly in T at a fixed strike, which keeps the
+ * surface free of calendar arbitrage whenever the slices are; before the first and after the
+ * last expiry the volatility of the nearest slice is held flat.
+ */
+class VolSurface
+{
+public:
+    VolSurface(const std::string &underlying, OptionKind kind, double S);
+
+    void add_slice(int expiry, double T, std::shared_ptr<const SmileSurface> smile);
+    double implied_volatility(double strike, double T) const;
+    const VolSurfaceSlice *find_slice(int expiry) const;
+    const std::vector<VolSurfaceSlice> &slices() const;
+    const std::string &underlying() const;
+    OptionKind kind() const;
+    double spot() const;
+
+private:
+    std::string underlying_;
+    OptionKind kind_;
+    double S_;
+    std::vector<VolSurfaceSlice> slices_;
+};
+
+void publish_vol_surface(std::shared_ptr<const VolSurface> surface);
+
+std::shared_ptr<const VolSurface> current_vol_surface(const std::string &underlying, OptionKind kind);
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @brief WebSocket frame opcodes (RFC 6455, section 5.2).
+ */
+enum class WebSocketOpcode : std::uint8_t
+{
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA
+};
+
+/**
+ * @brief One decoded WebSocket frame.
+ */
+struct WebSocketFrame
+{
+    bool fin;
+    WebSocketOpcode opcode;
+    std::string payload;
+};
+
+std::string base64_encode(const unsigned char *data, std::size_t length);
+std::string sha1_digest(const std::string &message);
+std::string websocket_accept_key(const std::string &client_key);
+
+void encode_websocket_frame(
+    WebSocketOpcode opcode,
+    const std::string &payload,
+    bool masked,
+    std::string &out);
+
+std::size_t decode_websocket_frame(
+    const char *data,
+    std::size_t length,
+    WebSocketFrame &frame);
+
+#endif
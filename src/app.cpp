@@ -2,196 +2,182 @@
 #include <map>
 #include <vector>
 #include <algorithm>
+#include <numeric>
 #include <cstdlib>
 #include <chrono>
 #include <thread>
 #include <fstream>
 #include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <cctype>
 
 #include <curl/curl.h>
 #include <Eigen/Dense>
 #include "nlohmann/json.hpp"
 
 #include "data.h"
+#include "option_chain.h"
 #include "filters.h"
 #include "models.h"
 #include "load_env.h"
 #include "load_json.h"
 #include "fred.h"
 #include "interpolations.h"
+#include "smile_surface.h"
+#include "scheduler.h"
+#include "file_watcher.h"
+#include "quote_book.h"
+#include "streamer.h"
+#include "snapshot_log.h"
+#include "pipeline.h"
+#include "replay.h"
 #include "helpers.h"
+#include "metrics.h"
+#include "output_writer.h"
+#include "trace.h"
 
-// Function for option interpolation
-void perform_option_interpolation(const std::string &ticker, const std::string &date, const std::string &option_type, double min_overpriced, double min_underpriced, double min_oi)
+/**
+ * @brief Builds the streamer settings from the environment and the watch list.
+ *
+ * The equities subscribed to are the watch-list tickers plus the underlyings of the option symbols.
+ *
+ * @param watch_list Current watch list.
+ * @return StreamerConfig The streamer settings.
+ */
+StreamerConfig make_streamer_config(const WatchList &watch_list)
 {
-    std::cout << "Ticker: " << ticker << std::endl;
-    std::cout << "Date: " << date << std::endl;
-    std::cout << "Option Type: " << option_type << std::endl;
-    std::cout << "Min Overpriced: " << min_overpriced << std::endl;
-    std::cout << "Min Underpriced: " << min_underpriced << std::endl;
-    std::cout << "Min OI: " << min_oi << std::endl;
-
-    initialize_quote_data();
-
-    double S = 566.345;
-    double T = 0.015708354371353372;
-    double q = 0.0035192;
-
-    std::vector<double> strikes;
-    for (const auto &pair : quote_data)
+    StreamerConfig config;
+    config.url = stream_url;
+    config.access_token = stream_access_token;
+    config.customer_id = stream_customer_id;
+    config.correl_id = stream_correl_id;
+    config.record_file = stream_record_file;
+
+    std::istringstream symbols(stream_option_symbols);
+    std::string symbol;
+    while (std::getline(symbols, symbol, ','))
     {
-        strikes.push_back(pair.first);
-    }
+        symbol.erase(0, symbol.find_first_not_of(" \t"));
+        symbol.erase(symbol.find_last_not_of(" \t") + 1);
 
-    std::sort(strikes.begin(), strikes.end());
-    std::vector<double> filtered_strikes = filter_strikes(strikes, S, 1.25);
-    std::map<double, QuoteData> filtered_data;
-    for (double strike : filtered_strikes)
-    {
-        if (quote_data.find(strike) != quote_data.end())
+        OptionSymbol parsed;
+        if (!parse_option_symbol(symbol, parsed))
         {
-            filtered_data[strike] = quote_data[strike];
+            std::cerr << "Ignoring invalid option symbol: " << symbol << std::endl;
+            continue;
         }
+        config.option_symbols.push_back(symbol);
+        config.equity_symbols.push_back(parsed.underlying);
     }
 
-    filtered_data = filter_by_bid_price(filtered_data);
-
-    for (auto &pair : filtered_data)
+    for (const WatchListEntry &entry : watch_list)
     {
-        double K = pair.first;
-        QuoteData &data = pair.second;
-
-        data.mid_IV = calculate_implied_volatility_baw(data.mid, S, K, risk_free_rate, T, q, option_type);
-        data.bid_IV = calculate_implied_volatility_baw(data.bid, S, K, risk_free_rate, T, q, option_type);
-        data.ask_IV = calculate_implied_volatility_baw(data.ask, S, K, risk_free_rate, T, q, option_type);
+        std::string ticker = entry.ticker;
+        std::transform(ticker.begin(), ticker.end(), ticker.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::toupper(c)); });
+        config.equity_symbols.push_back(ticker);
     }
 
-    filtered_data = filter_by_mid_iv(filtered_data);
-    filtered_strikes.clear();
-    for (const auto &pair : filtered_data)
-    {
-        filtered_strikes.push_back(pair.first);
-    }
+    std::sort(config.equity_symbols.begin(), config.equity_symbols.end());
+    config.equity_symbols.erase(std::unique(config.equity_symbols.begin(), config.equity_symbols.end()), config.equity_symbols.end());
+    return config;
+}
 
-    if (filtered_strikes.size() >= 20)
+/**
+ * @brief Groups the watch list by underlying and option type, so each surface is fitted once per cycle.
+ *
+ * @param watch_list Current watch list.
+ * @return std::vector<std::vector<const WatchListEntry *>> The entries of each underlying and option type, in watch-list order.
+ */
+std::vector<std::vector<const WatchListEntry *>> group_by_underlying(const WatchList &watch_list)
+{
+    std::vector<std::vector<const WatchListEntry *>> groups;
+    std::map<std::pair<std::string, OptionKind>, std::size_t> group_index;
+    for (const WatchListEntry &entry : watch_list)
     {
-        Eigen::VectorXd x_eigen(filtered_strikes.size());
-        Eigen::VectorXd mid_iv_eigen(filtered_strikes.size());
-        Eigen::VectorXd bid_iv_eigen(filtered_strikes.size());
-        Eigen::VectorXd ask_iv_eigen(filtered_strikes.size());
-        Eigen::VectorXd open_interest_eigen(filtered_strikes.size());
-        Eigen::VectorXd mid_eigen(filtered_strikes.size());
-
-        for (size_t i = 0; i < filtered_strikes.size(); ++i)
-        {
-            x_eigen[i] = filtered_strikes[i];
-            mid_iv_eigen[i] = filtered_data[filtered_strikes[i]].mid_IV;
-            bid_iv_eigen[i] = filtered_data[filtered_strikes[i]].bid_IV;
-            ask_iv_eigen[i] = filtered_data[filtered_strikes[i]].ask_IV;
-            open_interest_eigen[i] = filtered_data[filtered_strikes[i]].open_interest;
-            mid_eigen[i] = filtered_data[filtered_strikes[i]].mid;
-        }
-
-        double x_min = x_eigen.minCoeff();
-        double x_max = x_eigen.maxCoeff();
-
-        Eigen::VectorXd x_normalized_eigen(filtered_strikes.size());
-
-        for (Eigen::Index i = 0; i < x_eigen.size(); ++i)
-        {
-            x_normalized_eigen[i] = (x_eigen[i] - x_min) / (x_max - x_min);
-            x_normalized_eigen[i] += 0.5;
-        }
-
-        Eigen::VectorXd log_x_normalized_eigen = x_normalized_eigen.array().log();
-
-        auto interpolator = rbf_model(log_x_normalized_eigen, mid_iv_eigen, 0.5);
-        Eigen::VectorXd rfv_params = fit_model(x_normalized_eigen, mid_iv_eigen, bid_iv_eigen, ask_iv_eigen);
-
-        Eigen::VectorXd fine_x_normalized = Eigen::VectorXd::LinSpaced(800, x_normalized_eigen.minCoeff(), x_normalized_eigen.maxCoeff());
-        Eigen::VectorXd log_fine_x_normalized = fine_x_normalized.array().log();
-        Eigen::VectorXd rbf_interpolated_y = interpolator(log_fine_x_normalized);
-        Eigen::VectorXd rfv_interpolated_y = rfv_model(log_fine_x_normalized, rfv_params);
-
-        Eigen::VectorXd interpolated_y = 0.75 * rfv_interpolated_y + 0.25 * rbf_interpolated_y;
-
-        Eigen::VectorXd y_pred = interp1d(x_normalized_eigen, fine_x_normalized, interpolated_y);
-        double rmse = calculate_rmse(mid_iv_eigen, y_pred);
-        std::cout << "RMSE of the fit: " << rmse << std::endl;
-
-        std::vector<Eigen::Index> valid_indices;
-        for (Eigen::Index i = 0; i < open_interest_eigen.size(); ++i)
-        {
-            if (open_interest_eigen[i] >= min_oi)
-            {
-                valid_indices.push_back(i);
-            }
-        }
-
-        Eigen::VectorXd fine_x = Eigen::VectorXd::LinSpaced(800, x_eigen.minCoeff(), x_eigen.maxCoeff());
-
-        Eigen::VectorXd filtered_x_eigen(valid_indices.size());
-        Eigen::VectorXd filtered_mid_iv_eigen(valid_indices.size());
-        Eigen::VectorXd filtered_bid_iv_eigen(valid_indices.size());
-        Eigen::VectorXd filtered_ask_iv_eigen(valid_indices.size());
-        Eigen::VectorXd filtered_open_interest_eigen(valid_indices.size());
-        Eigen::VectorXd filtered_mid_eigen(valid_indices.size());
-
-        for (Eigen::Index i = 0; i < static_cast<Eigen::Index>(valid_indices.size()); ++i)
-        {
-            Eigen::Index idx = valid_indices[i];
-            filtered_x_eigen[i] = x_eigen[idx];
-            filtered_mid_iv_eigen[i] = mid_iv_eigen[idx];
-            filtered_bid_iv_eigen[i] = bid_iv_eigen[idx];
-            filtered_ask_iv_eigen[i] = ask_iv_eigen[idx];
-            filtered_open_interest_eigen[i] = open_interest_eigen[idx];
-            filtered_mid_eigen[i] = mid_eigen[idx];
-        }
-
-        if (filtered_x_eigen.size() >= 2)
-        {
-            Eigen::VectorXd mispricings(valid_indices.size());
-
-            for (Eigen::Index i = 0; i < filtered_x_eigen.size(); ++i)
-            {
-                double strike = filtered_x_eigen[i];
-                Eigen::VectorXd diff = (fine_x.array() - strike).abs();
-                Eigen::Index closest_index;
-                diff.minCoeff(&closest_index);
-
-                double interpolated_iv = interpolated_y[closest_index];
-                double mid_value = filtered_mid_eigen[i];
-                double option_price = barone_adesi_whaley_american_option_price(S, strike, T, risk_free_rate, interpolated_iv, q, option_type);
-                double diff_price = mid_value - option_price;
-
-                mispricings[i] = diff_price;
-            }
-
-            for (Eigen::Index i = 0; i < filtered_x_eigen.size(); ++i)
-            {
-                std::cout << "Strike: " << filtered_x_eigen[i]
-                          << ", Mid Price: " << filtered_mid_eigen[i]
-                          << ", Mispricing: " << mispricings[i] << std::endl;
-            }
-
-            write_csv("original_strikes_mid_iv.csv", filtered_x_eigen, filtered_mid_iv_eigen);
-            write_csv("interpolated_strikes_iv.csv", fine_x, interpolated_y);
-
-            std::cout << "Data written to CSV files successfully." << std::endl;
-        }
+        auto inserted = group_index.emplace(std::make_pair(entry.ticker, entry.option_kind), groups.size());
+        if (inserted.second)
+            groups.emplace_back();
+        groups[inserted.first->second].push_back(&entry);
     }
+    return groups;
 }
 
 /**
  * @brief Entry point of the application.
  *
- * Loads environment variables, initializes data, and runs the option interpolation loop.
+ * Loads environment variables, initializes data, and runs the option interpolation loop,
+ * resting TIME_TO_REST milliseconds between cycles (--once runs a single cycle and exits).
+ * With --replay <file> it instead feeds a recorded snapshot log through the pipeline
+ * (--speed X replays at X times the recorded pace, the default 0 as fast as possible;
+ * --quiet drops the per-snapshot output).
  *
+ * @param argc Number of command-line arguments.
+ * @param argv Command-line arguments.
  * @return int Exit status code.
  */
-int main()
+int main(int argc, char *argv[])
 {
     load_env_file(".env");
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+
+    std::string replay_file;
+    double replay_speed = 0.0;
+    bool replay_quiet = false;
+    bool run_once = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--replay" && i + 1 < argc)
+            replay_file = argv[++i];
+        else if (arg == "--speed" && i + 1 < argc)
+            replay_speed = std::max(0.0, std::atof(argv[++i]));
+        else if (arg == "--quiet")
+            replay_quiet = true;
+        else if (arg == "--once")
+            run_once = true;
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [--once | --replay <snapshot log> [--speed X] [--quiet]]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (!trace_file.empty())
+    {
+        set_trace_thread_name("main");
+        trace_enabled = true;
+    }
+
+    std::unique_ptr<MetricsDumper> metrics_dumper;
+    if (!metrics_file.empty())
+    {
+        metrics_dumper = std::make_unique<MetricsDumper>(metrics_file, std::chrono::milliseconds(metrics_interval_ms));
+    }
+
+    if (write_csv_output || !surface_store_dir.empty())
+    {
+        output_writer.start(OutputWriterConfig{write_csv_output, output_dir, parse_output_format(output_format), surface_store_dir});
+    }
+
+    if (!replay_file.empty())
+    {
+        WorkStealingPool pool(static_cast<unsigned int>(num_workers));
+        ReplayStats stats;
+        if (!replay_snapshot_log(replay_file, pool, replay_speed, replay_quiet, stats))
+            return 1;
+        output_writer.stop();
+        if (trace_enabled)
+            write_chrome_trace(trace_file);
+
+        std::cout << "Replayed " << stats.snapshots << " snapshots (" << stats.recorded_ms / 1000
+                  << " s recorded) in " << stats.elapsed_ms << " ms on " << pool.worker_count() << " workers, "
+                  << (stats.elapsed_ms > 0 ? stats.snapshots * 1000.0 / stats.elapsed_ms : 0.0) << " snapshots/s" << std::endl;
+        return 0;
+    }
 
     if (schwab_api_key.empty() || schwab_secret.empty() || callback_url.empty() || account_hash.empty() || fred_api_key.empty())
     {
@@ -204,40 +190,85 @@ int main()
         std::cout << "Bot is Live." << std::endl;
     }
 
-    load_json_file("stocks.json");
-    fetch_risk_free_rate(fred_api_key);
-
-    StockNode *current_node = stocks_data_head;
-
-    if (current_node == nullptr)
+    if (!load_json_file("stocks.json") || current_watch_list()->empty())
     {
         std::cerr << "No stock data loaded from the JSON file." << std::endl;
         return 1;
     }
 
+    RiskFreeRateService rate_service(RateServiceConfig{fred_api_key, fred_url, rate_cache_file, std::chrono::milliseconds(rate_refresh_ms)});
+    if (!rate_service.wait_for_rate(std::chrono::seconds(5)))
+    {
+        std::cerr << "No risk-free rate yet; pricing with 0 until the first refresh succeeds." << std::endl;
+    }
+
+    FileWatcher watch_list_watcher("stocks.json", []()
+                                   {
+                                       if (load_json_file("stocks.json"))
+                                       {
+                                           std::cout << "Reloaded stocks.json: " << current_watch_list()->size() << " entries." << std::endl;
+                                       } });
+
+    initialize_quote_data();
+
+    std::unique_ptr<StreamerClient> streamer;
+    if (!stream_url.empty())
+    {
+        streamer = std::make_unique<StreamerClient>(make_streamer_config(*current_watch_list()));
+        if (!streamer->wait_for_data(std::chrono::seconds(5)))
+        {
+            std::cerr << "No streamed quotes yet; using the static chain until they arrive." << std::endl;
+        }
+    }
+
+    std::unique_ptr<SnapshotRecorder> recorder;
+    if (!snapshot_file.empty())
+    {
+        recorder = std::make_unique<SnapshotRecorder>(snapshot_file);
+    }
+
+    WorkStealingPool pool(static_cast<unsigned int>(num_workers));
+    std::mutex output_mutex;
+    std::size_t rotation = 0;
+
     while (true)
     {
         if (is_nyse_open() || dry_run)
         {
-            perform_option_interpolation(
-                current_node->ticker,
-                current_node->date,
-                current_node->option_type,
-                std::stod(current_node->min_overpriced),
-                std::stod(current_node->min_underpriced),
-                std::stod(current_node->min_oi));
-
-            current_node = current_node->next;
+            std::shared_ptr<const WatchList> watch_list = current_watch_list();
+            std::vector<std::vector<const WatchListEntry *>> underlyings = group_by_underlying(*watch_list);
+            std::vector<std::function<void()>> jobs;
+            jobs.reserve(underlyings.size());
+            for (const std::vector<const WatchListEntry *> &entries : underlyings)
+            {
+                jobs.push_back([&entries, &pool, &output_mutex, &recorder]()
+                               {
+                                   std::ostringstream log;
+                                   perform_surface_interpolation(log, pool, entries, recorder.get());
+
+                                   std::lock_guard<std::mutex> lock(output_mutex);
+                                   std::cout << log.str() << std::flush;
+                               });
+            }
+
+            CycleStats stats = run_job_cycle(pool, jobs, rotation++, std::chrono::milliseconds(job_deadline_ms));
+            std::cout << "Cycle: " << stats.completed << " jobs in " << stats.elapsed_ms
+                      << " ms on " << pool.worker_count() << " workers, " << stats.expired
+                      << " skipped past deadline, " << stats.overran << " overran" << std::endl;
+
+            if (trace_enabled)
+                write_chrome_trace(trace_file);
         }
         else
         {
             std::cout << "NYSE is currently closed." << std::endl;
-            break;
         }
 
+        if (run_once)
+            break;
         std::this_thread::sleep_for(std::chrono::milliseconds(time_to_rest));
-        break;
     }
 
+    output_writer.stop();
     return 0;
 }
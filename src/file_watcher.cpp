@@ -0,0 +1,139 @@
+#include "file_watcher.h"
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <system_error>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief How often the watcher thread checks for changes and for shutdown, in milliseconds.
+ */
+constexpr int FILE_WATCH_INTERVAL_MS = 250;
+
+/**
+ * @brief Time to wait after a change for the writer to finish, before reporting it, in milliseconds.
+ */
+constexpr int FILE_WATCH_SETTLE_MS = 50;
+
+/**
+ * @brief Starts watching a file.
+ *
+ * @param file_path Path of the file to watch.
+ * @param on_change Callback invoked on the watcher thread after each change.
+ */
+FileWatcher::FileWatcher(const std::string &file_path, std::function<void()> on_change)
+    : file_path_(file_path), on_change_(std::move(on_change)), stopping_(false)
+{
+    thread_ = std::thread([this]()
+                          { run(); });
+}
+
+/**
+ * @brief Stops watching and joins the watcher thread.
+ */
+FileWatcher::~FileWatcher()
+{
+    stopping_ = true;
+    thread_.join();
+}
+
+#ifdef __linux__
+
+/**
+ * @brief Reads every pending inotify event.
+ *
+ * @param fd Non-blocking inotify descriptor.
+ * @param file_name Name of the watched file within the watched directory.
+ * @return bool True if any event concerned the watched file.
+ */
+static bool drain_inotify_events(int fd, const std::string &file_name)
+{
+    alignas(inotify_event) char buffer[4096];
+    bool changed = false;
+
+    ssize_t length;
+    while ((length = read(fd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char *p = buffer; p < buffer + length;)
+        {
+            const inotify_event *event = reinterpret_cast<const inotify_event *>(p);
+            if (event->len > 0 && file_name == event->name)
+            {
+                changed = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * @brief Watcher loop using inotify on the directory of the file.
+ */
+void FileWatcher::run()
+{
+    std::filesystem::path path = std::filesystem::absolute(file_path_);
+    std::string file_name = path.filename().string();
+
+    int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (fd < 0)
+    {
+        std::cerr << "Could not initialize inotify for " << file_path_ << std::endl;
+        return;
+    }
+
+    if (inotify_add_watch(fd, path.parent_path().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0)
+    {
+        std::cerr << "Could not watch " << file_path_ << std::endl;
+        close(fd);
+        return;
+    }
+
+    while (!stopping_)
+    {
+        pollfd descriptor = {fd, POLLIN, 0};
+        if (poll(&descriptor, 1, FILE_WATCH_INTERVAL_MS) <= 0)
+            continue;
+
+        if (drain_inotify_events(fd, file_name))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(FILE_WATCH_SETTLE_MS));
+            drain_inotify_events(fd, file_name);
+            on_change_();
+        }
+    }
+
+    close(fd);
+}
+
+#else
+
+/**
+ * @brief Watcher loop polling the modification time of the file.
+ */
+void FileWatcher::run()
+{
+    std::error_code error;
+    std::filesystem::file_time_type last_write = std::filesystem::last_write_time(file_path_, error);
+
+    while (!stopping_)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(FILE_WATCH_INTERVAL_MS));
+
+        std::filesystem::file_time_type write_time = std::filesystem::last_write_time(file_path_, error);
+        if (error || write_time == last_write)
+            continue;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(FILE_WATCH_SETTLE_MS));
+        last_write = std::filesystem::last_write_time(file_path_, error);
+        on_change_();
+    }
+}
+
+#endif
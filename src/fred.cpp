@@ -1,12 +1,33 @@
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
+#include <fstream>
 #include <iostream>
+#include <string_view>
 #include <curl/curl.h>
 #include "nlohmann/json.hpp"
 #include "fred.h"
+#include "trace.h"
 
 /**
- * @brief Global variable to store the risk-free rate fetched from the FRED API.
+ * @brief Global variable to store the risk-free rate, published atomically by the RiskFreeRateService.
  */
-double risk_free_rate = 0.0;
+std::atomic<double> risk_free_rate{0.0};
+
+/**
+ * @brief Number of recent observations requested; FRED reports "." on days without a fixing.
+ */
+constexpr int RATE_OBSERVATION_LIMIT = 10;
+
+/**
+ * @brief Time limit of one FRED request.
+ */
+constexpr long RATE_REQUEST_TIMEOUT_MS = 10000;
+
+/**
+ * @brief Longest wait before retrying a failed refresh.
+ */
+constexpr std::chrono::milliseconds RATE_RETRY_INTERVAL(30000);
 
 /**
  * @brief Callback function used by libcurl to store HTTP response data into a string.
@@ -33,52 +54,228 @@ static size_t WriteCallback(void *contents, size_t size, size_t nmemb, std::stri
 }
 
 /**
- * @brief Fetches the risk-free rate (SOFR) from the FRED API and updates the global risk-free rate variable.
+ * @brief libcurl progress callback that aborts the transfer once the service stops.
+ *
+ * @param cancel Flag set when the transfer should be abandoned.
+ * @return int Non-zero to abort.
+ */
+static int CancelCallback(void *cancel, curl_off_t, curl_off_t, curl_off_t, curl_off_t)
+{
+    return static_cast<const std::atomic<bool> *>(cancel)->load() ? 1 : 0;
+}
+
+/**
+ * @brief Fetches the latest SOFR observation from the FRED API.
+ *
+ * Only the most recent observations are requested, newest first, and the first one with a
+ * value is taken.
  *
+ * @param base_url Scheme and host of the FRED API, e.g. a local stub when testing.
  * @param api_key The FRED API key used to authenticate the request.
+ * @param observation Receives the rate, as a fraction, and its date.
+ * @param cancel Optional flag that aborts the request when set.
+ * @return bool True if an observation was received.
  */
-void fetch_risk_free_rate(const std::string &api_key)
+bool fetch_risk_free_rate(const std::string &base_url, const std::string &api_key, RateObservation &observation, const std::atomic<bool> *cancel)
 {
-    CURL *curl;
-    CURLcode res;
+    TRACE_SCOPE("fetch_risk_free_rate");
     std::string readBuffer;
-    std::string url = "https://api.stlouisfed.org/fred/series/observations?series_id=SOFR&api_key=" + api_key + "&file_type=json";
+    std::string url = base_url + "/fred/series/observations?series_id=SOFR&api_key=" + api_key +
+                      "&file_type=json&sort_order=desc&limit=" + std::to_string(RATE_OBSERVATION_LIMIT);
 
-    curl = curl_easy_init();
-    if (curl)
+    CURL *curl = curl_easy_init();
+    if (!curl)
     {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+        std::cerr << "Error initializing CURL" << std::endl;
+        return false;
+    }
 
-        res = curl_easy_perform(curl);
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, RATE_REQUEST_TIMEOUT_MS);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    if (cancel)
+    {
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, CancelCallback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, const_cast<std::atomic<bool> *>(cancel));
+    }
 
-        if (res != CURLE_OK)
-        {
+    CURLcode res = curl_easy_perform(curl);
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_cleanup(curl);
+
+    if (res != CURLE_OK)
+    {
+        if (res != CURLE_ABORTED_BY_CALLBACK)
             std::cerr << "CURL Error: " << curl_easy_strerror(res) << std::endl;
+        return false;
+    }
+    if (status != 200)
+    {
+        std::cerr << "FRED request failed with HTTP status " << status << std::endl;
+        return false;
+    }
+
+    try
+    {
+        auto json_data = nlohmann::json::parse(readBuffer);
+        for (const auto &entry : json_data.at("observations"))
+        {
+            const std::string value = entry.at("value").get<std::string>();
+            if (value.empty() || value == ".")
+                continue;
+            observation.rate = std::stod(value) / 100;
+            observation.date = entry.at("date").get<std::string>();
+            return true;
         }
-        else
+        std::cerr << "FRED returned no SOFR observation with a value" << std::endl;
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
+    }
+    return false;
+}
+
+/**
+ * @brief Publishes the cached rate, if any, and starts the refresh thread.
+ *
+ * @param config API key, FRED URL, cache file (empty disables the cache) and refresh interval.
+ */
+RiskFreeRateService::RiskFreeRateService(RateServiceConfig config)
+    : config_(std::move(config)), stopping_(false), has_rate_(false)
+{
+    load_cache();
+
+    thread_ = std::thread([this]()
+                          {
+                              set_trace_thread_name("rate_service");
+                              std::unique_lock<std::mutex> lock(mutex_);
+                              std::chrono::milliseconds wait(0);
+                              while (!stop_.wait_for(lock, wait, [this]()
+                                                     { return stopping_.load(); }))
+                              {
+                                  lock.unlock();
+                                  bool refreshed = refresh();
+                                  lock.lock();
+                                  wait = refreshed ? config_.refresh_interval : std::min(config_.refresh_interval, RATE_RETRY_INTERVAL);
+                              } });
+}
+
+/**
+ * @brief Aborts any request in flight and joins the refresh thread.
+ */
+RiskFreeRateService::~RiskFreeRateService()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_.notify_all();
+    thread_.join();
+}
+
+/**
+ * @brief Blocks until a rate has been published, from the cache or from FRED.
+ *
+ * @param timeout Longest time to wait.
+ * @return bool True if a rate is available.
+ */
+bool RiskFreeRateService::wait_for_rate(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return rate_ready_.wait_for(lock, timeout, [this]()
+                                { return has_rate_; });
+}
+
+/**
+ * @brief Fetches the latest observation, publishes it and caches it if it is new.
+ *
+ * @return bool True if the request succeeded.
+ */
+bool RiskFreeRateService::refresh()
+{
+    RateObservation observation;
+    if (!fetch_risk_free_rate(config_.base_url, config_.api_key, observation, &stopping_))
+        return false;
+
+    bool changed = observation.date != last_date_ || observation.rate != risk_free_rate.load(std::memory_order_acquire);
+    publish(observation, "FRED");
+    if (changed)
+        save_cache(observation);
+    return true;
+}
+
+/**
+ * @brief Publishes the observation in the cache file.
+ *
+ * The file holds the rate as a fraction and the observation date on one line.
+ *
+ * @return bool True if a cached rate was published.
+ */
+bool RiskFreeRateService::load_cache()
+{
+    if (config_.cache_file.empty())
+        return false;
+
+    std::ifstream file(config_.cache_file);
+    RateObservation observation;
+    if (!(file >> observation.rate >> observation.date))
+        return false;
+
+    publish(observation, "cache");
+    return true;
+}
+
+/**
+ * @brief Replaces the cache file with an observation, through a temporary file.
+ *
+ * @param observation Observation to persist.
+ */
+void RiskFreeRateService::save_cache(const RateObservation &observation) const
+{
+    if (config_.cache_file.empty())
+        return;
+
+    std::string temporary_path = config_.cache_file + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::trunc);
+        if (!file.is_open())
         {
-            try
-            {
-                auto json_data = nlohmann::json::parse(readBuffer);
-                auto observations = json_data["observations"];
-                if (!observations.empty())
-                {
-                    double sofr_value = std::stod(observations.back()["value"].get<std::string>());
-                    risk_free_rate = sofr_value / 100;
-                }
-            }
-            catch (const std::exception &e)
-            {
-                std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
-            }
+            std::cerr << "Could not write rate cache: " << temporary_path << std::endl;
+            return;
         }
+        char rate[32];
+        std::to_chars_result result = std::to_chars(rate, rate + sizeof(rate), observation.rate);
+        file << std::string_view(rate, static_cast<std::size_t>(result.ptr - rate)) << " " << observation.date << "\n";
+    }
 
-        curl_easy_cleanup(curl);
+    if (std::rename(temporary_path.c_str(), config_.cache_file.c_str()) != 0)
+    {
+        std::cerr << "Could not replace rate cache: " << config_.cache_file << std::endl;
     }
-    else
+}
+
+/**
+ * @brief Makes an observation the rate pricing threads read, and wakes wait_for_rate.
+ *
+ * @param observation Observation to publish.
+ * @param source Where it came from, for the log.
+ */
+void RiskFreeRateService::publish(const RateObservation &observation, const char *source)
+{
+    bool changed = observation.date != last_date_ || observation.rate != risk_free_rate.load(std::memory_order_acquire);
+    risk_free_rate.store(observation.rate, std::memory_order_release);
+    last_date_ = observation.date;
+    if (changed)
+        std::cout << "Risk-free rate: " << observation.rate << " (SOFR " << observation.date << ", from " << source << ")" << std::endl;
+
     {
-        std::cerr << "Error initializing CURL" << std::endl;
+        std::lock_guard<std::mutex> lock(mutex_);
+        has_rate_ = true;
     }
+    rate_ready_.notify_all();
 }
@@ -1,22 +1,10 @@
 #include "helpers.h"
-#include <fstream>
 #include <chrono>
 #include <ctime>
 #include <algorithm>
 #include <iostream>
 #include <cmath>
 
-void write_csv(const std::string &filename, const Eigen::VectorXd &x_vals, const Eigen::VectorXd &y_vals)
-{
-    std::ofstream file(filename);
-    file << "Strike,IV\n";
-    for (Eigen::Index i = 0; i < x_vals.size(); ++i)
-    {
-        file << x_vals[i] << "," << y_vals[i] << "\n";
-    }
-    file.close();
-}
-
 /**
  * @brief Check if the New York Stock Exchange (NYSE) is currently open.
  *
@@ -74,7 +62,7 @@ bool is_nyse_open()
  * @param fp Values at the known data points.
  * @return Interpolated values at points x.
  */
-Eigen::VectorXd interp1d(const Eigen::VectorXd &x, const Eigen::VectorXd &xp, const Eigen::VectorXd &fp)
+Eigen::VectorXd interp1d(const Eigen::Ref<const Eigen::VectorXd> &x, const Eigen::Ref<const Eigen::VectorXd> &xp, const Eigen::Ref<const Eigen::VectorXd> &fp)
 {
     Eigen::VectorXd y(x.size());
 
@@ -117,7 +105,7 @@ Eigen::VectorXd interp1d(const Eigen::VectorXd &x, const Eigen::VectorXd &xp, co
  * @param y_pred Vector of predicted values.
  * @return The RMSE value.
  */
-double calculate_rmse(const Eigen::VectorXd &y_true, const Eigen::VectorXd &y_pred)
+double calculate_rmse(const Eigen::Ref<const Eigen::VectorXd> &y_true, const Eigen::Ref<const Eigen::VectorXd> &y_pred)
 {
     if (y_true.size() != y_pred.size())
     {
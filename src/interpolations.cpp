@@ -4,7 +4,75 @@
 #include <functional>
 #include <algorithm>
 #include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include "rbf.h"
+#include "trace.h"
+#include "helpers.h"
+
+/**
+ * @brief Parameter vector [a, b, c, d, e] of the RFV model, sized at compile time.
+ */
+using RFVParams = Eigen::Matrix<double, 5, 1>;
+
+/**
+ * @brief Last converged RFV fit of one (ticker, expiry, option type) chain.
+ */
+struct RFVCacheEntry
+{
+    RFVParams params;
+    double rmse;
+    int cold_iterations;
+};
+
+/**
+ * @brief Allowed RMSE increase of a warm-started fit over the cached fit before falling back to a cold start.
+ *
+ * Quotes move between polls, so the RMSE is allowed to drift by a relative and an
+ * absolute amount (in volatility units) before the warm start counts as degraded.
+ */
+constexpr double RFV_WARM_START_RELATIVE_RMSE_TOLERANCE = 0.25;
+constexpr double RFV_WARM_START_ABSOLUTE_RMSE_TOLERANCE = 1e-4;
+
+static std::unordered_map<std::string, RFVCacheEntry> rfv_param_cache;
+static RFVWarmStartStats rfv_warm_start_stats = {0, 0, 0, 0};
+static std::mutex rfv_cache_mutex;
+
+static std::unordered_map<std::string, std::shared_ptr<RBFInterpolator>> rbf_cache;
+static std::mutex rbf_cache_mutex;
+
+/**
+ * @brief Resolves the RBF shape parameter, deriving it from the center spacing when non-positive.
+ *
+ * @param k Input vector representing the independent variable.
+ * @param epsilon Requested shape parameter.
+ * @return double The shape parameter to use.
+ */
+static double resolve_rbf_epsilon(const Eigen::VectorXd &k, double epsilon)
+{
+    if (epsilon <= 0)
+    {
+        Eigen::VectorXd k_sorted = k;
+        std::sort(k_sorted.data(), k_sorted.data() + k_sorted.size());
+        epsilon = (k_sorted.tail(1)[0] - k_sorted.head(1)[0]) / (k_sorted.size() - 1);
+    }
+    return epsilon;
+}
+
+/**
+ * @brief Wraps a shared interpolator in a callable without copying its data.
+ *
+ * @param rbf Interpolator to evaluate.
+ * @return A function that takes an Eigen::VectorXd and returns the interpolated Eigen::VectorXd.
+ */
+static std::function<Eigen::VectorXd(const Eigen::VectorXd &)> make_rbf_function(std::shared_ptr<const RBFInterpolator> rbf)
+{
+    return [rbf](const Eigen::VectorXd &inputs) -> Eigen::VectorXd
+    {
+        return rbf->interpolate(inputs);
+    };
+}
 
 /**
  * @brief Creates a radial basis function (RBF) model based on the given data.
@@ -19,19 +87,80 @@ std::function<Eigen::VectorXd(const Eigen::VectorXd &)> rbf_model(
     const Eigen::VectorXd &y,
     double epsilon)
 {
-    if (epsilon <= 0)
+    epsilon = resolve_rbf_epsilon(k, epsilon);
+    return make_rbf_function(std::make_shared<const RBFInterpolator>(k, y, epsilon));
+}
+
+/**
+ * @brief Fits a radial basis function (RBF) interpolator, reusing the factorization cached under a key.
+ *
+ * The interpolator built for the same key on the previous call is refitted, so polls that only
+ * move the values cost a back-substitution and polls that add or drop a single point cost a
+ * bordered solve. If an interpolator returned earlier is still referenced, it is copied before
+ * the refit so its holder keeps evaluating the old data. The cache lock is only held to take the
+ * interpolator out and to put it back, so fits of different keys run concurrently.
+ *
+ * @param k Input vector representing the independent variable.
+ * @param y Output vector representing the dependent variable.
+ * @param epsilon Shape parameter for the RBF. If non-positive, it will be computed automatically.
+ * @param cache_key Identifies the data series, e.g. ticker, expiry and option type.
+ * @return std::shared_ptr<const RBFInterpolator> The fitted interpolator.
+ */
+std::shared_ptr<const RBFInterpolator> fit_rbf(
+    const Eigen::VectorXd &k,
+    const Eigen::VectorXd &y,
+    double epsilon,
+    const std::string &cache_key)
+{
+    epsilon = resolve_rbf_epsilon(k, epsilon);
+
+    // Taken out of the cache so the solve below runs unlocked; a concurrent fit of the same key starts cold
+    std::shared_ptr<RBFInterpolator> rbf;
     {
-        Eigen::VectorXd k_sorted = k;
-        std::sort(k_sorted.data(), k_sorted.data() + k_sorted.size());
-        epsilon = (k_sorted.tail(1)[0] - k_sorted.head(1)[0]) / (k_sorted.size() - 1);
+        std::lock_guard<std::mutex> lock(rbf_cache_mutex);
+        auto it = rbf_cache.find(cache_key);
+        if (it != rbf_cache.end())
+        {
+            rbf = std::move(it->second);
+        }
     }
 
-    RBFInterpolator rbf(k, y, epsilon);
+    if (rbf && rbf->epsilon() == epsilon)
+    {
+        if (rbf.use_count() > 1)
+        {
+            rbf = std::make_shared<RBFInterpolator>(*rbf);
+        }
+        rbf->refit(k, y);
+    }
+    else
+    {
+        rbf = std::make_shared<RBFInterpolator>(k, y, epsilon);
+    }
 
-    return [rbf](const Eigen::VectorXd &inputs) mutable -> Eigen::VectorXd
     {
-        return rbf.interpolate(inputs);
-    };
+        std::lock_guard<std::mutex> lock(rbf_cache_mutex);
+        rbf_cache[cache_key] = rbf;
+    }
+    return rbf;
+}
+
+/**
+ * @brief Creates a radial basis function (RBF) model, reusing the factorization cached under a key.
+ *
+ * @param k Input vector representing the independent variable.
+ * @param y Output vector representing the dependent variable.
+ * @param epsilon Shape parameter for the RBF. If non-positive, it will be computed automatically.
+ * @param cache_key Identifies the data series, e.g. ticker, expiry and option type.
+ * @return A function that takes an Eigen::VectorXd and returns the interpolated Eigen::VectorXd.
+ */
+std::function<Eigen::VectorXd(const Eigen::VectorXd &)> rbf_model(
+    const Eigen::VectorXd &k,
+    const Eigen::VectorXd &y,
+    double epsilon,
+    const std::string &cache_key)
+{
+    return make_rbf_function(fit_rbf(k, y, epsilon, cache_key));
 }
 
 /**
@@ -60,30 +189,128 @@ Eigen::VectorXd rfv_model(const Eigen::VectorXd &k, const Eigen::VectorXd &param
 }
 
 /**
- * @brief Objective function for optimization; computes the weighted sum of squared residuals.
+ * @brief Computes the Rational Function Volatility (RFV) model value at a single point.
+ *
+ * @param k Log-moneyness.
+ * @param params Parameter vector [a, b, c, d, e] for the RFV model.
+ * @return double The computed RFV model value.
+ */
+double rfv_model(double k, const Eigen::VectorXd &params)
+{
+    return rfv_model<Eigen::VectorXd>(k, params);
+}
+
+/**
+ * @brief Computes the RFV objective and its exact gradient in a single pass over the strikes.
  *
- * @param params Parameter vector for the model.
+ * The objective is the sum over strikes of w (N / D - y_mid)^2, with spread weights
+ * w = 1 / (ask - bid + 1e-8) supplied precomputed. With residual r = N / D - y, where
+ * N = a + b k + c k^2 and D = 1 + d k + e k^2, the partial derivatives are
+ * 2 w r / D * [1, k, k^2] for a, b, c and -2 w r (N / D) / D * [k, k^2] for d, e.
+ *
+ * @param params Parameter vector [a, b, c, d, e] for the RFV model.
  * @param k Log-moneyness vector.
  * @param y_mid Mid values of the dependent variable.
- * @param y_bid Bid values of the dependent variable.
- * @param y_ask Ask values of the dependent variable.
+ * @param weights Spread weights, one per strike.
+ * @param grad Output gradient vector with 5 elements.
  * @return double The weighted sum of squared residuals.
  */
-double objective_function(
-    const Eigen::VectorXd &params,
+double objective_function_with_gradient(
+    const RFVParams &params,
     const Eigen::VectorXd &k,
-    const Eigen::VectorXd &y_mid,
-    const Eigen::VectorXd &y_bid,
-    const Eigen::VectorXd &y_ask)
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid,
+    const Eigen::VectorXd &weights,
+    RFVParams &grad)
 {
-    Eigen::VectorXd spread = y_ask - y_bid;
-    double epsilon = 1e-8;
-    Eigen::ArrayXd weights = 1.0 / (spread.array() + epsilon);
-    Eigen::VectorXd model_values = rfv_model(k, params);
-    Eigen::VectorXd residuals = model_values - y_mid;
-    Eigen::ArrayXd weighted_residuals = weights * residuals.array().square();
-
-    return weighted_residuals.sum();
+    double a = params(0);
+    double b = params(1);
+    double c = params(2);
+    double d = params(3);
+    double e = params(4);
+
+    double f = 0.0;
+    double g_a = 0.0, g_b = 0.0, g_c = 0.0, g_d = 0.0, g_e = 0.0;
+
+    for (Eigen::Index i = 0; i < k.size(); ++i)
+    {
+        double ki = k(i);
+        double ki2 = ki * ki;
+        double numerator = a + b * ki + c * ki2;
+        double inv_denominator = 1.0 / (1.0 + d * ki + e * ki2);
+        double model_value = numerator * inv_denominator;
+        double residual = model_value - y_mid(i);
+        double weighted_residual = weights(i) * residual;
+
+        f += weighted_residual * residual;
+
+        double scale = 2.0 * weighted_residual * inv_denominator;
+        g_a += scale;
+        g_b += scale * ki;
+        g_c += scale * ki2;
+
+        double scale_denominator = scale * model_value;
+        g_d -= scale_denominator * ki;
+        g_e -= scale_denominator * ki2;
+    }
+
+    grad << g_a, g_b, g_c, g_d, g_e;
+
+    return f;
+}
+
+/**
+ * @brief RFV objective functor passed by type to minimize_lbfgs.
+ */
+struct RFVObjective
+{
+    const Eigen::VectorXd &k;
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid;
+    const Eigen::VectorXd &weights;
+
+    double operator()(const RFVParams &params, RFVParams &grad) const
+    {
+        return objective_function_with_gradient(params, k, y_mid, weights, grad);
+    }
+};
+
+/**
+ * @brief Runs the RFV minimization from the given starting parameters.
+ *
+ * Uses the statically-sized optimizer with a per-thread workspace, so the fit itself
+ * performs no heap allocations.
+ *
+ * @param k Log-moneyness vector.
+ * @param y_mid Mid values of the dependent variable.
+ * @param weights Spread weights, one per strike.
+ * @param initial_guess Starting parameter vector.
+ * @return StaticMinimizeResult<5> The optimization result.
+ */
+static StaticMinimizeResult<5> minimize_rfv(
+    const Eigen::VectorXd &k,
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid,
+    const Eigen::VectorXd &weights,
+    const RFVParams &initial_guess)
+{
+    static const std::vector<std::pair<double, double>> bounds(
+        5, std::make_pair(
+               -std::numeric_limits<double>::infinity(),
+               std::numeric_limits<double>::infinity()));
+    thread_local LBFGSWorkspace<5> workspace;
+
+    RFVObjective objective{k, y_mid, weights};
+    return minimize_lbfgs(objective, initial_guess, bounds, workspace);
+}
+
+/**
+ * @brief Default starting parameters of a cold RFV fit.
+ *
+ * @return RFVParams The initial guess [a, b, c, d, e].
+ */
+static RFVParams rfv_cold_start()
+{
+    RFVParams initial_guess;
+    initial_guess << 0.2, 0.3, 0.1, 0.2, 0.1;
+    return initial_guess;
 }
 
 /**
@@ -96,46 +323,142 @@ double objective_function(
  * @return Eigen::VectorXd The optimized parameters vector.
  */
 Eigen::VectorXd fit_model(
-    const Eigen::VectorXd &x,
-    const Eigen::VectorXd &y_mid,
-    const Eigen::VectorXd &y_bid,
-    const Eigen::VectorXd &y_ask)
+    const Eigen::Ref<const Eigen::VectorXd> &x,
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_bid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_ask)
 {
+    TRACE_SCOPE("fit_model");
     Eigen::VectorXd k = x.array().log();
+    Eigen::VectorXd weights = 1.0 / ((y_ask - y_bid).array() + 1e-8);
 
-    Eigen::VectorXd initial_guess(5);
-    initial_guess << 0.2, 0.3, 0.1, 0.2, 0.1;
+    StaticMinimizeResult<5> result = minimize_rfv(k, y_mid, weights, rfv_cold_start());
 
-    std::vector<std::pair<double, double>> bounds(
-        5, std::make_pair(
-               -std::numeric_limits<double>::infinity(),
-               std::numeric_limits<double>::infinity()));
+    if (result.status != 0)
+    {
+        std::cerr << "Optimization failed: " << result.message << std::endl;
+    }
+
+    return result.x;
+}
 
-    auto func_grad = [&k, &y_mid, &y_bid, &y_ask](
-                         const Eigen::VectorXd &params,
-                         Eigen::VectorXd &grad) -> double
+/**
+ * @brief Fits the RFV model, warm-starting from the last converged parameters of the same chain.
+ *
+ * The smile of a given chain barely moves between polls, so the fit starts from the
+ * parameters cached under cache_key. If that fit fails, produces non-finite parameters or
+ * ends with a noticeably higher RMSE than the cached fit, a cold fit is run as well and the
+ * better of the two is kept.
+ *
+ * @param x Independent variable data.
+ * @param y_mid Mid values of the dependent variable.
+ * @param y_bid Bid values of the dependent variable.
+ * @param y_ask Ask values of the dependent variable.
+ * @param cache_key Key identifying the chain, e.g. ticker, expiry and option type.
+ * @param fit_stats Optional output for the minimizer evaluations and iterations spent.
+ * @return Eigen::VectorXd The optimized parameters vector.
+ */
+Eigen::VectorXd fit_model(
+    const Eigen::Ref<const Eigen::VectorXd> &x,
+    const Eigen::Ref<const Eigen::VectorXd> &y_mid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_bid,
+    const Eigen::Ref<const Eigen::VectorXd> &y_ask,
+    const std::string &cache_key,
+    RFVFitStats *fit_stats)
+{
+    TRACE_SCOPE("fit_model");
+    Eigen::VectorXd k = x.array().log();
+    Eigen::VectorXd weights = 1.0 / ((y_ask - y_bid).array() + 1e-8);
+
+    bool cached = false;
+    RFVCacheEntry entry;
     {
-        double f = objective_function(params, k, y_mid, y_bid, y_ask);
+        std::lock_guard<std::mutex> lock(rfv_cache_mutex);
+        auto it = rfv_param_cache.find(cache_key);
+        if (it != rfv_param_cache.end())
+        {
+            entry = it->second;
+            cached = true;
+        }
+    }
+
+    bool warm_accepted = false;
+    int warm_iterations = 0;
+    RFVFitStats stats = {0, 0};
+    StaticMinimizeResult<5> result;
+    double rmse = std::numeric_limits<double>::infinity();
 
-        double epsilon = 1e-8;
-        Eigen::Index n_params = params.size();
-        grad = Eigen::VectorXd(n_params);
-        for (Eigen::Index i = 0; i < n_params; ++i)
+    if (cached)
+    {
+        result = minimize_rfv(k, y_mid, weights, entry.params);
+        warm_iterations = result.nit;
+        stats.nfev += result.nfev;
+        stats.nit += result.nit;
+        if (result.status == 0 && result.x.allFinite())
         {
-            Eigen::VectorXd params_eps = params;
-            params_eps(i) += epsilon;
-            double f_eps = objective_function(params_eps, k, y_mid, y_bid, y_ask);
-            grad(i) = (f_eps - f) / epsilon;
+            rmse = calculate_rmse(y_mid, rfv_model(k, result.x));
+            warm_accepted = rmse <= entry.rmse * (1 + RFV_WARM_START_RELATIVE_RMSE_TOLERANCE) + RFV_WARM_START_ABSOLUTE_RMSE_TOLERANCE;
         }
-        return f;
-    };
+    }
 
-    MinimizeResult result = minimize(func_grad, initial_guess, bounds);
+    int cold_iterations = cached ? entry.cold_iterations : 0;
+    if (!warm_accepted)
+    {
+        StaticMinimizeResult<5> cold_result = minimize_rfv(k, y_mid, weights, rfv_cold_start());
+        double cold_rmse = calculate_rmse(y_mid, rfv_model(k, cold_result.x));
+        cold_iterations = cold_result.nit;
+        stats.nfev += cold_result.nfev;
+        stats.nit += cold_result.nit;
+
+        if (!cached || !(rmse <= cold_rmse))
+        {
+            result = cold_result;
+            rmse = cold_rmse;
+        }
+    }
 
     if (result.status != 0)
     {
         std::cerr << "Optimization failed: " << result.message << std::endl;
     }
 
+    {
+        std::lock_guard<std::mutex> lock(rfv_cache_mutex);
+        if (!cached)
+        {
+            rfv_warm_start_stats.misses++;
+        }
+        else if (warm_accepted)
+        {
+            rfv_warm_start_stats.hits++;
+            rfv_warm_start_stats.iterations_saved += std::max(cold_iterations - warm_iterations, 0);
+        }
+        else
+        {
+            rfv_warm_start_stats.fallbacks++;
+        }
+
+        if (result.x.allFinite())
+        {
+            rfv_param_cache[cache_key] = {result.x, rmse, cold_iterations};
+        }
+    }
+
+    if (fit_stats)
+    {
+        *fit_stats = stats;
+    }
+
     return result.x;
 }
+
+/**
+ * @brief Returns a snapshot of the RFV warm-start counters.
+ *
+ * @return RFVWarmStartStats Hits, misses, cold fallbacks and minimizer iterations saved so far.
+ */
+RFVWarmStartStats get_rfv_warm_start_stats()
+{
+    std::lock_guard<std::mutex> lock(rfv_cache_mutex);
+    return rfv_warm_start_stats;
+}
@@ -3,6 +3,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <cstring>
+#include <algorithm>
 #include "load_env.h"
 
 /**
@@ -40,6 +41,101 @@ bool dry_run = true;
  */
 int time_to_rest = 100; // Default value in milliseconds
 
+/**
+ * @brief Global variable to store the WRITE_CSV flag.
+ */
+bool write_csv_output = true;
+
+/**
+ * @brief Global variable to store the NUM_WORKERS value.
+ */
+int num_workers = 0; // 0 uses the hardware concurrency
+
+/**
+ * @brief Global variable to store the JOB_DEADLINE_MS value.
+ */
+int job_deadline_ms = 0; // 0 disables the per-cycle job deadline
+
+/**
+ * @brief Global variable to store the STREAM_URL of the Schwab streamer (empty disables streaming).
+ */
+std::string stream_url;
+
+/**
+ * @brief Global variable to store the STREAM_ACCESS_TOKEN used to log in to the streamer.
+ */
+std::string stream_access_token;
+
+/**
+ * @brief Global variable to store the STREAM_CUSTOMER_ID (SchwabClientCustomerId).
+ */
+std::string stream_customer_id;
+
+/**
+ * @brief Global variable to store the STREAM_CORREL_ID (SchwabClientCorrelId).
+ */
+std::string stream_correl_id;
+
+/**
+ * @brief Global variable to store the comma-separated STREAM_OPTION_SYMBOLS to subscribe to.
+ */
+std::string stream_option_symbols;
+
+/**
+ * @brief Global variable to store the STREAM_RECORD_FILE that received data messages are appended to.
+ */
+std::string stream_record_file;
+
+/**
+ * @brief Global variable to store the SNAPSHOT_FILE that chain snapshots are recorded to (empty disables recording).
+ */
+std::string snapshot_file;
+
+/**
+ * @brief Global variable to store the METRICS_FILE that pipeline metrics are dumped to (empty disables the dump).
+ */
+std::string metrics_file;
+
+/**
+ * @brief Global variable to store the METRICS_INTERVAL_MS value.
+ */
+int metrics_interval_ms = 10000; // Default value in milliseconds
+
+/**
+ * @brief Global variable to store the TRACE_FILE that the Chrome trace is written to (empty disables tracing).
+ */
+std::string trace_file;
+
+/**
+ * @brief Global variable to store the OUTPUT_DIR that smile outputs are written to.
+ */
+std::string output_dir = "output";
+
+/**
+ * @brief Global variable to store the OUTPUT_FORMAT of smile outputs ("csv" or "binary").
+ */
+std::string output_format = "csv";
+
+/**
+ * @brief Global variable to store the SURFACE_STORE_DIR that fitted smiles are appended to (empty disables the store).
+ */
+std::string surface_store_dir;
+
+/**
+ * @brief Global variable to store the FRED_URL the risk-free rate is requested from.
+ */
+std::string fred_url = "https://api.stlouisfed.org";
+
+/**
+ * @brief Global variable to store the RATE_CACHE_FILE that the last risk-free rate is kept in (empty disables the cache).
+ */
+std::string rate_cache_file = "risk_free_rate.cache";
+
+/**
+ * @brief Global variable to store the RATE_REFRESH_MS value.
+ */
+int rate_refresh_ms = 3600000; // Default value in milliseconds
+
 /**
  * @brief Loads environment variables from a .env file.
  *
@@ -97,6 +193,110 @@ void load_env_file(const std::string &file_path)
             {
                 dry_run = (value == "true" || value == "TRUE" || value == "1");
             }
+            else if (key == "WRITE_CSV")
+            {
+                write_csv_output = (value == "true" || value == "TRUE" || value == "1");
+            }
+            else if (key == "NUM_WORKERS")
+            {
+                try
+                {
+                    num_workers = std::max(0, std::stoi(value));
+                }
+                catch (const std::exception &)
+                {
+                    std::cerr << "Invalid NUM_WORKERS value: " << value << ". Using default value." << std::endl;
+                }
+            }
+            else if (key == "JOB_DEADLINE_MS")
+            {
+                try
+                {
+                    job_deadline_ms = std::max(0, std::stoi(value));
+                }
+                catch (const std::exception &)
+                {
+                    std::cerr << "Invalid JOB_DEADLINE_MS value: " << value << ". Using default value." << std::endl;
+                }
+            }
+            else if (key == "STREAM_URL")
+            {
+                stream_url = value;
+            }
+            else if (key == "STREAM_ACCESS_TOKEN")
+            {
+                stream_access_token = value;
+            }
+            else if (key == "STREAM_CUSTOMER_ID")
+            {
+                stream_customer_id = value;
+            }
+            else if (key == "STREAM_CORREL_ID")
+            {
+                stream_correl_id = value;
+            }
+            else if (key == "STREAM_OPTION_SYMBOLS")
+            {
+                stream_option_symbols = value;
+            }
+            else if (key == "STREAM_RECORD_FILE")
+            {
+                stream_record_file = value;
+            }
+            else if (key == "SNAPSHOT_FILE")
+            {
+                snapshot_file = value;
+            }
+            else if (key == "METRICS_FILE")
+            {
+                metrics_file = value;
+            }
+            else if (key == "METRICS_INTERVAL_MS")
+            {
+                try
+                {
+                    metrics_interval_ms = std::max(1, std::stoi(value));
+                }
+                catch (const std::exception &)
+                {
+                    std::cerr << "Invalid METRICS_INTERVAL_MS value: " << value << ". Using default value." << std::endl;
+                }
+            }
+            else if (key == "TRACE_FILE")
+            {
+                trace_file = value;
+            }
+            else if (key == "OUTPUT_DIR")
+            {
+                output_dir = value;
+            }
+            else if (key == "OUTPUT_FORMAT")
+            {
+                output_format = value;
+            }
+            else if (key == "SURFACE_STORE_DIR")
+            {
+                surface_store_dir = value;
+            }
+            else if (key == "FRED_URL")
+            {
+                fred_url = value;
+            }
+            else if (key == "RATE_CACHE_FILE")
+            {
+                rate_cache_file = value;
+            }
+            else if (key == "RATE_REFRESH_MS")
+            {
+                try
+                {
+                    rate_refresh_ms = std::max(1000, std::stoi(value));
+                }
+                catch (const std::exception &)
+                {
+                    std::cerr << "Invalid RATE_REFRESH_MS value: " << value << ". Using default value." << std::endl;
+                }
+            }
             else if (key == "TIME_TO_REST")
             {
                 try
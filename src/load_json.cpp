@@ -1,31 +1,36 @@
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <string>
 #include "nlohmann/json.hpp"
 #include "load_json.h"
 
 /**
- * @brief Global pointer to the head of the circular linked list.
+ * @brief Watch list currently in use; replaced as a whole when stocks.json is reloaded.
  */
-StockNode *stocks_data_head = nullptr;
+static std::shared_ptr<const WatchList> watch_list;
 
 /**
- * @brief Loads a JSON file into memory and stores its data in a circular linked list.
+ * @brief Guards swaps and reads of watch_list.
+ */
+static std::mutex watch_list_mutex;
+
+/**
+ * @brief Parses a JSON watch-list file into a typed table.
  *
- * This function reads a JSON file, parses its content, and stores the resulting
- * data into a circular linked list. Each JSON object is mapped to a node in the
- * linked list containing "ticker", "date", "option_type", "min_overpriced",
- * "min_underpriced", and "min_oi" keys.
+ * Each JSON object becomes one WatchListEntry built from its "ticker", "date",
+ * "option_type", "min_overpriced", "min_underpriced" and "min_oi" keys.
  *
  * @param file_path The path to the JSON file to be loaded.
+ * @return std::shared_ptr<const WatchList> The parsed table, or nullptr if the file cannot be read or parsed.
  */
-void load_json_file(const std::string &file_path)
+std::shared_ptr<const WatchList> parse_watch_list(const std::string &file_path)
 {
     std::ifstream file(file_path);
     if (!file.is_open())
     {
         std::cerr << "Could not open JSON file: " << file_path << std::endl;
-        return;
+        return nullptr;
     }
 
     try
@@ -33,41 +38,60 @@ void load_json_file(const std::string &file_path)
         nlohmann::json json_data;
         file >> json_data;
 
-        StockNode *tail = nullptr;
-
+        auto entries = std::make_shared<WatchList>();
+        entries->reserve(json_data.size());
         for (const auto &item : json_data)
         {
-            StockNode *new_node = new StockNode;
-            new_node->ticker = item.at("ticker");
-            new_node->date_index = std::to_string(item.at("date").get<int>());
-            new_node->date = "null";
-            new_node->option_type = item.at("option_type");
-            new_node->min_overpriced = std::to_string(item.at("min_overpriced").get<double>());
-            new_node->min_underpriced = std::to_string(item.at("min_underpriced").get<double>());
-            new_node->min_oi = std::to_string(item.at("min_oi").get<double>());
-            new_node->next = nullptr;
-
-            if (stocks_data_head == nullptr)
-            {
-                stocks_data_head = new_node;
-                tail = new_node;
-            }
-            else
-            {
-                tail->next = new_node;
-                tail = new_node;
-            }
+            WatchListEntry entry;
+            entry.ticker = item.at("ticker");
+            entry.date_index = item.at("date").get<int>();
+            entry.date = "null";
+            entry.option_kind = parse_option_kind(item.at("option_type"));
+            entry.min_overpriced = item.at("min_overpriced").get<double>();
+            entry.min_underpriced = item.at("min_underpriced").get<double>();
+            entry.min_oi = item.at("min_oi").get<double>();
+            entries->push_back(std::move(entry));
         }
 
-        if (tail != nullptr)
-        {
-            tail->next = stocks_data_head;
-        }
+        return entries;
     }
     catch (const std::exception &e)
     {
         std::cerr << "Error parsing JSON file: " << e.what() << std::endl;
     }
 
-    file.close();
-}
\ No newline at end of file
+    return nullptr;
+}
+
+/**
+ * @brief Loads a JSON watch-list file and makes it the current watch list.
+ *
+ * The new table is swapped in as a whole, so readers holding the previous table keep a
+ * consistent view. If the file cannot be parsed, the current watch list is left unchanged.
+ *
+ * @param file_path The path to the JSON file to be loaded.
+ * @return bool True if the watch list was replaced.
+ */
+bool load_json_file(const std::string &file_path)
+{
+    std::shared_ptr<const WatchList> entries = parse_watch_list(file_path);
+    if (entries == nullptr)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(watch_list_mutex);
+    watch_list = std::move(entries);
+    return true;
+}
+
+/**
+ * @brief Returns the current watch list.
+ *
+ * @return std::shared_ptr<const WatchList> The table, or nullptr if none was loaded.
+ */
+std::shared_ptr<const WatchList> current_watch_list()
+{
+    std::lock_guard<std::mutex> lock(watch_list_mutex);
+    return watch_list;
+}
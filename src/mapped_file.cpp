@@ -0,0 +1,231 @@
+#include "mapped_file.h"
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Creates a closed mapping.
+ */
+#ifdef _WIN32
+MappedFile::MappedFile()
+    : file_(INVALID_HANDLE_VALUE), mapping_(nullptr), data_(nullptr), size_(0), writable_(false), open_(false)
+{
+}
+#else
+MappedFile::MappedFile()
+    : fd_(-1), data_(nullptr), size_(0), writable_(false), open_(false)
+{
+}
+#endif
+
+/**
+ * @brief Unmaps and closes the file.
+ */
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+/**
+ * @brief Opens a file and maps its current contents.
+ *
+ * @param file_path Path of the file.
+ * @param writable Open for writing, creating the file if it does not exist.
+ * @return bool True on success.
+ */
+bool MappedFile::open(const std::string &file_path, bool writable)
+{
+    close();
+    writable_ = writable;
+    file_ = CreateFileA(file_path.c_str(), writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        writable ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE)
+    {
+        std::cerr << "Could not open " << file_path << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER file_size;
+    GetFileSizeEx(file_, &file_size);
+    size_ = static_cast<std::size_t>(file_size.QuadPart);
+    open_ = true;
+    if (!map())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Changes the size of a writable file and remaps it.
+ *
+ * @param size New size in bytes.
+ * @return bool True on success.
+ */
+bool MappedFile::resize(std::size_t size)
+{
+    if (!open_ || !writable_)
+        return false;
+
+    unmap();
+    LARGE_INTEGER position;
+    position.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file_, position, nullptr, FILE_BEGIN) || !SetEndOfFile(file_))
+        return false;
+    size_ = size;
+    return map();
+}
+
+/**
+ * @brief Maps the whole file; an empty file is left unmapped.
+ *
+ * @return bool True on success.
+ */
+bool MappedFile::map()
+{
+    if (size_ == 0)
+        return true;
+
+    mapping_ = CreateFileMappingA(file_, nullptr, writable_ ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr)
+        return false;
+
+    data_ = static_cast<char *>(MapViewOfFile(mapping_, writable_ ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size_));
+    return data_ != nullptr;
+}
+
+/**
+ * @brief Removes the current mapping.
+ */
+void MappedFile::unmap()
+{
+    if (data_)
+        UnmapViewOfFile(data_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    data_ = nullptr;
+    mapping_ = nullptr;
+}
+
+/**
+ * @brief Unmaps and closes the file.
+ */
+void MappedFile::close()
+{
+    unmap();
+    if (file_ != INVALID_HANDLE_VALUE)
+        CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+    size_ = 0;
+    open_ = false;
+}
+
+#else
+
+/**
+ * @brief Opens a file and maps its current contents.
+ *
+ * @param file_path Path of the file.
+ * @param writable Open for writing, creating the file if it does not exist.
+ * @return bool True on success.
+ */
+bool MappedFile::open(const std::string &file_path, bool writable)
+{
+    close();
+    writable_ = writable;
+    fd_ = ::open(file_path.c_str(), writable ? O_RDWR | O_CREAT | O_CLOEXEC : O_RDONLY | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+    {
+        std::cerr << "Could not open " << file_path << std::endl;
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd_, &status) < 0)
+    {
+        close();
+        return false;
+    }
+    size_ = static_cast<std::size_t>(status.st_size);
+    open_ = true;
+    if (!map())
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Changes the size of a writable file and remaps it.
+ *
+ * @param size New size in bytes.
+ * @return bool True on success.
+ */
+bool MappedFile::resize(std::size_t size)
+{
+    if (!open_ || !writable_)
+        return false;
+
+    unmap();
+    if (ftruncate(fd_, static_cast<off_t>(size)) < 0)
+        return false;
+    size_ = size;
+    return map();
+}
+
+/**
+ * @brief Maps the whole file; an empty file is left unmapped.
+ *
+ * @return bool True on success.
+ */
+bool MappedFile::map()
+{
+    if (size_ == 0)
+        return true;
+
+    void *address = mmap(nullptr, size_, writable_ ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd_, 0);
+    if (address == MAP_FAILED)
+        return false;
+
+    data_ = static_cast<char *>(address);
+    return true;
+}
+
+/**
+ * @brief Removes the current mapping.
+ */
+void MappedFile::unmap()
+{
+    if (data_)
+        munmap(data_, size_);
+    data_ = nullptr;
+}
+
+/**
+ * @brief Unmaps and closes the file.
+ */
+void MappedFile::close()
+{
+    unmap();
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    size_ = 0;
+    open_ = false;
+}
+
+#endif
@@ -0,0 +1,404 @@
+#include "metrics.h"
+#include "interpolations.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+
+/**
+ * @brief Per-ticker metrics, created on first use and never removed so references stay valid.
+ */
+static std::map<std::string, std::unique_ptr<TickerMetrics>> metrics_registry;
+static std::shared_mutex metrics_registry_mutex;
+
+/**
+ * @brief Quantiles reported for every histogram.
+ */
+static const double METRICS_QUANTILES[] = {0.5, 0.99, 0.999};
+
+/**
+ * @brief Label value of a pipeline stage.
+ *
+ * @param stage Pipeline stage.
+ * @return const char* The stage name in snake case.
+ */
+const char *pipeline_stage_name(PipelineStage stage)
+{
+    switch (stage)
+    {
+    case PipelineStage::StrikeFilter:
+        return "strike_filter";
+    case PipelineStage::IVSolve:
+        return "iv_solve";
+    case PipelineStage::IVFilter:
+        return "iv_filter";
+    case PipelineStage::RBFBuild:
+        return "rbf_build";
+    case PipelineStage::RFVFit:
+        return "rfv_fit";
+    case PipelineStage::GridEval:
+        return "grid_eval";
+    case PipelineStage::MispricingScan:
+        return "mispricing_scan";
+    case PipelineStage::CSVWrite:
+        return "csv_write";
+    default:
+        return "total";
+    }
+}
+
+/**
+ * @brief Creates an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram()
+    : count_(0), sum_(0), max_(0)
+{
+    for (std::atomic<std::uint64_t> &bucket : buckets_)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Bucket of a value: linear below 2^LINEAR_BITS, log-linear above.
+ *
+ * @param value Value in nanoseconds, below 2^MAX_VALUE_BITS.
+ * @return std::size_t The bucket index.
+ */
+std::size_t LatencyHistogram::bucket_index(std::uint64_t value)
+{
+    if (value < (std::uint64_t{1} << LINEAR_BITS))
+        return static_cast<std::size_t>(value);
+
+    int shift = std::bit_width(value) - LINEAR_BITS;
+    std::uint64_t sub_bucket = value >> shift;
+    return (std::size_t{1} << LINEAR_BITS) + static_cast<std::size_t>(shift - 1) * SUB_BUCKETS + static_cast<std::size_t>(sub_bucket - SUB_BUCKETS);
+}
+
+/**
+ * @brief Largest value that falls in a bucket.
+ *
+ * @param index Bucket index.
+ * @return std::uint64_t The upper bound in nanoseconds.
+ */
+std::uint64_t LatencyHistogram::bucket_upper_bound(std::size_t index)
+{
+    if (index < (std::size_t{1} << LINEAR_BITS))
+        return index;
+
+    std::size_t offset = index - (std::size_t{1} << LINEAR_BITS);
+    int shift = static_cast<int>(offset / SUB_BUCKETS) + 1;
+    std::uint64_t sub_bucket = SUB_BUCKETS + offset % SUB_BUCKETS;
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+/**
+ * @brief Records one latency.
+ *
+ * @param nanoseconds Latency in nanoseconds.
+ */
+void LatencyHistogram::record(std::uint64_t nanoseconds)
+{
+    std::uint64_t value = std::min(nanoseconds, (std::uint64_t{1} << MAX_VALUE_BITS) - 1);
+    buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_.fetch_add(value, std::memory_order_relaxed);
+
+    std::uint64_t current = max_.load(std::memory_order_relaxed);
+    while (value > current && !max_.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+/**
+ * @brief Number of recorded latencies.
+ *
+ * @return std::uint64_t The count.
+ */
+std::uint64_t LatencyHistogram::count() const
+{
+    return count_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Sum of the recorded latencies.
+ *
+ * @return std::uint64_t The sum in nanoseconds.
+ */
+std::uint64_t LatencyHistogram::sum() const
+{
+    return sum_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Largest recorded latency.
+ *
+ * @return std::uint64_t The maximum in nanoseconds.
+ */
+std::uint64_t LatencyHistogram::max() const
+{
+    return max_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Latency below or at which the given share of the recordings fall.
+ *
+ * Read while other threads record, the result describes a recent state of the histogram.
+ *
+ * @param percent Percentile between 0 and 100.
+ * @return std::uint64_t The upper bound of the bucket holding the percentile, in nanoseconds; 0 if empty.
+ */
+std::uint64_t LatencyHistogram::percentile(double percent) const
+{
+    std::uint64_t total = 0;
+    for (const std::atomic<std::uint64_t> &bucket : buckets_)
+    {
+        total += bucket.load(std::memory_order_relaxed);
+    }
+    if (total == 0)
+        return 0;
+
+    std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(percent / 100.0 * static_cast<double>(total))));
+    std::uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKET_COUNT; ++i)
+    {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+            return std::min(bucket_upper_bound(i), max());
+    }
+    return max();
+}
+
+/**
+ * @brief Metrics of a ticker, created on first use.
+ *
+ * @param ticker Ticker symbol.
+ * @return TickerMetrics& The metrics, valid for the lifetime of the program.
+ */
+TickerMetrics &ticker_metrics(const std::string &ticker)
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(metrics_registry_mutex);
+        auto it = metrics_registry.find(ticker);
+        if (it != metrics_registry.end())
+            return *it->second;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(metrics_registry_mutex);
+    std::unique_ptr<TickerMetrics> &slot = metrics_registry[ticker];
+    if (!slot)
+        slot = std::make_unique<TickerMetrics>();
+    return *slot;
+}
+
+/**
+ * @brief Writes every ticker's metrics in the Prometheus text exposition format.
+ *
+ * Stage latencies are summaries in seconds with 0.5, 0.99 and 0.999 quantiles plus a
+ * separate maximum gauge; work counters are monotonic totals. The RFV warm-start counters
+ * are process-wide, as the parameter cache is.
+ *
+ * @param out Output stream.
+ */
+void write_metrics_prometheus(std::ostream &out)
+{
+    std::shared_lock<std::shared_mutex> lock(metrics_registry_mutex);
+
+    out << "# HELP okb_stage_latency_seconds Latency of each stage of the interpolation pipeline.\n";
+    out << "# TYPE okb_stage_latency_seconds summary\n";
+    for (const auto &[ticker, metrics] : metrics_registry)
+    {
+        for (std::size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i)
+        {
+            const LatencyHistogram &histogram = metrics->stages[i];
+            std::string labels = "ticker=\"" + ticker + "\",stage=\"" + pipeline_stage_name(static_cast<PipelineStage>(i)) + "\"";
+            for (double quantile : METRICS_QUANTILES)
+            {
+                out << "okb_stage_latency_seconds{" << labels << ",quantile=\"" << quantile << "\"} "
+                    << histogram.percentile(quantile * 100) * 1e-9 << "\n";
+            }
+            out << "okb_stage_latency_seconds_sum{" << labels << "} " << histogram.sum() * 1e-9 << "\n";
+            out << "okb_stage_latency_seconds_count{" << labels << "} " << histogram.count() << "\n";
+        }
+    }
+
+    out << "# HELP okb_stage_latency_max_seconds Longest observed latency of each pipeline stage.\n";
+    out << "# TYPE okb_stage_latency_max_seconds gauge\n";
+    for (const auto &[ticker, metrics] : metrics_registry)
+    {
+        for (std::size_t i = 0; i < PIPELINE_STAGE_COUNT; ++i)
+        {
+            out << "okb_stage_latency_max_seconds{ticker=\"" << ticker << "\",stage=\"" << pipeline_stage_name(static_cast<PipelineStage>(i))
+                << "\"} " << metrics->stages[i].max() * 1e-9 << "\n";
+        }
+    }
+
+    const std::pair<const char *, std::atomic<std::uint64_t> TickerMetrics::*> counters[] = {
+        {"okb_pipeline_runs_total", &TickerMetrics::runs},
+        {"okb_iv_evaluations_total", &TickerMetrics::iv_evaluations},
+        {"okb_rfv_function_evaluations_total", &TickerMetrics::rfv_nfev},
+        {"okb_rfv_iterations_total", &TickerMetrics::rfv_nit}};
+    for (const auto &[name, member] : counters)
+    {
+        out << "# TYPE " << name << " counter\n";
+        for (const auto &[ticker, metrics] : metrics_registry)
+        {
+            out << name << "{ticker=\"" << ticker << "\"} " << ((*metrics).*member).load(std::memory_order_relaxed) << "\n";
+        }
+    }
+
+    RFVWarmStartStats warm_starts = get_rfv_warm_start_stats();
+    const std::pair<const char *, long long> warm_start_counters[] = {
+        {"okb_rfv_warm_start_hits_total", warm_starts.hits},
+        {"okb_rfv_warm_start_misses_total", warm_starts.misses},
+        {"okb_rfv_warm_start_fallbacks_total", warm_starts.fallbacks},
+        {"okb_rfv_warm_start_iterations_saved_total", warm_starts.iterations_saved}};
+    for (const auto &[name, value] : warm_start_counters)
+    {
+        out << "# TYPE " << name << " counter\n";
+        out << name << " " << value << "\n";
+    }
+}
+
+/**
+ * @brief Starts timing a pipeline run.
+ *
+ * @param metrics Metrics of the ticker being processed.
+ */
+StageClock::StageClock(TickerMetrics &metrics)
+    : metrics_(metrics), start_(std::chrono::steady_clock::now()), lap_start_(start_)
+{
+}
+
+/**
+ * @brief Resumes timing a pipeline run whose earlier stages were timed by another clock.
+ *
+ * The first lap starts now, while Total also counts the time already spent.
+ *
+ * @param metrics Metrics of the ticker being processed.
+ * @param elapsed Time the run took before this clock, as returned by elapsed().
+ */
+StageClock::StageClock(TickerMetrics &metrics, std::chrono::steady_clock::duration elapsed)
+    : metrics_(metrics), lap_start_(std::chrono::steady_clock::now())
+{
+    start_ = lap_start_ - elapsed;
+}
+
+/**
+ * @brief Records the time since the previous lap (or the start) under a stage.
+ *
+ * @param stage Stage that just finished.
+ */
+void StageClock::lap(PipelineStage stage)
+{
+    auto now = std::chrono::steady_clock::now();
+    metrics_.stages[static_cast<std::size_t>(stage)].record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - lap_start_).count()));
+    lap_start_ = now;
+}
+
+/**
+ * @brief Starts the next lap now, for work that was timed separately.
+ */
+void StageClock::restart()
+{
+    lap_start_ = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Records the whole run under PipelineStage::Total and counts it.
+ */
+void StageClock::finish()
+{
+    auto now = std::chrono::steady_clock::now();
+    metrics_.stages[static_cast<std::size_t>(PipelineStage::Total)].record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count()));
+    metrics_.runs.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Time since the run started.
+ *
+ * @return std::chrono::steady_clock::duration Time to hand to a clock that resumes the run.
+ */
+std::chrono::steady_clock::duration StageClock::elapsed() const
+{
+    return std::chrono::steady_clock::now() - start_;
+}
+
+/**
+ * @brief Starts timing a stage.
+ *
+ * @param metrics Metrics of the ticker being processed.
+ * @param stage Stage the scope runs.
+ */
+StageTimer::StageTimer(TickerMetrics &metrics, PipelineStage stage)
+    : metrics_(metrics), stage_(stage), start_(std::chrono::steady_clock::now())
+{
+}
+
+/**
+ * @brief Records the time since construction under the stage.
+ */
+StageTimer::~StageTimer()
+{
+    metrics_.stages[static_cast<std::size_t>(stage_)].record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_).count()));
+}
+
+/**
+ * @brief Starts the dump thread.
+ *
+ * @param file_path Path of the metrics file.
+ * @param interval Time between dumps.
+ */
+MetricsDumper::MetricsDumper(const std::string &file_path, std::chrono::milliseconds interval)
+    : file_path_(file_path), interval_(interval), stopping_(false)
+{
+    thread_ = std::thread([this]()
+                          {
+                              std::unique_lock<std::mutex> lock(mutex_);
+                              while (!stop_.wait_for(lock, interval_, [this]()
+                                                     { return stopping_; }))
+                              {
+                                  dump();
+                              } });
+}
+
+/**
+ * @brief Stops the dump thread and writes a final dump.
+ */
+MetricsDumper::~MetricsDumper()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stop_.notify_all();
+    thread_.join();
+    dump();
+}
+
+/**
+ * @brief Writes the metrics to a temporary file and renames it over the metrics file.
+ */
+void MetricsDumper::dump() const
+{
+    std::string temporary_path = file_path_ + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Could not write metrics file: " << temporary_path << std::endl;
+            return;
+        }
+        write_metrics_prometheus(file);
+    }
+
+    if (std::rename(temporary_path.c_str(), file_path_.c_str()) != 0)
+    {
+        std::cerr << "Could not replace metrics file: " << file_path_ << std::endl;
+    }
+}
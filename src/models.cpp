@@ -1,40 +1,41 @@
 #include <cmath>
 #include <stdexcept>
 #include <iostream>
+#include <algorithm>
+#include <numbers>
+#include "models.h"
 
 /**
- * @brief Approximation of the error function (erf) using a high-precision method.
+ * @brief Parse an option type configuration string.
  *
- * @param x The input value for which the error function is to be calculated.
- * @return double The calculated error function value.
+ * @param option_type Option type ('calls' or 'puts').
+ * @return OptionKind The parsed option type.
  */
-double approx_erf(double x)
+OptionKind parse_option_kind(const std::string &option_type)
 {
-    const double a1 = 0.254829592;
-    const double a2 = -0.284496736;
-    const double a3 = 1.421413741;
-    const double a4 = -1.453152027;
-    const double a5 = 1.061405429;
-    const double p = 0.3275911;
-
-    int sign = (x >= 0) ? 1 : -1;
-    x = std::fabs(x);
-
-    double t = 1.0 / (1.0 + p * x);
-    double y = 1.0 - (((((a5 * t + a4) * t + a3) * t + a2) * t + a1) * t * std::exp(-x * x));
-
-    return sign * y;
+    if (option_type == "calls")
+    {
+        return OptionKind::Call;
+    }
+    else if (option_type == "puts")
+    {
+        return OptionKind::Put;
+    }
+    else
+    {
+        throw std::invalid_argument("option_type must be 'calls' or 'puts'.");
+    }
 }
 
 /**
- * @brief Approximation of the cumulative distribution function (CDF) for a standard normal distribution.
+ * @brief Configuration string of an option type.
  *
- * @param x The input value for which the CDF is to be calculated.
- * @return double The CDF value.
+ * @param kind Option type.
+ * @return const char* "calls" or "puts".
  */
-double normal_cdf(double x)
+const char *option_kind_name(OptionKind kind)
 {
-    return 0.5 * (1.0 + approx_erf(x / std::sqrt(2.0)));
+    return kind == OptionKind::Call ? "calls" : "puts";
 }
 
 /**
@@ -49,143 +50,214 @@ double normal_cdf(double x)
  * @param option_type Type of option ('calls' or 'puts'). Defaults to 'calls'.
  * @return double The calculated option price.
  */
-inline double barone_adesi_whaley_american_option_price(double S, double K, double T, double r, double sigma, double q = 0.0, const std::string &option_type = "calls")
+double barone_adesi_whaley_american_option_price(double S, double K, double T, double r, double sigma, double q, const std::string &option_type)
 {
-    double M = 2 * (r - q) / (sigma * sigma);
-    double n = 2 * (r - q - 0.5 * sigma * sigma) / (sigma * sigma);
-    double q2 = (-(n - 1) - std::sqrt((n - 1) * (n - 1) + 4 * M)) / 2;
+    return baw_price(parse_option_kind(option_type), S, K, T, r, sigma, q);
+}
 
-    double d1 = (std::log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
-    double d2 = d1 - sigma * std::sqrt(T);
+/**
+ * @brief Calculate the Barone-Adesi Whaley price and greeks of one option.
+ *
+ * @param kind Option type.
+ * @param S Current stock price.
+ * @param K Strike price.
+ * @param T Time to maturity (in years).
+ * @param r Risk-free interest rate (as a decimal).
+ * @param sigma Volatility of the underlying asset.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @return OptionGreeks The price, delta, gamma, vega and theta of the option.
+ */
+OptionGreeks calculate_greeks_baw(OptionKind kind, double S, double K, double T, double r, double sigma, double q)
+{
+    ChainPricingConstants constants = make_chain_pricing_constants(S, r, T, q);
+    return kind == OptionKind::Call ? baw_greeks<OptionKind::Call>(constants, K, std::log(K), sigma)
+                                    : baw_greeks<OptionKind::Put>(constants, K, std::log(K), sigma);
+}
 
-    if (option_type == "calls")
-    {
-        double european_price = S * std::exp(-q * T) * normal_cdf(d1) - K * std::exp(-r * T) * normal_cdf(d2);
-        if (q >= r)
-            return european_price;
-        if (q2 < 0)
-            return european_price;
-        double S_critical = K / (1 - 1 / q2);
-        if (S >= S_critical)
-            return S - K;
-        else
-        {
-            double A2 = (S_critical - K) * std::pow(S_critical, -q2);
-            return european_price + A2 * std::pow(S / S_critical, q2);
-        }
-    }
-    else if (option_type == "puts")
-    {
-        double european_price = K * std::exp(-r * T) * normal_cdf(-d2) - S * std::exp(-q * T) * normal_cdf(-d1);
-        if (q >= r)
-            return european_price;
-        if (q2 < 0)
-            return european_price;
-        double S_critical = K / (1 + 1 / q2);
-        if (S <= S_critical)
-            return K - S;
-        else
-        {
-            double A2 = (K - S_critical) * std::pow(S_critical, -q2);
-            return european_price + A2 * std::pow(S / S_critical, q2);
-        }
-    }
-    else
-    {
-        throw std::invalid_argument("option_type must be 'calls' or 'puts'.");
-    }
+/**
+ * @brief Barone-Adesi Whaley price and sensitivities with the option type resolved at compile time.
+ *
+ * @tparam Kind Option type.
+ * @param S Current stock price.
+ * @param K Strike price.
+ * @param T Time to maturity (in years).
+ * @param r Risk-free interest rate (as a decimal).
+ * @param sigma Volatility of the underlying asset.
+ * @param q Continuous dividend yield.
+ * @return OptionSensitivities The price and its partial derivatives.
+ */
+template <OptionKind Kind>
+static OptionSensitivities calculate_sensitivities(double S, double K, double T, double r, double sigma, double q)
+{
+    using Scalar = Dual<5>;
+
+    Scalar price = baw_price<Kind>(
+        Scalar::variable(S, 0),
+        Scalar(K),
+        Scalar::variable(T, 1),
+        Scalar::variable(r, 2),
+        Scalar::variable(sigma, 3),
+        Scalar::variable(q, 4));
+
+    OptionSensitivities sensitivities;
+    sensitivities.price = price.value;
+    sensitivities.delta = price.grad[0];
+    sensitivities.theta = -price.grad[1];
+    sensitivities.rho = price.grad[2];
+    sensitivities.vega = price.grad[3];
+    sensitivities.dividend_rho = price.grad[4];
+    return sensitivities;
 }
 
 /**
- * @brief Calculate the delta of an American option using the Black-Scholes formula with custom normal CDF and dividend yield.
+ * @brief Calculate the Barone-Adesi Whaley price and its sensitivities to S, T, r, sigma and q in one evaluation.
  *
+ * Uses forward-mode automatic differentiation of baw_price, so the derivatives are exact for the
+ * implemented formula and need no bumped repricing.
+ *
+ * @param kind Option type.
  * @param S Current stock price.
  * @param K Strike price.
  * @param T Time to maturity (in years).
  * @param r Risk-free interest rate (as a decimal).
  * @param sigma Volatility of the underlying asset.
  * @param q Continuous dividend yield (default is 0.0).
- * @param option_type Option type ('calls' or 'puts').
- * @return double The delta of the option.
+ * @return OptionSensitivities The price, delta, vega, rho, theta and dividend rho of the option.
  */
-double calculate_delta(double S, double K, double T, double r, double sigma, double q = 0.0, const std::string &option_type = "calls")
+OptionSensitivities calculate_sensitivities_baw(OptionKind kind, double S, double K, double T, double r, double sigma, double q)
 {
-    double d1 = (std::log(S / K) + (r - q + 0.5 * sigma * sigma) * T) / (sigma * std::sqrt(T));
+    return kind == OptionKind::Call ? calculate_sensitivities<OptionKind::Call>(S, K, T, r, sigma, q)
+                                    : calculate_sensitivities<OptionKind::Put>(S, K, T, r, sigma, q);
+}
 
-    if (option_type == "calls")
+/**
+ * @brief Greeks of every strike of a chain with the option type resolved at compile time.
+ *
+ * @tparam Kind Option type.
+ * @param constants Chain-level pricing constants.
+ * @param strikes Strike prices of the chain.
+ * @param implied_vols Implied volatility of each strike.
+ * @param greeks Output array receiving the greeks of each strike.
+ * @param count Number of strikes.
+ */
+template <OptionKind Kind>
+static void calculate_greeks_chain(const ChainPricingConstants &constants, const double *strikes, const double *implied_vols, OptionGreeks *greeks, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i)
     {
-        return normal_cdf(d1);
+        greeks[i] = baw_greeks<Kind>(constants, strikes[i], std::log(strikes[i]), implied_vols[i]);
     }
-    else if (option_type == "puts")
+}
+
+/**
+ * @brief Calculate the Barone-Adesi Whaley price and greeks of a whole option chain in one pass.
+ *
+ * The chain constants are computed once and every strike costs one analytic evaluation,
+ * instead of the five or more pricing calls of the finite-difference greeks.
+ *
+ * @param strikes Strike prices of the chain.
+ * @param implied_vols Implied volatility of each strike.
+ * @param greeks Output array receiving the greeks of each strike.
+ * @param count Number of strikes in the chain.
+ * @param S Current stock price.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @param option_kind Option type. Defaults to calls.
+ */
+void calculate_greeks_baw_batch(
+    const double *strikes,
+    const double *implied_vols,
+    OptionGreeks *greeks,
+    std::size_t count,
+    double S,
+    double r,
+    double T,
+    double q,
+    OptionKind option_kind)
+{
+    ChainPricingConstants constants = make_chain_pricing_constants(S, r, T, q);
+
+    if (option_kind == OptionKind::Call)
     {
-        return normal_cdf(d1) - 1.0;
+        calculate_greeks_chain<OptionKind::Call>(constants, strikes, implied_vols, greeks, count);
     }
     else
     {
-        throw std::invalid_argument("option_type must be 'calls' or 'puts'.");
+        calculate_greeks_chain<OptionKind::Put>(constants, strikes, implied_vols, greeks, count);
     }
 }
 
 /**
- * @brief Calculate the gamma of an American option using numerical differentiation.
+ * @brief Calculate the delta of an option from the analytic Barone-Adesi Whaley greeks (the European delta, see baw_greeks).
  *
+ * @tparam Kind Option type.
  * @param S Current stock price.
  * @param K Strike price.
  * @param T Time to maturity (in years).
  * @param r Risk-free interest rate (as a decimal).
  * @param sigma Volatility of the underlying asset.
  * @param q Continuous dividend yield (default is 0.0).
- * @param option_type Option type ('calls' or 'puts').
- * @return double The gamma of the option.
+ * @return double The delta of the option.
  */
-double calculate_gamma(double S, double K, double T, double r, double sigma, double q = 0.0, const std::string &option_type = "calls")
+template <OptionKind Kind>
+double calculate_delta(double S, double K, double T, double r, double sigma, double q)
 {
-    double h = 1e-4;
-
-    double price_plus = barone_adesi_whaley_american_option_price(S + h, K, T, r, sigma, q, option_type);
-    double price = barone_adesi_whaley_american_option_price(S, K, T, r, sigma, q, option_type);
-    double price_minus = barone_adesi_whaley_american_option_price(S - h, K, T, r, sigma, q, option_type);
+    return baw_greeks<Kind>(make_chain_pricing_constants(S, r, T, q), K, std::log(K), sigma).delta;
+}
 
-    return (price_plus - 2 * price + price_minus) / (h * h);
+/**
+ * @brief Calculate the gamma of an option from the analytic Barone-Adesi Whaley greeks (the European gamma, see baw_greeks).
+ *
+ * @tparam Kind Option type.
+ * @param S Current stock price.
+ * @param K Strike price.
+ * @param T Time to maturity (in years).
+ * @param r Risk-free interest rate (as a decimal).
+ * @param sigma Volatility of the underlying asset.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @return double The gamma of the option.
+ */
+template <OptionKind Kind>
+double calculate_gamma(double S, double K, double T, double r, double sigma, double q)
+{
+    return baw_greeks<Kind>(make_chain_pricing_constants(S, r, T, q), K, std::log(K), sigma).gamma;
 }
 
 /**
- * @brief Calculate the vega of an American option using numerical differentiation.
+ * @brief Calculate the vega of an option from the analytic Barone-Adesi Whaley greeks (the European vega, see baw_greeks).
  *
+ * @tparam Kind Option type.
  * @param S Current stock price.
  * @param K Strike price.
  * @param T Time to maturity (in years).
  * @param r Risk-free interest rate (as a decimal).
  * @param sigma Volatility of the underlying asset.
  * @param q Continuous dividend yield (default is 0.0).
- * @param option_type Option type ('calls' or 'puts').
  * @return double The vega of the option.
  */
-double calculate_vega(double S, double K, double T, double r, double sigma, double q = 0.0, const std::string &option_type = "calls")
+template <OptionKind Kind>
+double calculate_vega(double S, double K, double T, double r, double sigma, double q)
 {
-    double h = 1e-4;
-
-    double price_plus = barone_adesi_whaley_american_option_price(S, K, T, r, sigma + h, q, option_type);
-    double price_minus = barone_adesi_whaley_american_option_price(S, K, T, r, sigma - h, q, option_type);
-
-    return (price_plus - price_minus) / (2 * h);
+    return baw_greeks<Kind>(make_chain_pricing_constants(S, r, T, q), K, std::log(K), sigma).vega;
 }
 
 /**
  * @brief Calculate the implied volatility using the Barone-Adesi Whaley model with dividends.
  *
+ * @tparam Kind Option type.
  * @param option_price Observed option price (mid-price).
  * @param S Current stock price.
  * @param K Strike price of the option.
  * @param r Risk-free interest rate.
  * @param T Time to expiration in years.
  * @param q Continuous dividend yield (default is 0.0).
- * @param option_type Option type ('calls' or 'puts'). Defaults to 'calls'.
  * @param max_iterations Maximum number of iterations for the bisection method. Defaults to 100.
  * @param tolerance Convergence tolerance. Defaults to 1e-8.
  * @return double The implied volatility.
  */
-double calculate_implied_volatility_baw(double option_price, double S, double K, double r, double T, double q = 0.0, const std::string &option_type = "calls", int max_iterations = 100, double tolerance = 1e-8)
+template <OptionKind Kind>
+double implied_volatility_baw(double option_price, double S, double K, double r, double T, double q, int max_iterations, double tolerance)
 {
     double lower_vol = 1e-5;
     double upper_vol = 10.0;
@@ -193,7 +265,7 @@ double calculate_implied_volatility_baw(double option_price, double S, double K,
     for (int i = 0; i < max_iterations; ++i)
     {
         double mid_vol = (lower_vol + upper_vol) / 2;
-        double price = barone_adesi_whaley_american_option_price(S, K, T, r, mid_vol, q, option_type);
+        double price = baw_price<Kind>(S, K, T, r, mid_vol, q);
 
         if (std::fabs(price - option_price) < tolerance)
         {
@@ -217,3 +289,577 @@ double calculate_implied_volatility_baw(double option_price, double S, double K,
 
     return (lower_vol + upper_vol) / 2;
 }
+
+/**
+ * @brief Calculate the implied volatility using the Barone-Adesi Whaley model with dividends.
+ *
+ * @param option_price Observed option price (mid-price).
+ * @param S Current stock price.
+ * @param K Strike price of the option.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @param option_type Option type ('calls' or 'puts'). Defaults to 'calls'.
+ * @param max_iterations Maximum number of iterations for the bisection method. Defaults to 100.
+ * @param tolerance Convergence tolerance. Defaults to 1e-8.
+ * @return double The implied volatility.
+ */
+double calculate_implied_volatility_baw(double option_price, double S, double K, double r, double T, double q, const std::string &option_type, int max_iterations, double tolerance)
+{
+    if (parse_option_kind(option_type) == OptionKind::Call)
+    {
+        return implied_volatility_baw<OptionKind::Call>(option_price, S, K, r, T, q, max_iterations, tolerance);
+    }
+    return implied_volatility_baw<OptionKind::Put>(option_price, S, K, r, T, q, max_iterations, tolerance);
+}
+
+/**
+ * @brief Number of strikes solved together by the batched implied volatility solver.
+ *
+ * Eight doubles fill one AVX-512 register or two AVX2 registers, which lets the
+ * compiler vectorize the per-lane loops below.
+ */
+constexpr int IV_BATCH_LANES = 8;
+
+/**
+ * @brief Precompute the pricing inputs that are shared by every strike of a chain.
+ *
+ * @param S Current stock price.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield.
+ * @return ChainPricingConstants The chain-level constants.
+ */
+ChainPricingConstants make_chain_pricing_constants(double S, double r, double T, double q)
+{
+    ChainPricingConstants constants;
+    constants.S = S;
+    constants.r = r;
+    constants.T = T;
+    constants.q = q;
+    constants.sqrt_T = std::sqrt(T);
+    constants.log_S = std::log(S);
+    constants.discount_r = std::exp(-r * T);
+    constants.discount_q = std::exp(-q * T);
+    return constants;
+}
+
+/**
+ * @brief Solve the implied volatilities of up to IV_BATCH_LANES strikes at once by lane-parallel bisection.
+ *
+ * Every lane follows exactly the same bisection as calculate_implied_volatility_baw; lanes
+ * that have converged keep their result while the others continue. The price of all lanes is
+ * computed branch-free so the loop vectorizes; it is the European price, as in baw_price,
+ * whose early-exercise premium never applies with its q2 root.
+ *
+ * @param c Chain-level pricing constants.
+ * @param option_prices Observed option prices of the block.
+ * @param strikes Strike prices of the block.
+ * @param implied_vols Output implied volatilities of the block.
+ * @param count Number of valid lanes in the block.
+ * @param max_iterations Maximum number of bisection iterations.
+ * @param tolerance Convergence tolerance.
+ * @param evaluations Optional output receiving the number of price evaluations of each lane.
+ */
+template <OptionKind Kind>
+static void solve_implied_volatility_lanes(
+    const ChainPricingConstants &c,
+    const double *option_prices,
+    const double *strikes,
+    double *implied_vols,
+    int count,
+    int max_iterations,
+    double tolerance,
+    int *evaluations)
+{
+    constexpr double sign = Kind == OptionKind::Call ? 1.0 : -1.0;
+
+    double target[IV_BATCH_LANES];
+    double K[IV_BATCH_LANES];
+    double log_K[IV_BATCH_LANES];
+    double lower_vol[IV_BATCH_LANES];
+    double upper_vol[IV_BATCH_LANES];
+    double mid_vol[IV_BATCH_LANES];
+    double price[IV_BATCH_LANES];
+    double result[IV_BATCH_LANES];
+    int iterations[IV_BATCH_LANES];
+    bool done[IV_BATCH_LANES];
+
+    for (int l = 0; l < IV_BATCH_LANES; ++l)
+    {
+        bool valid = l < count;
+        target[l] = valid ? option_prices[l] : 0.0;
+        K[l] = valid ? strikes[l] : c.S;
+        log_K[l] = std::log(K[l]);
+        lower_vol[l] = 1e-5;
+        upper_vol[l] = 10.0;
+        result[l] = 0.0;
+        iterations[l] = 0;
+        done[l] = !valid;
+    }
+
+    for (int i = 0; i < max_iterations; ++i)
+    {
+        for (int l = 0; l < IV_BATCH_LANES; ++l)
+        {
+            mid_vol[l] = (lower_vol[l] + upper_vol[l]) / 2;
+        }
+
+        for (int l = 0; l < IV_BATCH_LANES; ++l)
+        {
+            double sigma2 = mid_vol[l] * mid_vol[l];
+            double sigma_sqrt_T = mid_vol[l] * c.sqrt_T;
+            double d1 = (c.log_S - log_K[l] + (c.r - c.q + 0.5 * sigma2) * c.T) / sigma_sqrt_T;
+            double d2 = d1 - sigma_sqrt_T;
+            price[l] = sign * (c.S * c.discount_q * normal_cdf(sign * d1) - K[l] * c.discount_r * normal_cdf(sign * d2));
+        }
+
+        bool all_done = true;
+        for (int l = 0; l < IV_BATCH_LANES; ++l)
+        {
+            iterations[l] += done[l] ? 0 : 1;
+
+            bool hit = !done[l] && std::fabs(price[l] - target[l]) < tolerance;
+            result[l] = hit ? mid_vol[l] : result[l];
+            done[l] = done[l] || hit;
+
+            bool above = price[l] > target[l];
+            upper_vol[l] = (!done[l] && above) ? mid_vol[l] : upper_vol[l];
+            lower_vol[l] = (!done[l] && !above) ? mid_vol[l] : lower_vol[l];
+
+            bool narrow = !done[l] && upper_vol[l] - lower_vol[l] < tolerance;
+            result[l] = narrow ? (lower_vol[l] + upper_vol[l]) / 2 : result[l];
+            done[l] = done[l] || narrow;
+
+            all_done = all_done && done[l];
+        }
+
+        if (all_done)
+        {
+            break;
+        }
+    }
+
+    for (int l = 0; l < count; ++l)
+    {
+        implied_vols[l] = done[l] ? result[l] : (lower_vol[l] + upper_vol[l]) / 2;
+        if (evaluations != nullptr)
+        {
+            evaluations[l] = iterations[l];
+        }
+    }
+}
+
+/**
+ * @brief Initial implied volatility guess from closed-form approximations.
+ *
+ * Near the money the Corrado-Miller approximation is used, with puts mapped to
+ * calls through put-call parity. Far from the money, where it has no real
+ * solution, the leading terms of the small-volatility expansion of the normalized
+ * Black price are inverted for the out-of-the-money time value by a few
+ * fixed-point steps.
+ *
+ * @param c Chain-level pricing constants.
+ * @param option_price Observed option price.
+ * @param K Strike price of the option.
+ * @return double The initial volatility guess.
+ */
+template <OptionKind Kind>
+static double initial_volatility_guess(const ChainPricingConstants &c, double option_price, double K)
+{
+    double forward_S = c.S * c.discount_q;
+    double forward_K = K * c.discount_r;
+    double call_price = Kind == OptionKind::Call ? option_price : option_price + forward_S - forward_K;
+
+    double half_moneyness = (forward_S - forward_K) / 2;
+    double adjusted = call_price - half_moneyness;
+    double discriminant = adjusted * adjusted - (forward_S - forward_K) * (forward_S - forward_K) / std::numbers::pi;
+
+    if (discriminant >= 0)
+    {
+        double sigma = std::sqrt(2 * std::numbers::pi) / (forward_S + forward_K) * (adjusted + std::sqrt(discriminant)) / c.sqrt_T;
+        if (sigma > 0 && std::isfinite(sigma))
+        {
+            return sigma;
+        }
+    }
+
+    double x = std::fabs(std::log(forward_S / forward_K));
+    double time_value = call_price - std::max(forward_S - forward_K, 0.0);
+    double log_b = std::log(time_value / std::sqrt(forward_S * forward_K));
+    if (x <= 0 || log_b >= 0)
+    {
+        return std::sqrt(2 * std::numbers::pi / c.T) * option_price / c.S;
+    }
+
+    double s = x / std::sqrt(-2 * log_b);
+    for (int i = 0; i < 4; ++i)
+    {
+        double denominator = 2 * (3 * std::log(s) - 2 * std::log(x) - 0.5 * std::log(2 * std::numbers::pi) - s * s / 8 - log_b);
+        if (denominator <= 0)
+        {
+            break;
+        }
+        s = x / std::sqrt(denominator);
+    }
+
+    return s / c.sqrt_T;
+}
+
+/**
+ * @brief Solve one implied volatility with safeguarded Halley/Newton steps.
+ *
+ * Steps use the analytic vega and volga of the European formula. The bracket
+ * [1e-5, 10] is narrowed after every evaluation and a bisection step is taken
+ * whenever a step would leave it.
+ *
+ * @param c Chain-level pricing constants.
+ * @param option_price Observed option price.
+ * @param K Strike price of the option.
+ * @param max_iterations Maximum number of price evaluations.
+ * @param tolerance Convergence tolerance.
+ * @param evaluations Optional output receiving the number of price evaluations.
+ * @return double The implied volatility.
+ */
+template <OptionKind Kind>
+static double solve_implied_volatility_newton(
+    const ChainPricingConstants &c,
+    double option_price,
+    double K,
+    int max_iterations,
+    double tolerance,
+    int *evaluations)
+{
+    double lower_vol = 1e-5;
+    double upper_vol = 10.0;
+    double log_K = std::log(K);
+    int count = 0;
+
+    constexpr double sign = Kind == OptionKind::Call ? 1.0 : -1.0;
+    double floor_price = std::max(sign * (c.S * c.discount_q - K * c.discount_r), 0.0);
+    if (option_price <= floor_price)
+    {
+        if (evaluations != nullptr)
+        {
+            *evaluations = 0;
+        }
+        return lower_vol;
+    }
+
+    double sigma = std::clamp(initial_volatility_guess<Kind>(c, option_price, K), lower_vol, upper_vol);
+
+    while (count < max_iterations)
+    {
+        double price = baw_price<Kind>(c, K, log_K, sigma);
+        ++count;
+
+        double diff = price - option_price;
+        if (std::fabs(diff) < tolerance)
+        {
+            break;
+        }
+
+        if (diff > 0)
+        {
+            upper_vol = sigma;
+        }
+        else
+        {
+            lower_vol = sigma;
+        }
+
+        if (upper_vol - lower_vol < tolerance)
+        {
+            sigma = (lower_vol + upper_vol) / 2;
+            break;
+        }
+
+        double sigma_sqrt_T = sigma * c.sqrt_T;
+        double d1 = (c.log_S - log_K + (c.r - c.q + 0.5 * sigma * sigma) * c.T) / sigma_sqrt_T;
+        double d2 = d1 - sigma_sqrt_T;
+        double vega = c.S * c.discount_q * normal_pdf(d1) * c.sqrt_T;
+
+        double next_sigma = (lower_vol + upper_vol) / 2;
+        double time_value = price - floor_price;
+        if (vega > 1e-12 && time_value > 0)
+        {
+            // The time value is strongly convex in sigma away from the money, so the
+            // steps are taken on its logarithm, which is close to linear.
+            double vega_ratio = vega / time_value;
+            double step = std::log(time_value / (option_price - floor_price)) / vega_ratio;
+            double curvature = d1 * d2 / sigma - vega_ratio;
+            double halley_denominator = 1 - 0.5 * step * curvature;
+            double candidate = halley_denominator > 0.5 ? sigma - step / halley_denominator : sigma - step;
+            if (candidate > lower_vol && candidate < upper_vol)
+            {
+                next_sigma = candidate;
+            }
+        }
+
+        if (std::fabs(next_sigma - sigma) < tolerance)
+        {
+            sigma = next_sigma;
+            break;
+        }
+
+        sigma = next_sigma;
+    }
+
+    if (evaluations != nullptr)
+    {
+        *evaluations = count;
+    }
+
+    return sigma;
+}
+
+/**
+ * @brief Calculate the implied volatility using the Barone-Adesi Whaley model with a Halley/Newton solver.
+ *
+ * Starts from a closed-form approximation and typically converges in two to four price
+ * evaluations, falling back to bisection steps whenever an update leaves the bracket.
+ *
+ * @tparam Kind Option type.
+ * @param option_price Observed option price (mid-price).
+ * @param S Current stock price.
+ * @param K Strike price of the option.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @param evaluations Optional output receiving the number of price evaluations used.
+ * @param max_iterations Maximum number of price evaluations. Defaults to 50.
+ * @param tolerance Convergence tolerance. Defaults to 1e-8.
+ * @return double The implied volatility.
+ */
+template <OptionKind Kind>
+double implied_volatility_baw_newton(double option_price, double S, double K, double r, double T, double q, int *evaluations, int max_iterations, double tolerance)
+{
+    ChainPricingConstants constants = make_chain_pricing_constants(S, r, T, q);
+    return solve_implied_volatility_newton<Kind>(constants, option_price, K, max_iterations, tolerance, evaluations);
+}
+
+/**
+ * @brief Calculate the implied volatility using the Barone-Adesi Whaley model with a Halley/Newton solver.
+ *
+ * @param option_price Observed option price (mid-price).
+ * @param S Current stock price.
+ * @param K Strike price of the option.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @param option_type Option type ('calls' or 'puts'). Defaults to 'calls'.
+ * @param evaluations Optional output receiving the number of price evaluations used.
+ * @param max_iterations Maximum number of price evaluations. Defaults to 50.
+ * @param tolerance Convergence tolerance. Defaults to 1e-8.
+ * @return double The implied volatility.
+ */
+double calculate_implied_volatility_baw_newton(double option_price, double S, double K, double r, double T, double q, const std::string &option_type, int *evaluations, int max_iterations, double tolerance)
+{
+    if (parse_option_kind(option_type) == OptionKind::Call)
+    {
+        return implied_volatility_baw_newton<OptionKind::Call>(option_price, S, K, r, T, q, evaluations, max_iterations, tolerance);
+    }
+    return implied_volatility_baw_newton<OptionKind::Put>(option_price, S, K, r, T, q, evaluations, max_iterations, tolerance);
+}
+
+/**
+ * @brief Solve the implied volatilities of a whole chain for one option type.
+ *
+ * When rows is given, only the listed rows of the chain are solved: option_prices, strikes
+ * and implied_vols are indexed by row, and evaluations by position in rows. Bisection
+ * blocks are gathered into lane buffers on the stack and scattered back.
+ *
+ * @tparam Kind Option type.
+ * @param constants Chain-level pricing constants.
+ * @param option_prices Observed option prices, one per strike.
+ * @param strikes Strike prices of the chain.
+ * @param implied_vols Output array receiving one implied volatility per strike.
+ * @param rows Optional rows to solve; nullptr solves rows 0 to count - 1.
+ * @param count Number of strikes to solve.
+ * @param max_iterations Maximum number of iterations of the solver.
+ * @param tolerance Convergence tolerance.
+ * @param mode Root finder to use.
+ * @param evaluations Optional output array receiving the number of price evaluations per strike.
+ */
+template <OptionKind Kind>
+static void solve_implied_volatility_chain(
+    const ChainPricingConstants &constants,
+    const double *option_prices,
+    const double *strikes,
+    double *implied_vols,
+    const std::size_t *rows,
+    std::size_t count,
+    int max_iterations,
+    double tolerance,
+    IVSolverMode mode,
+    int *evaluations)
+{
+    if (mode == IVSolverMode::Newton)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::size_t row = rows != nullptr ? rows[i] : i;
+            implied_vols[row] = solve_implied_volatility_newton<Kind>(
+                constants,
+                option_prices[row],
+                strikes[row],
+                max_iterations,
+                tolerance,
+                evaluations != nullptr ? evaluations + i : nullptr);
+        }
+        return;
+    }
+
+    for (std::size_t offset = 0; offset < count; offset += IV_BATCH_LANES)
+    {
+        int lanes = static_cast<int>(std::min<std::size_t>(IV_BATCH_LANES, count - offset));
+        int *lane_evaluations = evaluations != nullptr ? evaluations + offset : nullptr;
+
+        if (rows == nullptr)
+        {
+            solve_implied_volatility_lanes<Kind>(
+                constants,
+                option_prices + offset,
+                strikes + offset,
+                implied_vols + offset,
+                lanes,
+                max_iterations,
+                tolerance,
+                lane_evaluations);
+            continue;
+        }
+
+        double lane_prices[IV_BATCH_LANES];
+        double lane_strikes[IV_BATCH_LANES];
+        double lane_vols[IV_BATCH_LANES];
+        for (int l = 0; l < lanes; ++l)
+        {
+            lane_prices[l] = option_prices[rows[offset + l]];
+            lane_strikes[l] = strikes[rows[offset + l]];
+        }
+
+        solve_implied_volatility_lanes<Kind>(
+            constants,
+            lane_prices,
+            lane_strikes,
+            lane_vols,
+            lanes,
+            max_iterations,
+            tolerance,
+            lane_evaluations);
+
+        for (int l = 0; l < lanes; ++l)
+        {
+            implied_vols[rows[offset + l]] = lane_vols[l];
+        }
+    }
+}
+
+/**
+ * @brief Calculate the implied volatilities of a whole option chain using the Barone-Adesi Whaley model.
+ *
+ * The chain constants are computed once and the option type is resolved once, so the
+ * solver loops run on a fully specialized pricer. In bisection mode the strikes are solved
+ * IV_BATCH_LANES at a time, producing the same results as calling
+ * calculate_implied_volatility_baw for every strike.
+ *
+ * @param option_prices Observed option prices, one per strike.
+ * @param strikes Strike prices of the chain.
+ * @param implied_vols Output array receiving one implied volatility per strike.
+ * @param count Number of strikes in the chain.
+ * @param S Current stock price.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @param option_kind Option type. Defaults to calls.
+ * @param max_iterations Maximum number of iterations of the solver. Defaults to 100.
+ * @param tolerance Convergence tolerance. Defaults to 1e-8.
+ * @param mode Root finder to use. Defaults to lane-parallel bisection.
+ * @param evaluations Optional output array receiving the number of price evaluations per strike.
+ */
+void calculate_implied_volatility_baw_batch(
+    const double *option_prices,
+    const double *strikes,
+    double *implied_vols,
+    std::size_t count,
+    double S,
+    double r,
+    double T,
+    double q,
+    OptionKind option_kind,
+    int max_iterations,
+    double tolerance,
+    IVSolverMode mode,
+    int *evaluations)
+{
+    ChainPricingConstants constants = make_chain_pricing_constants(S, r, T, q);
+
+    if (option_kind == OptionKind::Call)
+    {
+        solve_implied_volatility_chain<OptionKind::Call>(constants, option_prices, strikes, implied_vols, nullptr, count, max_iterations, tolerance, mode, evaluations);
+    }
+    else
+    {
+        solve_implied_volatility_chain<OptionKind::Put>(constants, option_prices, strikes, implied_vols, nullptr, count, max_iterations, tolerance, mode, evaluations);
+    }
+}
+
+/**
+ * @brief Calculate the implied volatilities of selected rows of an option chain using the Barone-Adesi Whaley model.
+ *
+ * Same solver as calculate_implied_volatility_baw_batch, restricted to the rows of a
+ * selection so that filtered chains do not have to be compacted before solving.
+ *
+ * @param option_prices Observed option prices, indexed by row.
+ * @param strikes Strike prices of the chain, indexed by row.
+ * @param implied_vols Output array receiving the implied volatility of each selected row.
+ * @param rows Rows to solve.
+ * @param count Number of rows to solve.
+ * @param S Current stock price.
+ * @param r Risk-free interest rate.
+ * @param T Time to expiration in years.
+ * @param q Continuous dividend yield (default is 0.0).
+ * @param option_kind Option type. Defaults to calls.
+ * @param max_iterations Maximum number of iterations of the solver. Defaults to 100.
+ * @param tolerance Convergence tolerance. Defaults to 1e-8.
+ * @param mode Root finder to use. Defaults to lane-parallel bisection.
+ * @param evaluations Optional output array receiving the number of price evaluations, indexed by position in rows.
+ */
+void calculate_implied_volatility_baw_selection(
+    const double *option_prices,
+    const double *strikes,
+    double *implied_vols,
+    const std::size_t *rows,
+    std::size_t count,
+    double S,
+    double r,
+    double T,
+    double q,
+    OptionKind option_kind,
+    int max_iterations,
+    double tolerance,
+    IVSolverMode mode,
+    int *evaluations)
+{
+    ChainPricingConstants constants = make_chain_pricing_constants(S, r, T, q);
+
+    if (option_kind == OptionKind::Call)
+    {
+        solve_implied_volatility_chain<OptionKind::Call>(constants, option_prices, strikes, implied_vols, rows, count, max_iterations, tolerance, mode, evaluations);
+    }
+    else
+    {
+        solve_implied_volatility_chain<OptionKind::Put>(constants, option_prices, strikes, implied_vols, rows, count, max_iterations, tolerance, mode, evaluations);
+    }
+}
+
+template double calculate_delta<OptionKind::Call>(double, double, double, double, double, double);
+template double calculate_delta<OptionKind::Put>(double, double, double, double, double, double);
+template double calculate_gamma<OptionKind::Call>(double, double, double, double, double, double);
+template double calculate_gamma<OptionKind::Put>(double, double, double, double, double, double);
+template double calculate_vega<OptionKind::Call>(double, double, double, double, double, double);
+template double calculate_vega<OptionKind::Put>(double, double, double, double, double, double);
+template double implied_volatility_baw<OptionKind::Call>(double, double, double, double, double, double, int, double);
+template double implied_volatility_baw<OptionKind::Put>(double, double, double, double, double, double, int, double);
+template double implied_volatility_baw_newton<OptionKind::Call>(double, double, double, double, double, double, int *, int, double);
+template double implied_volatility_baw_newton<OptionKind::Put>(double, double, double, double, double, double, int *, int, double);
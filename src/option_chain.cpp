@@ -0,0 +1,150 @@
+#include "option_chain.h"
+
+/**
+ * @brief Number of strikes in the chain.
+ *
+ * @return std::size_t The number of rows.
+ */
+std::size_t OptionChain::size() const
+{
+    return strike.size();
+}
+
+/**
+ * @brief Checks whether the chain has no strikes.
+ *
+ * @return bool True if the chain is empty.
+ */
+bool OptionChain::empty() const
+{
+    return strike.empty();
+}
+
+/**
+ * @brief Removes every row while keeping the allocated capacity.
+ */
+void OptionChain::clear()
+{
+    resize(0);
+}
+
+/**
+ * @brief Reserves capacity for n rows in every column.
+ *
+ * @param n Number of rows to reserve.
+ */
+void OptionChain::reserve(std::size_t n)
+{
+    strike.reserve(n);
+    bid.reserve(n);
+    ask.reserve(n);
+    mid.reserve(n);
+    open_interest.reserve(n);
+    bid_iv.reserve(n);
+    ask_iv.reserve(n);
+    mid_iv.reserve(n);
+}
+
+/**
+ * @brief Resizes every column to n rows.
+ *
+ * @param n New number of rows.
+ */
+void OptionChain::resize(std::size_t n)
+{
+    strike.resize(n);
+    bid.resize(n);
+    ask.resize(n);
+    mid.resize(n);
+    open_interest.resize(n);
+    bid_iv.resize(n);
+    ask_iv.resize(n);
+    mid_iv.resize(n);
+}
+
+/**
+ * @brief Appends a quote as a new row.
+ *
+ * @param strike_price Strike price of the quote.
+ * @param quote Quote values for that strike.
+ */
+void OptionChain::push_back(double strike_price, const QuoteData &quote)
+{
+    strike.push_back(strike_price);
+    bid.push_back(quote.bid);
+    ask.push_back(quote.ask);
+    mid.push_back(quote.mid);
+    open_interest.push_back(quote.open_interest);
+    bid_iv.push_back(quote.bid_IV);
+    ask_iv.push_back(quote.ask_IV);
+    mid_iv.push_back(quote.mid_IV);
+}
+
+/**
+ * @brief Views a chain column as an Eigen vector without copying it.
+ *
+ * The view is invalidated when the chain is resized.
+ *
+ * @param column Column of an OptionChain.
+ * @return ChainColumn Writable Eigen map over the column.
+ */
+ChainColumn mutable_column_view(std::vector<double> &column)
+{
+    return ChainColumn(column.data(), static_cast<Eigen::Index>(column.size()));
+}
+
+/**
+ * @brief Views a chain column as a read-only Eigen vector without copying it.
+ *
+ * The view is invalidated when the chain is resized.
+ *
+ * @param column Column of an OptionChain.
+ * @return ConstChainColumn Read-only Eigen map over the column.
+ */
+ConstChainColumn column_view(const std::vector<double> &column)
+{
+    return ConstChainColumn(column.data(), static_cast<Eigen::Index>(column.size()));
+}
+
+/**
+ * @brief Fills a chain from a strike-keyed quote map.
+ *
+ * The map is already ordered by strike, so the chain comes out sorted. Existing capacity of
+ * the chain is reused.
+ *
+ * @param quotes Map of strike prices to QuoteData objects.
+ * @param chain Chain to fill; its previous contents are discarded.
+ */
+void load_option_chain(const std::map<double, QuoteData> &quotes, OptionChain &chain)
+{
+    chain.clear();
+    chain.reserve(quotes.size());
+    for (const auto &pair : quotes)
+    {
+        chain.push_back(pair.first, pair.second);
+    }
+}
+
+/**
+ * @brief Copies the given rows of a chain into another chain.
+ *
+ * @param chain Source chain.
+ * @param rows Row indices to copy, in the order they should appear.
+ * @param selected Destination chain; its previous contents are discarded.
+ */
+void select_rows(const OptionChain &chain, const std::vector<std::size_t> &rows, OptionChain &selected)
+{
+    selected.resize(rows.size());
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        std::size_t row = rows[i];
+        selected.strike[i] = chain.strike[row];
+        selected.bid[i] = chain.bid[row];
+        selected.ask[i] = chain.ask[row];
+        selected.mid[i] = chain.mid[row];
+        selected.open_interest[i] = chain.open_interest[row];
+        selected.bid_iv[i] = chain.bid_iv[row];
+        selected.ask_iv[i] = chain.ask_iv[row];
+        selected.mid_iv[i] = chain.mid_iv[row];
+    }
+}
@@ -0,0 +1,384 @@
+#include "output_writer.h"
+#include <charconv>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "trace.h"
+
+/**
+ * @brief Global writer of the smile outputs, started by main.
+ */
+OutputWriter output_writer;
+
+/**
+ * @brief Magic bytes at the start of a binary smile file.
+ */
+static const char SMILE_MAGIC[8] = {'O', 'K', 'B', 'S', 'M', 'I', 'L', '1'};
+
+/**
+ * @brief Appends a 32-bit word in little-endian order.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_fixed32(std::uint32_t value, std::string &out)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Appends a 64-bit word in little-endian order.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_fixed64(std::uint64_t value, std::string &out)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Appends a string prefixed with its 32-bit length.
+ *
+ * @param value String to append.
+ * @param out Output buffer.
+ */
+static void put_string(const std::string &value, std::string &out)
+{
+    put_fixed32(static_cast<std::uint32_t>(value.size()), out);
+    out.append(value);
+}
+
+/**
+ * @brief Appends a vector as little-endian doubles.
+ *
+ * @param values Values to append.
+ * @param out Output buffer.
+ */
+static void put_doubles(const Eigen::VectorXd &values, std::string &out)
+{
+    for (Eigen::Index i = 0; i < values.size(); ++i)
+    {
+        std::uint64_t bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        put_fixed64(bits, out);
+    }
+}
+
+/**
+ * @brief Appends a double in its shortest round-trip decimal form.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_decimal(double value, std::string &out)
+{
+    char buffer[32];
+    std::to_chars_result result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr);
+}
+
+/**
+ * @brief Formats two columns as a "Strike,IV" CSV.
+ *
+ * @param strikes Strike column.
+ * @param ivs IV column.
+ * @param out Output buffer.
+ */
+static void format_csv(const Eigen::VectorXd &strikes, const Eigen::VectorXd &ivs, std::string &out)
+{
+    out.clear();
+    out.append("Strike,IV\n");
+    for (Eigen::Index i = 0; i < strikes.size(); ++i)
+    {
+        put_decimal(strikes[i], out);
+        out.push_back(',');
+        put_decimal(ivs[i], out);
+        out.push_back('\n');
+    }
+}
+
+/**
+ * @brief Encodes a smile output in the binary format.
+ *
+ * The file holds the magic, the ticker, date and option type as length-prefixed strings, the
+ * timestamp in milliseconds, the original and interpolated point counts as 32-bit words, then
+ * the original strikes and IVs and the interpolated strikes and IVs as float64 arrays, all
+ * little-endian.
+ *
+ * @param output Smile output to encode.
+ * @param out Output buffer.
+ */
+static void format_binary(const SmileOutput &output, std::string &out)
+{
+    out.clear();
+    out.append(SMILE_MAGIC, sizeof(SMILE_MAGIC));
+    put_string(output.ticker, out);
+    put_string(output.date, out);
+    put_string(output.option_type, out);
+    put_fixed64(static_cast<std::uint64_t>(output.timestamp_ms), out);
+    put_fixed32(static_cast<std::uint32_t>(output.original_strikes.size()), out);
+    put_fixed32(static_cast<std::uint32_t>(output.interpolated_strikes.size()), out);
+    put_doubles(output.original_strikes, out);
+    put_doubles(output.original_ivs, out);
+    put_doubles(output.interpolated_strikes, out);
+    put_doubles(output.interpolated_ivs, out);
+}
+
+/**
+ * @brief Writes a buffer to a temporary file and renames it into place, so readers never see a partial file.
+ *
+ * @param path Destination path.
+ * @param contents File contents.
+ * @return bool True if the file was written.
+ */
+static bool write_file(const std::string &path, const std::string &contents)
+{
+    std::string temporary_path = path + ".tmp";
+    {
+        std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Could not write output file: " << temporary_path << std::endl;
+            return false;
+        }
+        file.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+    }
+
+    if (std::rename(temporary_path.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Could not replace output file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Parses the OUTPUT_FORMAT setting.
+ *
+ * @param format "csv" or "binary".
+ * @return OutputFormat The format; anything other than "binary" selects CSV.
+ */
+OutputFormat parse_output_format(const std::string &format)
+{
+    return (format == "binary" || format == "BINARY") ? OutputFormat::Binary : OutputFormat::CSV;
+}
+
+/**
+ * @brief Creates a stopped writer with an empty queue.
+ */
+OutputWriter::OutputWriter()
+    : config_{true, ".", OutputFormat::CSV, ""}, head_(new Node), submitted_(0), files_written_(0), running_(false), stopping_(false)
+{
+    tail_ = head_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Flushes the queue and frees it.
+ */
+OutputWriter::~OutputWriter()
+{
+    stop();
+    while (tail_)
+    {
+        Node *next = tail_->next.load(std::memory_order_acquire);
+        delete tail_;
+        tail_ = next;
+    }
+}
+
+/**
+ * @brief Creates the output directory, opens the surface store and starts the writer thread.
+ *
+ * @param config Whether and where to write files, and the store directory (empty for none).
+ */
+void OutputWriter::start(const OutputWriterConfig &config)
+{
+    if (running_.load(std::memory_order_acquire))
+        return;
+
+    config_ = config;
+    if (config_.directory.empty())
+        config_.directory = ".";
+
+    if (config_.write_files)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(config_.directory, error);
+        if (error)
+        {
+            std::cerr << "Could not create output directory " << config_.directory << ": " << error.message() << std::endl;
+        }
+    }
+    if (!config_.store_directory.empty())
+    {
+        store_.open(config_.store_directory);
+    }
+
+    stopping_.store(false, std::memory_order_release);
+    running_.store(true, std::memory_order_release);
+    thread_ = std::thread([this]()
+                          { writer_loop(); });
+}
+
+/**
+ * @brief Writes every queued output and stops the writer thread.
+ *
+ * Must be called once no job submits anymore; later submissions are written on the caller.
+ */
+void OutputWriter::stop()
+{
+    if (!running_.load(std::memory_order_acquire))
+        return;
+
+    stopping_.store(true, std::memory_order_release);
+    submitted_.fetch_add(1, std::memory_order_release);
+    submitted_.notify_one();
+    thread_.join();
+    running_.store(false, std::memory_order_release);
+    store_.close();
+}
+
+/**
+ * @brief Hands a smile output to the writer.
+ *
+ * Lock-free: the output is linked in by swapping the queue head, and the writer is woken
+ * through a counter. Writes on the calling thread if the writer is not running.
+ *
+ * @param output Smile output; the writer takes ownership of its buffers.
+ */
+void OutputWriter::submit(std::unique_ptr<SmileOutput> output)
+{
+    if (!running_.load(std::memory_order_acquire))
+    {
+        write(*output);
+        return;
+    }
+
+    Node *node = new Node;
+    node->output = std::move(output);
+    push(node);
+}
+
+/**
+ * @brief Hands a fitted smile to the writer for the surface store.
+ *
+ * Dropped if the writer is not running or has no store open.
+ *
+ * @param record Smile record; the writer takes ownership of its buffers.
+ */
+void OutputWriter::submit(std::unique_ptr<SmileRecord> record)
+{
+    if (!store_open())
+        return;
+
+    Node *node = new Node;
+    node->record = std::move(record);
+    push(node);
+}
+
+/**
+ * @brief Whether submitted smile records are stored, so callers can skip building them.
+ *
+ * @return bool True while the writer runs with a surface store.
+ */
+bool OutputWriter::store_open() const
+{
+    return running_.load(std::memory_order_acquire) && !config_.store_directory.empty();
+}
+
+/**
+ * @brief Links a node into the queue and wakes the writer.
+ *
+ * @param node Node holding an output or a record.
+ */
+void OutputWriter::push(Node *node)
+{
+    Node *previous = head_.exchange(node, std::memory_order_acq_rel);
+    previous->next.store(node, std::memory_order_release);
+
+    submitted_.fetch_add(1, std::memory_order_release);
+    submitted_.notify_one();
+}
+
+/**
+ * @brief Number of files written since startup.
+ *
+ * @return std::uint64_t The count.
+ */
+std::uint64_t OutputWriter::files_written() const
+{
+    return files_written_.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Drains the queue whenever outputs arrive, until stop() is called.
+ *
+ * The node at tail_ has always been written already; popping advances tail_ to its successor
+ * and frees it.
+ */
+void OutputWriter::writer_loop()
+{
+    set_trace_thread_name("output_writer");
+    while (true)
+    {
+        std::uint64_t seen = submitted_.load(std::memory_order_acquire);
+
+        Node *next;
+        while ((next = tail_->next.load(std::memory_order_acquire)) != nullptr)
+        {
+            delete tail_;
+            tail_ = next;
+            if (next->output)
+                write(*next->output);
+            if (next->record)
+                store_.append(*next->record);
+            next->output.reset();
+            next->record.reset();
+        }
+
+        if (stopping_.load(std::memory_order_acquire))
+            break;
+
+        // Returns at once if a submission landed after `seen` was read, including one not yet linked during the drain
+        submitted_.wait(seen, std::memory_order_acquire);
+    }
+}
+
+/**
+ * @brief Formats a smile output and writes its files.
+ *
+ * @param output Smile output to write.
+ */
+void OutputWriter::write(const SmileOutput &output)
+{
+    TRACE_SCOPE("write_output");
+    static thread_local std::string buffer;
+
+    if (!config_.write_files)
+        return;
+
+    std::string prefix = config_.directory + "/" + output.ticker + "_" + output.date + "_" + output.option_type + "_" + std::to_string(output.timestamp_ms);
+    if (config_.format == OutputFormat::Binary)
+    {
+        format_binary(output, buffer);
+        if (write_file(prefix + ".bin", buffer))
+            files_written_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    format_csv(output.original_strikes, output.original_ivs, buffer);
+    if (write_file(prefix + "_original.csv", buffer))
+        files_written_.fetch_add(1, std::memory_order_relaxed);
+    format_csv(output.interpolated_strikes, output.interpolated_ivs, buffer);
+    if (write_file(prefix + "_interpolated.csv", buffer))
+        files_written_.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,478 @@
+#include <iostream>
+#include <vector>
+#include <numeric>
+#include <chrono>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "pipeline.h"
+#include "data.h"
+#include "option_chain.h"
+#include "filters.h"
+#include "models.h"
+#include "load_env.h"
+#include "fred.h"
+#include "interpolations.h"
+#include "smile_surface.h"
+#include "vol_surface.h"
+#include "quote_book.h"
+#include "helpers.h"
+#include "output_writer.h"
+#include "metrics.h"
+#include "trace.h"
+
+/**
+ * @brief Number of strikes the smile is sampled at for the outputs and the surface store.
+ */
+constexpr Eigen::Index SMILE_GRID_POINTS = 800;
+
+/**
+ * @brief Stamps a snapshot with the current time and the default pricing inputs of an entry.
+ *
+ * @param entry Watch-list entry.
+ * @param snapshot Receives the entry, the time and the static S, T, q and the current risk-free rate.
+ */
+static void stamp_snapshot(const WatchListEntry &entry, ChainSnapshot &snapshot)
+{
+    snapshot.timestamp_ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+    snapshot.entry = entry;
+    snapshot.S = 566.345;
+    snapshot.T = 0.015708354371353372;
+    snapshot.q = 0.0035192;
+    snapshot.r = risk_free_rate.load(std::memory_order_acquire);
+}
+
+/**
+ * @brief Collects the inputs of one watch-list job: the live chain when streaming, the static chain otherwise.
+ *
+ * @param out Stream the job logs to.
+ * @param entry Watch-list entry.
+ * @param snapshot Receives the chain and its pricing inputs, stamped with the current time.
+ */
+void acquire_chain_snapshot(std::ostream &out, const WatchListEntry &entry, ChainSnapshot &snapshot)
+{
+    TRACE_SCOPE("acquire_chain_snapshot");
+    stamp_snapshot(entry, snapshot);
+
+    int expiry;
+    if (!stream_url.empty() && quote_book.snapshot_chain(entry.ticker, entry.date_index, entry.option_kind, snapshot.chain, snapshot.S, snapshot.T, expiry))
+    {
+        out << "Streamed chain: expiry " << expiry << ", S = " << snapshot.S << ", T = " << snapshot.T << std::endl;
+    }
+    else
+    {
+        load_option_chain(quote_data, snapshot.chain);
+    }
+}
+
+/**
+ * @brief Writes the settings of a watch-list entry at the top of its output.
+ *
+ * @param out Stream the job logs to.
+ * @param entry Watch-list entry.
+ */
+static void write_entry_header(std::ostream &out, const WatchListEntry &entry)
+{
+    out << "Ticker: " << entry.ticker << std::endl;
+    out << "Date: " << entry.date << std::endl;
+    out << "Option Type: " << option_kind_name(entry.option_kind) << std::endl;
+    out << "Min Overpriced: " << entry.min_overpriced << std::endl;
+    out << "Min Underpriced: " << entry.min_underpriced << std::endl;
+    out << "Min OI: " << entry.min_oi << std::endl;
+}
+
+/**
+ * @brief Solves the implied volatilities of a chain and fits its smile, as a task graph.
+ *
+ * The stages run as nodes of a TaskGraph: strike filter, then the mid, bid and ask IV solves
+ * side by side, then the IV filter, then the RBF and RFV fits side by side, then the blend.
+ * With a pool, independent nodes run concurrently, which shortens the time to a fitted smile
+ * of a single chain; without one, the nodes run serially in that order.
+ *
+ * @param out Stream the job logs to.
+ * @param snapshot Chain and pricing inputs; the IV columns of the chain are filled in.
+ * @param fitted Receives the quotes the smile was fitted to and the smile.
+ * @param clock Clock timing the stages of the run.
+ * @param pool Pool the independent stages run on, or nullptr to run them serially.
+ * @return bool False if fewer than 20 strikes survive the filters, leaving fitted.smile empty.
+ */
+bool fit_chain_smile(std::ostream &out, ChainSnapshot &snapshot, FittedChain &fitted, StageClock &clock, WorkStealingPool *pool)
+{
+    TRACE_SCOPE("fit_chain_smile");
+    const WatchListEntry &entry = snapshot.entry;
+    OptionKind option_kind = entry.option_kind;
+    double S = snapshot.S;
+    double T = snapshot.T;
+    double q = snapshot.q;
+    double r = snapshot.r;
+    OptionChain &chain = snapshot.chain;
+    ChainSelection &selection = fitted.selection;
+    std::vector<int> &iv_evaluations = fitted.iv_evaluations;
+
+    TickerMetrics &metrics = ticker_metrics(entry.ticker);
+    std::string fit_key = entry.ticker + "|" + entry.date + "|" + option_kind_name(option_kind);
+    fitted.smile = nullptr;
+
+    bool enough_strikes = false;
+    SmileCoordinates coordinates;
+    std::shared_ptr<const RBFInterpolator> rbf;
+    Eigen::VectorXd rfv_params;
+
+    TaskGraph graph;
+
+    TaskGraph::NodeId strike_filter = graph.add("strike_filter", [&]()
+                                                {
+                                                    select_all(chain, selection);
+                                                    refine_selection(chain, selection, all_of(strike_range(chain.strike, S, 1.25), NonZeroBid{}));
+                                                    iv_evaluations.resize(3 * selection.size());
+                                                    clock.lap(PipelineStage::StrikeFilter);
+                                                });
+
+    auto solve_column = [&](const std::vector<double> &prices, std::vector<double> &ivs, std::size_t column)
+    {
+        calculate_implied_volatility_baw_selection(prices.data(), chain.strike.data(), ivs.data(), selection.data(), selection.size(), S, r, T, q, option_kind, 100, 1e-8, IVSolverMode::Newton, iv_evaluations.data() + column * selection.size());
+    };
+    TaskGraph::NodeId mid_iv = graph.add("iv_solve_mid", [&]()
+                                         { solve_column(chain.mid, chain.mid_iv, 0); }, {strike_filter});
+    TaskGraph::NodeId bid_iv = graph.add("iv_solve_bid", [&]()
+                                         { solve_column(chain.bid, chain.bid_iv, 1); }, {strike_filter});
+    TaskGraph::NodeId ask_iv = graph.add("iv_solve_ask", [&]()
+                                         { solve_column(chain.ask, chain.ask_iv, 2); }, {strike_filter});
+
+    TaskGraph::NodeId iv_filter = graph.add("iv_filter", [&]()
+                                            {
+                                                clock.lap(PipelineStage::IVSolve);
+
+                                                std::uint64_t total_evaluations = std::accumulate(iv_evaluations.begin(), iv_evaluations.end(), std::uint64_t{0});
+                                                metrics.iv_evaluations.fetch_add(total_evaluations, std::memory_order_relaxed);
+
+                                                refine_selection(chain, selection, MidIVAbove{0.005});
+                                                select_rows(chain, selection.rows, fitted.fit_chain);
+                                                enough_strikes = fitted.fit_chain.size() >= 20;
+                                                if (enough_strikes)
+                                                {
+                                                    coordinates = make_smile_coordinates(column_view(fitted.fit_chain.strike));
+                                                }
+                                                clock.lap(PipelineStage::IVFilter);
+                                            },
+                                            {mid_iv, bid_iv, ask_iv});
+
+    TaskGraph::NodeId rbf_fit = graph.add("rbf_fit", [&]()
+                                          {
+                                              if (!enough_strikes)
+                                                  return;
+                                              StageTimer timer(metrics, PipelineStage::RBFBuild);
+                                              rbf = fit_smile_rbf(coordinates, column_view(fitted.fit_chain.mid_iv), fit_key);
+                                          },
+                                          {iv_filter});
+
+    TaskGraph::NodeId rfv_fit = graph.add("rfv_fit", [&]()
+                                          {
+                                              if (!enough_strikes)
+                                                  return;
+                                              RFVFitStats rfv_stats;
+                                              {
+                                                  StageTimer timer(metrics, PipelineStage::RFVFit);
+                                                  rfv_params = fit_smile_rfv(coordinates, column_view(fitted.fit_chain.mid_iv), column_view(fitted.fit_chain.bid_iv), column_view(fitted.fit_chain.ask_iv), fit_key, &rfv_stats);
+                                              }
+                                              metrics.rfv_nfev.fetch_add(static_cast<std::uint64_t>(rfv_stats.nfev), std::memory_order_relaxed);
+                                              metrics.rfv_nit.fetch_add(static_cast<std::uint64_t>(rfv_stats.nit), std::memory_order_relaxed);
+                                          },
+                                          {iv_filter});
+
+    graph.add("blend", [&]()
+              {
+                  if (!enough_strikes)
+                      return;
+                  fitted.smile = std::make_shared<const SmileSurface>(coordinates, std::move(rfv_params), std::move(rbf));
+                  clock.restart();
+
+                  ConstChainColumn x_eigen = column_view(fitted.fit_chain.strike);
+                  fitted.rmse = calculate_rmse(column_view(fitted.fit_chain.mid_iv), fitted.smile->evaluate(x_eigen));
+                  out << "RMSE of the fit: " << fitted.rmse << std::endl;
+              },
+              {rbf_fit, rfv_fit});
+
+    graph.run(pool);
+    return fitted.smile != nullptr;
+}
+
+/**
+ * @brief Prices the tradable strikes of a fitted chain off its smile and reports the mispricings.
+ *
+ * @param out Stream the job logs to.
+ * @param snapshot Pricing inputs the smile was fitted with.
+ * @param entry Watch-list entry supplying the open interest threshold.
+ * @param fitted Quotes the smile was fitted to and the smile.
+ * @param clock Clock timing the stages of the run.
+ */
+void scan_mispricings(std::ostream &out, const ChainSnapshot &snapshot, const WatchListEntry &entry, const FittedChain &fitted, StageClock &clock)
+{
+    TRACE_SCOPE("scan_mispricings");
+    OptionKind option_kind = entry.option_kind;
+    double S = snapshot.S;
+    double T = snapshot.T;
+    double q = snapshot.q;
+    double r = snapshot.r;
+    const OptionChain &fit_chain = fitted.fit_chain;
+    const SmileSurface &smile = *fitted.smile;
+
+    static thread_local ChainSelection selection;
+
+    select_all(fit_chain, selection);
+    refine_selection(fit_chain, selection, OpenInterestAtLeast{entry.min_oi});
+
+    if (selection.size() >= 2)
+    {
+        ConstChainColumn x_eigen = column_view(fit_chain.strike);
+        ConstChainColumn mid_iv_eigen = column_view(fit_chain.mid_iv);
+        Eigen::VectorXd tradable_strikes = x_eigen(selection.rows);
+        Eigen::VectorXd tradable_ivs = smile.evaluate(tradable_strikes);
+        Eigen::VectorXd mispricings(selection.size());
+        clock.lap(PipelineStage::GridEval);
+
+        for (std::size_t i = 0; i < selection.size(); ++i)
+        {
+            std::size_t row = selection.rows[i];
+            double strike = fit_chain.strike[row];
+            double interpolated_iv = tradable_ivs[i];
+            double mid_value = fit_chain.mid[row];
+            double option_price = baw_price(option_kind, S, strike, T, r, interpolated_iv, q);
+            double diff_price = mid_value - option_price;
+
+            mispricings[i] = diff_price;
+        }
+        clock.lap(PipelineStage::MispricingScan);
+
+        for (std::size_t i = 0; i < selection.size(); ++i)
+        {
+            std::size_t row = selection.rows[i];
+            out << "Strike: " << fit_chain.strike[row]
+                      << ", Mid Price: " << fit_chain.mid[row]
+                      << ", Mispricing: " << mispricings[i] << std::endl;
+        }
+
+        if (write_csv_output)
+        {
+            auto output = std::make_unique<SmileOutput>();
+            output->ticker = entry.ticker;
+            // Streamed snapshots carry their expiry; the static chain only has the entry's index
+            output->date = snapshot.entry.date != "null" ? snapshot.entry.date : std::to_string(entry.date_index);
+            output->option_type = option_kind_name(option_kind);
+            output->timestamp_ms = snapshot.timestamp_ms;
+            output->original_ivs = mid_iv_eigen(selection.rows);
+            output->interpolated_strikes = smile.strike_grid(SMILE_GRID_POINTS);
+            output->interpolated_ivs = smile.evaluate(output->interpolated_strikes);
+            output->original_strikes = std::move(tradable_strikes);
+            output_writer.submit(std::move(output));
+
+            out << "Smile queued for output." << std::endl;
+            clock.lap(PipelineStage::CSVWrite);
+        }
+    }
+}
+
+/**
+ * @brief Hands a fitted smile to the output writer for the surface store, if one is open.
+ *
+ * @param snapshot Pricing inputs the smile was fitted with.
+ * @param fitted The fit.
+ */
+static void store_fitted_smile(const ChainSnapshot &snapshot, const FittedChain &fitted)
+{
+    if (!output_writer.store_open())
+        return;
+
+    const SmileSurface &smile = *fitted.smile;
+    auto record = std::make_unique<SmileRecord>();
+    record->ticker = snapshot.entry.ticker;
+    SurfaceStoreRow &row = record->row;
+    row.timestamp_ms = snapshot.timestamp_ms;
+    row.expiry = snapshot.entry.date != "null" ? std::atoi(snapshot.entry.date.c_str()) : 0;
+    row.option_kind = snapshot.entry.option_kind == OptionKind::Call ? 0 : 1;
+    row.S = snapshot.S;
+    row.T = snapshot.T;
+    row.r = snapshot.r;
+    row.q = snapshot.q;
+    row.rmse = fitted.rmse;
+    row.x_min = smile.min_strike();
+    row.x_max = smile.max_strike();
+    Eigen::Map<Eigen::VectorXd>(row.rfv_params, 5) = smile.rfv_params();
+    row.rbf_epsilon = smile.rbf().epsilon();
+    record->strikes = column_view(fitted.fit_chain.strike);
+    record->strike_ivs = column_view(fitted.fit_chain.mid_iv);
+    record->rbf_weights = smile.rbf().weights();
+    record->grid_ivs = smile.evaluate(smile.strike_grid(SMILE_GRID_POINTS));
+    output_writer.submit(std::move(record));
+}
+
+// Function for option interpolation
+void perform_option_interpolation(std::ostream &out, ChainSnapshot &snapshot, WorkStealingPool *pool)
+{
+    TRACE_SCOPE("perform_option_interpolation");
+    write_entry_header(out, snapshot.entry);
+
+    // A thread waiting for the graph may start another interpolation, so only the serial path reuses the thread's scratch
+    static thread_local FittedChain reused;
+    FittedChain pooled;
+    FittedChain &fitted = pool ? pooled : reused;
+
+    StageClock clock(ticker_metrics(snapshot.entry.ticker));
+    if (fit_chain_smile(out, snapshot, fitted, clock, pool))
+    {
+        store_fitted_smile(snapshot, fitted);
+        scan_mispricings(out, snapshot, snapshot.entry, fitted, clock);
+    }
+    clock.finish();
+
+    // Release the smile so the next fit of this chain can refit its cached RBF in place
+    fitted.smile = nullptr;
+}
+
+/**
+ * @brief One expiry of a surface job: its snapshot, its fit, the fit's log and how long the fit took.
+ */
+struct SurfaceSlice
+{
+    int expiry;
+    ChainSnapshot snapshot;
+    FittedChain fitted;
+    std::string log;
+    std::chrono::steady_clock::duration fit_time{};
+};
+
+/**
+ * @brief Collects every listed expiry of an underlying when streaming, or the static chain as a single expiry otherwise.
+ *
+ * @param out Stream the job logs to.
+ * @param entry Any watch-list entry of the underlying and option type.
+ * @param slices Receives one slice per expiry, nearest first, each snapshot keyed by its expiry.
+ * @return bool True if the slices are the streamed expiries, false for the static stand-in.
+ */
+static bool acquire_surface_snapshots(std::ostream &out, const WatchListEntry &entry, std::vector<SurfaceSlice> &slices)
+{
+    TRACE_SCOPE("acquire_surface_snapshots");
+    std::vector<ExpiryChain> expiries;
+    double S;
+    if (!stream_url.empty() && quote_book.snapshot_expiries(entry.ticker, entry.option_kind, expiries, S))
+    {
+        slices.resize(expiries.size());
+        for (std::size_t i = 0; i < expiries.size(); ++i)
+        {
+            SurfaceSlice &slice = slices[i];
+            slice.expiry = expiries[i].expiry;
+            stamp_snapshot(entry, slice.snapshot);
+            slice.snapshot.entry.date_index = static_cast<int>(i);
+            slice.snapshot.entry.date = std::to_string(expiries[i].expiry);
+            slice.snapshot.S = S;
+            slice.snapshot.T = expiries[i].T;
+            slice.snapshot.chain = std::move(expiries[i].chain);
+        }
+
+        out << "Streamed surface: " << slices.size() << " expiries from " << slices.front().expiry
+            << " to " << slices.back().expiry << ", S = " << S << std::endl;
+        return true;
+    }
+
+    slices.resize(1);
+    slices[0].expiry = 0;
+    stamp_snapshot(entry, slices[0].snapshot);
+    load_option_chain(quote_data, slices[0].snapshot.chain);
+    return false;
+}
+
+/**
+ * @brief Fits every listed expiry of one underlying once and scans each watch-list entry that references it.
+ *
+ * All expiries are copied out of the quote book against one underlying price and their smiles
+ * are fitted in parallel on the pool as independent nodes of a TaskGraph, with the calling job
+ * helping run the fits while it waits.
+ * The smiles are published as one VolSurface for queries between expiries, and each entry is
+ * then scanned against the smile of its own expiry. Without streamed quotes the static chain
+ * stands in for every expiry as a one-slice surface, as it did for single-expiry jobs.
+ *
+ * @param out Stream the job logs to.
+ * @param pool Pool the fits run on.
+ * @param entries Watch-list entries sharing one underlying and option type.
+ * @param recorder Optional recorder receiving the snapshot of every entry.
+ */
+void perform_surface_interpolation(std::ostream &out, WorkStealingPool &pool, const std::vector<const WatchListEntry *> &entries, SnapshotRecorder *recorder)
+{
+    TRACE_SCOPE("perform_surface_interpolation");
+    const WatchListEntry &first = *entries.front();
+
+    std::vector<SurfaceSlice> slices;
+    bool streamed = acquire_surface_snapshots(out, first, slices);
+
+    auto slice_of = [&](const WatchListEntry &entry) -> SurfaceSlice *
+    {
+        std::size_t index = streamed ? static_cast<std::size_t>(entry.date_index) : 0;
+        return entry.date_index >= 0 && index < slices.size() ? &slices[index] : nullptr;
+    };
+
+    if (recorder)
+    {
+        for (const WatchListEntry *entry : entries)
+        {
+            SurfaceSlice *slice = slice_of(*entry);
+            if (slice == nullptr)
+                continue;
+
+            ChainSnapshot recorded = slice->snapshot;
+            recorded.entry = *entry;
+            recorded.entry.date = slice->snapshot.entry.date;
+            recorder->append(recorded);
+        }
+    }
+
+    TaskGraph fits;
+    for (SurfaceSlice &slice : slices)
+    {
+        fits.add("fit_slice", [&slice, &pool]()
+                 {
+                     std::ostringstream log;
+                     StageClock clock(ticker_metrics(slice.snapshot.entry.ticker));
+                     if (fit_chain_smile(log, slice.snapshot, slice.fitted, clock, &pool))
+                         store_fitted_smile(slice.snapshot, slice.fitted);
+                     slice.fit_time = clock.elapsed();
+                     slice.log = log.str();
+                 });
+    }
+    fits.run(&pool);
+
+    // The published surface outlives this cycle, so it holds snapshots that leave the cached RBFs free to refit in place
+    auto surface = std::make_shared<VolSurface>(first.ticker, first.option_kind, slices.front().snapshot.S);
+    for (const SurfaceSlice &slice : slices)
+    {
+        if (slice.fitted.smile)
+            surface->add_slice(slice.expiry, slice.snapshot.T, slice.fitted.smile->snapshot());
+    }
+    publish_vol_surface(surface);
+    out << "Volatility surface: " << surface->slices().size() << " of " << slices.size() << " expiries fitted" << std::endl;
+
+    for (const WatchListEntry *entry : entries)
+    {
+        write_entry_header(out, *entry);
+
+        SurfaceSlice *slice = slice_of(*entry);
+        if (slice == nullptr)
+        {
+            out << "No listed expiry at index " << entry->date_index << std::endl;
+            continue;
+        }
+        if (streamed)
+        {
+            out << "Expiry: " << slice->expiry << ", T = " << slice->snapshot.T << std::endl;
+        }
+        out << slice->log;
+
+        // Each entry is one run spanning its slice's fit and its own scan, as in the chain path
+        StageClock clock(ticker_metrics(entry->ticker), slice->fit_time);
+        if (slice->fitted.smile)
+            scan_mispricings(out, slice->snapshot, *entry, slice->fitted, clock);
+        clock.finish();
+    }
+}
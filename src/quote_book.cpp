@@ -0,0 +1,293 @@
+#include "quote_book.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <tuple>
+
+/**
+ * @brief Global live quote book fed by the streaming client.
+ */
+QuoteBook quote_book;
+
+/**
+ * @brief Hour (UTC) at which options are taken to expire, approximating the 4 PM New York close.
+ */
+constexpr int EXPIRY_HOUR_UTC = 20;
+
+/**
+ * @brief Parse a Schwab option symbol: a 6-character padded root, YYMMDD, C or P, and the strike times 1000 in 8 digits.
+ *
+ * @param symbol Option symbol, e.g. "AAPL  240809C00095000".
+ * @param parsed Receives the parsed fields.
+ * @return bool True if the symbol is well formed.
+ */
+bool parse_option_symbol(const std::string &symbol, OptionSymbol &parsed)
+{
+    if (symbol.size() != 21)
+        return false;
+
+    for (std::size_t i = 6; i < 21; ++i)
+    {
+        if (i != 12 && !std::isdigit(static_cast<unsigned char>(symbol[i])))
+            return false;
+    }
+
+    char type = symbol[12];
+    if (type != 'C' && type != 'P')
+        return false;
+
+    std::string root = symbol.substr(0, 6);
+    root.erase(root.find_last_not_of(' ') + 1);
+    if (root.empty())
+        return false;
+
+    parsed.underlying = root;
+    parsed.expiry = 20000000 + std::stoi(symbol.substr(6, 6));
+    parsed.kind = type == 'C' ? OptionKind::Call : OptionKind::Put;
+    parsed.strike = std::stoll(symbol.substr(13, 8)) / 1000.0;
+    return true;
+}
+
+/**
+ * @brief Time from a point in time to an expiry date, in years of 365 days.
+ *
+ * @param expiry Expiry date as YYYYMMDD.
+ * @param as_of_ms Reference time in milliseconds since the Unix epoch.
+ * @return double The year fraction; negative once the option has expired.
+ */
+double year_fraction_to_expiry(int expiry, std::int64_t as_of_ms)
+{
+    using namespace std::chrono;
+
+    year_month_day date{year{expiry / 10000}, month{static_cast<unsigned>(expiry / 100 % 100)}, day{static_cast<unsigned>(expiry % 100)}};
+    sys_time<milliseconds> expiry_time = sys_days{date} + hours{EXPIRY_HOUR_UTC};
+    double seconds = (expiry_time.time_since_epoch().count() - as_of_ms) / 1000.0;
+    return seconds / (365.0 * 24 * 3600);
+}
+
+/**
+ * @brief Orders chains by underlying, then option type, then expiry.
+ *
+ * @param other Chain to compare with.
+ * @return bool True if this chain sorts first.
+ */
+bool QuoteBook::ChainId::operator<(const ChainId &other) const
+{
+    return std::tie(underlying, kind, expiry) < std::tie(other.underlying, other.kind, other.expiry);
+}
+
+/**
+ * @brief Apply a level-1 option delta in place, adding the chain or strike if it is new.
+ *
+ * @param symbol Parsed option symbol.
+ * @param update Changed fields.
+ */
+void QuoteBook::apply_option_update(const OptionSymbol &symbol, const QuoteUpdate &update)
+{
+    ChainId id{symbol.underlying, symbol.kind, symbol.expiry};
+    LiveChain *live = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(chains_mutex_);
+        auto it = chains_.find(id);
+        if (it != chains_.end())
+            live = it->second.get();
+    }
+    if (live == nullptr)
+    {
+        std::unique_lock<std::shared_mutex> lock(chains_mutex_);
+        std::unique_ptr<LiveChain> &slot = chains_[id];
+        if (!slot)
+            slot = std::make_unique<LiveChain>();
+        live = slot.get();
+    }
+
+    std::lock_guard<std::mutex> lock(live->mutex);
+    OptionChain &chain = live->chain;
+    auto position = std::lower_bound(chain.strike.begin(), chain.strike.end(), symbol.strike);
+    std::size_t row = static_cast<std::size_t>(position - chain.strike.begin());
+    if (position == chain.strike.end() || *position != symbol.strike)
+    {
+        chain.strike.insert(chain.strike.begin() + row, symbol.strike);
+        chain.bid.insert(chain.bid.begin() + row, 0.0);
+        chain.ask.insert(chain.ask.begin() + row, 0.0);
+        chain.mid.insert(chain.mid.begin() + row, 0.0);
+        chain.open_interest.insert(chain.open_interest.begin() + row, 0.0);
+        chain.bid_iv.insert(chain.bid_iv.begin() + row, 0.0);
+        chain.ask_iv.insert(chain.ask_iv.begin() + row, 0.0);
+        chain.mid_iv.insert(chain.mid_iv.begin() + row, 0.0);
+    }
+
+    if (update.fields & QUOTE_BID)
+        chain.bid[row] = update.bid;
+    if (update.fields & QUOTE_ASK)
+        chain.ask[row] = update.ask;
+    if (update.fields & QUOTE_OPEN_INTEREST)
+        chain.open_interest[row] = update.open_interest;
+    if (update.fields & (QUOTE_BID | QUOTE_ASK))
+        chain.mid[row] = (chain.bid[row] + chain.ask[row]) / 2;
+}
+
+/**
+ * @brief Apply a level-1 equity delta.
+ *
+ * @param symbol Equity symbol.
+ * @param update Changed fields.
+ */
+void QuoteBook::apply_equity_update(const std::string &symbol, const QuoteUpdate &update)
+{
+    std::lock_guard<std::mutex> lock(equities_mutex_);
+    EquityQuote &quote = equities_[symbol];
+    if (update.fields & QUOTE_BID)
+        quote.bid = update.bid;
+    if (update.fields & QUOTE_ASK)
+        quote.ask = update.ask;
+    if (update.fields & QUOTE_LAST)
+        quote.last = update.last;
+}
+
+/**
+ * @brief Record the exchange time of the latest update, used to compute time to expiry.
+ *
+ * Using the feed's own timestamps keeps time to expiry correct when old recordings are replayed.
+ *
+ * @param epoch_ms Milliseconds since the Unix epoch.
+ */
+void QuoteBook::set_as_of(std::int64_t epoch_ms)
+{
+    std::lock_guard<std::mutex> lock(equities_mutex_);
+    as_of_ms_ = std::max(as_of_ms_, epoch_ms);
+}
+
+/**
+ * @brief Upper-cases a symbol to the form the streamer reports it in.
+ *
+ * @param underlying Underlying symbol (case-insensitive).
+ * @return std::string The upper-case symbol.
+ */
+static std::string normalize_symbol(const std::string &underlying)
+{
+    std::string symbol = underlying;
+    std::transform(symbol.begin(), symbol.end(), symbol.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::toupper(c)); });
+    return symbol;
+}
+
+/**
+ * @brief Current price of an underlying and the feed time it is valid at.
+ *
+ * @param symbol Upper-case underlying symbol.
+ * @param S Receives the underlying price: the bid/ask mid, or the last price without a two-sided quote.
+ * @param as_of_ms Receives the exchange time of the latest update.
+ * @return bool False if no positive price has been received yet.
+ */
+bool QuoteBook::underlying_price(const std::string &symbol, double &S, std::int64_t &as_of_ms) const
+{
+    std::lock_guard<std::mutex> lock(equities_mutex_);
+    auto it = equities_.find(symbol);
+    if (it == equities_.end())
+        return false;
+
+    const EquityQuote &quote = it->second;
+    S = quote.bid > 0 && quote.ask > 0 ? (quote.bid + quote.ask) / 2 : quote.last;
+    as_of_ms = as_of_ms_;
+    return S > 0;
+}
+
+/**
+ * @brief Copy one live chain together with its pricing inputs.
+ *
+ * @param underlying Underlying symbol (case-insensitive).
+ * @param date_index Position of the expiry among the unexpired expiries of the underlying, nearest first.
+ * @param kind Option type.
+ * @param chain Receives the chain.
+ * @param S Receives the underlying price: the bid/ask mid, or the last price without a two-sided quote.
+ * @param T Receives the time to expiry in years.
+ * @param expiry Receives the expiry as YYYYMMDD.
+ * @return bool False if the chain or the underlying price is not available yet.
+ */
+bool QuoteBook::snapshot_chain(const std::string &underlying, int date_index, OptionKind kind, OptionChain &chain, double &S, double &T, int &expiry) const
+{
+    std::string symbol = normalize_symbol(underlying);
+
+    std::int64_t as_of_ms;
+    if (!underlying_price(symbol, S, as_of_ms))
+        return false;
+
+    const LiveChain *live = nullptr;
+    {
+        std::shared_lock<std::shared_mutex> lock(chains_mutex_);
+        int remaining = date_index;
+        for (auto it = chains_.lower_bound(ChainId{symbol, kind, 0}); it != chains_.end(); ++it)
+        {
+            if (it->first.underlying != symbol || it->first.kind != kind)
+                break;
+            if (year_fraction_to_expiry(it->first.expiry, as_of_ms) <= 0)
+                continue;
+            if (remaining-- == 0)
+            {
+                live = it->second.get();
+                expiry = it->first.expiry;
+                break;
+            }
+        }
+    }
+    if (live == nullptr)
+        return false;
+
+    T = year_fraction_to_expiry(expiry, as_of_ms);
+
+    std::lock_guard<std::mutex> lock(live->mutex);
+    chain = live->chain;
+    return true;
+}
+
+/**
+ * @brief Copy every unexpired chain of an underlying, nearest expiry first, against one underlying price.
+ *
+ * All expiries are priced off the same S and feed time, so the smiles fitted from them form a
+ * consistent term structure.
+ *
+ * @param underlying Underlying symbol (case-insensitive).
+ * @param kind Option type.
+ * @param chains Receives one entry per unexpired expiry with its time to expiry in years.
+ * @param S Receives the underlying price: the bid/ask mid, or the last price without a two-sided quote.
+ * @return bool False if no chain or no underlying price is available yet.
+ */
+bool QuoteBook::snapshot_expiries(const std::string &underlying, OptionKind kind, std::vector<ExpiryChain> &chains, double &S) const
+{
+    std::string symbol = normalize_symbol(underlying);
+    chains.clear();
+
+    std::int64_t as_of_ms;
+    if (!underlying_price(symbol, S, as_of_ms))
+        return false;
+
+    std::shared_lock<std::shared_mutex> lock(chains_mutex_);
+    for (auto it = chains_.lower_bound(ChainId{symbol, kind, 0}); it != chains_.end(); ++it)
+    {
+        if (it->first.underlying != symbol || it->first.kind != kind)
+            break;
+
+        double T = year_fraction_to_expiry(it->first.expiry, as_of_ms);
+        if (T <= 0)
+            continue;
+
+        ExpiryChain &expiry = chains.emplace_back();
+        expiry.expiry = it->first.expiry;
+        expiry.T = T;
+        std::lock_guard<std::mutex> chain_lock(it->second->mutex);
+        expiry.chain = it->second->chain;
+    }
+    return !chains.empty();
+}
+
+/**
+ * @brief Checks whether any option chain has been received.
+ *
+ * @return bool True if the book holds no chains.
+ */
+bool QuoteBook::empty() const
+{
+    std::shared_lock<std::shared_mutex> lock(chains_mutex_);
+    return chains_.empty();
+}
@@ -1,6 +1,16 @@
 #include "rbf.h"
+#include "trace.h"
 #include <Eigen/Dense>
 #include <cmath>
+#include <algorithm>
+
+/**
+ * @brief Number of grid points evaluated together against every center.
+ *
+ * A tile of grid points and its accumulators stay in L1 cache while the centers
+ * are streamed over them.
+ */
+constexpr Eigen::Index RBF_TILE_SIZE = 256;
 
 /**
  * @brief Constructor for RBFInterpolator with multiquadric kernel and hardcoded smoothing.
@@ -10,44 +20,295 @@
  * @param epsilon Regularization parameter for the RBF kernel.
  */
 RBFInterpolator::RBFInterpolator(const Eigen::VectorXd &k, const Eigen::VectorXd &y, double epsilon)
-    : k_(k), y_(y), epsilon_(epsilon), smoothing_(1e-12)
+    : k_(k), y_(y), edit_(RBFCenterEdit::None), edit_index_(0), edit_schur_(0.0), epsilon_(epsilon), smoothing_(1e-12)
+{
+    TRACE_SCOPE("RBFInterpolator");
+    factorize(k);
+    solve_weights();
+}
+
+/**
+ * @brief Refits the interpolant to new data, reusing the cached factorization where possible.
+ *
+ * When the centers are unchanged only a back-substitution is performed. When a single center
+ * was added to or removed from the factorized set, the weights are obtained from the cached
+ * factor through a bordered solve, at O(n^2) cost. Any other change refactorizes.
+ *
+ * The centers must otherwise stay put. SmileSurface maps strikes over their current min and
+ * max, so a strike entering or leaving at either end of the chain, which is how strikes
+ * usually change as the strike range follows spot, moves every center and refactorizes; only
+ * interior strikes take the bordered path.
+ *
+ * @param k Vector of input points for interpolation (log-moneyness).
+ * @param y Corresponding values (implied volatilities).
+ */
+void RBFInterpolator::refit(const Eigen::VectorXd &k, const Eigen::VectorXd &y)
+{
+    TRACE_SCOPE("RBFInterpolator::refit");
+    y_ = y;
+    if (k.size() != k_.size() || k != k_)
+    {
+        if (!match_centers(k))
+        {
+            factorize(k);
+        }
+        k_ = k;
+    }
+    solve_weights();
+}
+
+/**
+ * @brief Returns the shape parameter of the kernel.
+ *
+ * @return double The epsilon the interpolator was built with.
+ */
+double RBFInterpolator::epsilon() const
+{
+    return epsilon_;
+}
+
+/**
+ * @brief Returns the kernel weights of the centers.
+ *
+ * @return const Eigen::VectorXd& One weight per center.
+ */
+const Eigen::VectorXd &RBFInterpolator::weights() const
+{
+    return weights_;
+}
+
+/**
+ * @brief Copies the centers and weights without the factorization, for holders that only evaluate.
+ *
+ * The copy costs O(n) instead of the O(n^2) of the factor, and leaves the original the only
+ * holder of its factor, so it can still be refitted in place.
+ *
+ * @return std::shared_ptr<const RBFInterpolator> An interpolator that evaluates like this one.
+ */
+std::shared_ptr<const RBFInterpolator> RBFInterpolator::snapshot() const
+{
+    std::shared_ptr<RBFInterpolator> copy(new RBFInterpolator());
+    copy->k_ = k_;
+    copy->weights_ = weights_;
+    copy->edit_ = RBFCenterEdit::None;
+    copy->edit_index_ = 0;
+    copy->edit_schur_ = 0.0;
+    copy->epsilon_ = epsilon_;
+    copy->smoothing_ = smoothing_;
+    return copy;
+}
+
+/**
+ * @brief Multiquadric kernel.
+ *
+ * @param r Distance between two points.
+ * @return double The kernel value.
+ */
+double RBFInterpolator::kernel(double r) const
+{
+    return std::sqrt(1 + (epsilon_ * epsilon_ * r * r));
+}
+
+/**
+ * @brief Builds the kernel matrix for the given centers and factorizes it.
+ *
+ * @param k Centers to factorize.
+ */
+void RBFInterpolator::factorize(const Eigen::VectorXd &k)
 {
     Eigen::Index n = k.size();
-    A_ = Eigen::MatrixXd(n, n);
+    Eigen::MatrixXd A(n, n);
 
     for (Eigen::Index i = 0; i < n; ++i)
     {
         for (Eigen::Index j = 0; j < n; ++j)
         {
-            double r = (k(i) - k(j));
-            A_(i, j) = std::sqrt(1 + (epsilon_ * epsilon_ * r * r));
+            A(i, j) = kernel(k(i) - k(j));
         }
-        A_(i, i) += smoothing_;
+        A(i, i) += smoothing_;
     }
 
-    weights_ = A_.ldlt().solve(y);
+    ldlt_.compute(A);
+    base_k_ = k;
+    edit_ = RBFCenterEdit::None;
 }
 
 /**
- * @brief Function to interpolate the values for all inputs.
+ * @brief Checks whether the centers equal the factorized ones up to a single insertion or removal.
+ *
+ * On success the solve against the cached factor that the edit needs is precomputed.
+ *
+ * @param k New centers.
+ * @return bool True if the cached factorization can be reused for k.
+ */
+bool RBFInterpolator::match_centers(const Eigen::VectorXd &k)
+{
+    Eigen::Index n = base_k_.size();
+    Eigen::Index m = k.size();
+    Eigen::Index p = 0;
+    Eigen::Index common = std::min(n, m);
+    while (p < common && k(p) == base_k_(p))
+    {
+        ++p;
+    }
+
+    if (m == n)
+    {
+        if (p != n)
+            return false;
+        edit_ = RBFCenterEdit::None;
+        return true;
+    }
+
+    if (m == n + 1)
+    {
+        if (k.tail(n - p) != base_k_.tail(n - p))
+            return false;
+
+        edit_column_.resize(n);
+        for (Eigen::Index i = 0; i < n; ++i)
+        {
+            edit_column_(i) = kernel(base_k_(i) - k(p));
+        }
+        edit_solution_ = ldlt_.solve(edit_column_);
+        edit_schur_ = kernel(0.0) + smoothing_ - edit_column_.dot(edit_solution_);
+        if (!std::isfinite(edit_schur_) || edit_schur_ == 0.0)
+            return false;
+
+        edit_ = RBFCenterEdit::Added;
+        edit_index_ = p;
+        return true;
+    }
+
+    if (m + 1 == n)
+    {
+        if (k.tail(m - p) != base_k_.tail(m - p))
+            return false;
+
+        edit_solution_ = ldlt_.solve(Eigen::VectorXd::Unit(n, p));
+        if (!std::isfinite(edit_solution_(p)) || edit_solution_(p) == 0.0)
+            return false;
+
+        edit_ = RBFCenterEdit::Removed;
+        edit_index_ = p;
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Solves for the weights of y_ using the cached factorization and the current edit.
+ *
+ * Added: the kernel matrix is the factorized one bordered by column b and diagonal d, so with
+ * u = A^-1 b the new weight is (y_p - b.A^-1 y_rest) / (d - b.u) and the others follow by
+ * back-substitution. Removed: the factorized system is solved with a zero right-hand side at
+ * the dropped center plus the multiple of A^-1 e_p that makes that weight vanish.
+ */
+void RBFInterpolator::solve_weights()
+{
+    Eigen::Index n = base_k_.size();
+    Eigen::Index p = edit_index_;
+
+    if (edit_ == RBFCenterEdit::None)
+    {
+        weights_ = ldlt_.solve(y_);
+    }
+    else if (edit_ == RBFCenterEdit::Added)
+    {
+        Eigen::VectorXd rest(n);
+        rest << y_.head(p), y_.tail(n - p);
+        Eigen::VectorXd v = ldlt_.solve(rest);
+        double w_new = (y_(p) - edit_column_.dot(v)) / edit_schur_;
+        v -= w_new * edit_solution_;
+
+        weights_.resize(n + 1);
+        weights_ << v.head(p), w_new, v.tail(n - p);
+    }
+    else
+    {
+        Eigen::VectorXd padded(n);
+        padded << y_.head(p), 0.0, y_.tail(n - 1 - p);
+        Eigen::VectorXd v = ldlt_.solve(padded);
+        v -= (v(p) / edit_solution_(p)) * edit_solution_;
+
+        weights_.resize(n - 1);
+        weights_ << v.head(p), v.tail(n - 1 - p);
+
+        // Removing the multiple of A^-1 e_p cancels large terms; one refinement step on the residual recovers the accuracy of a fresh solve
+        Eigen::VectorXd residual = y_ - smoothing_ * weights_;
+        for (Eigen::Index i = 0; i < n - 1; ++i)
+        {
+            for (Eigen::Index j = 0; j < n - 1; ++j)
+            {
+                residual(i) -= kernel(k_(i) - k_(j)) * weights_(j);
+            }
+        }
+        padded << residual.head(p), 0.0, residual.tail(n - 1 - p);
+        v = ldlt_.solve(padded);
+        v -= (v(p) / edit_solution_(p)) * edit_solution_;
+        weights_.head(p) += v.head(p);
+        weights_.tail(n - 1 - p) += v.tail(n - 1 - p);
+    }
+}
+
+/**
+ * @brief Evaluates the interpolant for the grid points in [begin, end).
+ *
+ * Grid points are processed in tiles of RBF_TILE_SIZE; for every center the kernel of the
+ * whole tile is evaluated as one Eigen array expression, which vectorizes the square roots.
+ * Each point accumulates the centers in the same order as a scalar loop would.
  *
  * @param x Vector of points where interpolation is evaluated.
- * @return Eigen::VectorXd Vector of interpolated values.
+ * @param begin First grid point to evaluate.
+ * @param end One past the last grid point to evaluate.
+ * @param result Output vector, already sized to x.size().
  */
-Eigen::VectorXd RBFInterpolator::interpolate(const Eigen::VectorXd &x)
+void RBFInterpolator::interpolate_range(const Eigen::Ref<const Eigen::VectorXd> &x, Eigen::Index begin, Eigen::Index end, Eigen::VectorXd &result) const
 {
     Eigen::Index n = k_.size();
-    Eigen::Index m = x.size();
-    Eigen::VectorXd result = Eigen::VectorXd::Zero(m);
+    double epsilon2 = epsilon_ * epsilon_;
 
-    for (Eigen::Index i = 0; i < m; ++i)
+    Eigen::Array<double, Eigen::Dynamic, 1, 0, RBF_TILE_SIZE, 1> tile;
+    Eigen::Array<double, Eigen::Dynamic, 1, 0, RBF_TILE_SIZE, 1> accumulator;
+
+    for (Eigen::Index tile_begin = begin; tile_begin < end; tile_begin += RBF_TILE_SIZE)
     {
+        Eigen::Index tile_size = std::min(RBF_TILE_SIZE, end - tile_begin);
+        tile = x.segment(tile_begin, tile_size).array();
+        accumulator.setZero(tile_size);
+
         for (Eigen::Index j = 0; j < n; ++j)
         {
-            double r = (x(i) - k_(j));
-            result(i) += weights_(j) * std::sqrt(1 + (epsilon_ * epsilon_ * r * r));
+            double center = k_(j);
+            accumulator += weights_(j) * (1 + epsilon2 * (tile - center) * (tile - center)).sqrt();
         }
+
+        result.segment(tile_begin, tile_size) = accumulator.matrix();
     }
+}
+
+/**
+ * @brief Function to interpolate the value at a single point.
+ *
+ * @param x Point where interpolation is evaluated.
+ * @return double Interpolated value.
+ */
+double RBFInterpolator::interpolate(double x) const
+{
+    double epsilon2 = epsilon_ * epsilon_;
+    return (weights_.array() * (1 + epsilon2 * (k_.array() - x).square()).sqrt()).sum();
+}
 
+/**
+ * @brief Function to interpolate the values for all inputs.
+ *
+ * @param x Vector of points where interpolation is evaluated.
+ * @return Eigen::VectorXd Vector of interpolated values.
+ */
+Eigen::VectorXd RBFInterpolator::interpolate(const Eigen::Ref<const Eigen::VectorXd> &x) const
+{
+    Eigen::VectorXd result(x.size());
+    interpolate_range(x, 0, x.size(), result);
     return result;
 }
@@ -0,0 +1,85 @@
+#include "replay.h"
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "pipeline.h"
+#include "snapshot_log.h"
+
+/**
+ * @brief Snapshots allowed in flight per worker before the reader helps run them instead of decoding more.
+ */
+constexpr std::size_t REPLAY_IN_FLIGHT_PER_WORKER = 4;
+
+/**
+ * @brief Feeds the snapshots of a log through perform_option_interpolation on the pool.
+ *
+ * With a positive speed each snapshot is released at its recorded time divided by speed,
+ * measured from the first snapshot; with speed 0 snapshots are released as fast as the
+ * pool takes them. The reading thread runs pending snapshots itself while the pool is
+ * saturated, so a fast replay keeps a bounded number of decoded snapshots in memory.
+ *
+ * @param file_path Path of the snapshot log.
+ * @param pool Pool the snapshots are processed on.
+ * @param speed Replay speed relative to the recording; 0 replays as fast as possible.
+ * @param quiet Discard the per-snapshot output.
+ * @param stats Receives the number of snapshots, the replay time and the recorded time span.
+ * @return bool False if the log cannot be read.
+ */
+bool replay_snapshot_log(const std::string &file_path, WorkStealingPool &pool, double speed, bool quiet, ReplayStats &stats)
+{
+    SnapshotReader reader(file_path);
+    if (!reader.is_open())
+        return false;
+
+    std::mutex output_mutex;
+    std::atomic<std::size_t> in_flight(0);
+    std::size_t in_flight_limit = REPLAY_IN_FLIGHT_PER_WORKER * pool.worker_count();
+
+    stats = ReplayStats{0, 0.0, 0.0};
+    std::int64_t first_timestamp = 0;
+    auto start = std::chrono::steady_clock::now();
+
+    auto snapshot = std::make_shared<ChainSnapshot>();
+    while (reader.next(*snapshot))
+    {
+        if (stats.snapshots == 0)
+            first_timestamp = snapshot->timestamp_ms;
+        stats.recorded_ms = static_cast<double>(snapshot->timestamp_ms - first_timestamp);
+
+        if (speed > 0)
+        {
+            auto due = start + std::chrono::microseconds(static_cast<std::int64_t>(stats.recorded_ms * 1000 / speed));
+            std::this_thread::sleep_until(due);
+        }
+
+        while (in_flight.load() >= in_flight_limit)
+        {
+            if (!pool.run_pending_task())
+                std::this_thread::yield();
+        }
+
+        ++in_flight;
+        pool.submit([snapshot, quiet, &pool, &output_mutex, &in_flight]()
+                    {
+                        std::ostringstream log;
+                        perform_option_interpolation(log, *snapshot, &pool);
+                        if (!quiet)
+                        {
+                            std::lock_guard<std::mutex> lock(output_mutex);
+                            std::cout << log.str() << std::flush;
+                        }
+                        --in_flight;
+                    });
+
+        ++stats.snapshots;
+        snapshot = std::make_shared<ChainSnapshot>();
+    }
+
+    pool.wait_idle();
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
@@ -0,0 +1,468 @@
+#include "scheduler.h"
+#include "trace.h"
+#include <algorithm>
+
+/**
+ * @brief Pool the current thread works for, or nullptr outside of any pool.
+ */
+static thread_local const WorkStealingPool *current_pool = nullptr;
+
+/**
+ * @brief Index of the current thread's deque within current_pool.
+ */
+static thread_local unsigned int current_worker = 0;
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param num_workers Number of worker threads; 0 uses the hardware concurrency.
+ */
+WorkStealingPool::WorkStealingPool(unsigned int num_workers)
+    : stopping_(false), next_queue_(0), queued_(0), unfinished_(0)
+{
+    if (num_workers == 0)
+    {
+        num_workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 0; i < num_workers; ++i)
+    {
+        queues_.push_back(std::make_unique<WorkerQueue>());
+    }
+
+    threads_.reserve(num_workers);
+    for (unsigned int i = 0; i < num_workers; ++i)
+    {
+        threads_.emplace_back([this, i]()
+                              { worker_loop(i); });
+    }
+}
+
+/**
+ * @brief Finishes the queued tasks and joins the worker threads.
+ */
+WorkStealingPool::~WorkStealingPool()
+{
+    wait_idle();
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+
+    for (std::thread &thread : threads_)
+    {
+        thread.join();
+    }
+}
+
+/**
+ * @brief Number of worker threads.
+ *
+ * @return unsigned int The worker count.
+ */
+unsigned int WorkStealingPool::worker_count() const
+{
+    return static_cast<unsigned int>(threads_.size());
+}
+
+/**
+ * @brief Queues a task.
+ *
+ * @param task Task to run on one of the workers.
+ */
+void WorkStealingPool::submit(std::function<void()> task)
+{
+    unsigned int index;
+    if (current_pool == this)
+    {
+        index = current_worker;
+    }
+    else
+    {
+        index = static_cast<unsigned int>(next_queue_.fetch_add(1) % queues_.size());
+    }
+
+    unfinished_.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        queued_.fetch_add(1);
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+/**
+ * @brief Pops the oldest task of a worker's own deque.
+ *
+ * @param index Worker index.
+ * @param task Receives the task.
+ * @return bool True if a task was taken.
+ */
+bool WorkStealingPool::pop_local(unsigned int index, std::function<void()> &task)
+{
+    WorkerQueue &queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty())
+        return false;
+
+    task = std::move(queue.tasks.front());
+    queue.tasks.pop_front();
+    queued_.fetch_sub(1);
+    return true;
+}
+
+/**
+ * @brief Takes the newest task of another worker's deque, i.e. the one its owner would reach last.
+ *
+ * @param thief Index of the deque to skip, or queues_.size() to consider every deque.
+ * @param task Receives the task.
+ * @return bool True if a task was taken.
+ */
+bool WorkStealingPool::steal(unsigned int thief, std::function<void()> &task)
+{
+    std::size_t n = queues_.size();
+    for (std::size_t offset = 1; offset <= n; ++offset)
+    {
+        std::size_t victim = (thief + offset) % n;
+        if (victim == thief)
+            continue;
+
+        WorkerQueue &queue = *queues_[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty())
+            continue;
+
+        task = std::move(queue.tasks.back());
+        queue.tasks.pop_back();
+        queued_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Runs a task and signals waiters once no work is left.
+ *
+ * @param task Task to run.
+ */
+void WorkStealingPool::run_task(std::function<void()> &task)
+{
+    task();
+    task = nullptr;
+
+    if (unfinished_.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex_);
+        idle_.notify_all();
+    }
+}
+
+/**
+ * @brief Runs one queued task on the calling thread, if there is one.
+ *
+ * Lets a thread that waits for pool work help with it instead of blocking.
+ *
+ * @return bool True if a task was run.
+ */
+bool WorkStealingPool::run_pending_task()
+{
+    std::function<void()> task;
+    bool found = current_pool == this ? pop_local(current_worker, task) || steal(current_worker, task)
+                                      : steal(static_cast<unsigned int>(queues_.size()), task);
+    if (found)
+    {
+        run_task(task);
+    }
+    return found;
+}
+
+/**
+ * @brief Blocks until every submitted task has finished.
+ *
+ * Must not be called from a worker of this pool.
+ */
+void WorkStealingPool::wait_idle()
+{
+    std::unique_lock<std::mutex> lock(wake_mutex_);
+    idle_.wait(lock, [this]()
+               { return unfinished_.load() == 0; });
+}
+
+/**
+ * @brief Main loop of a worker thread.
+ *
+ * @param index Worker index.
+ */
+void WorkStealingPool::worker_loop(unsigned int index)
+{
+    current_pool = this;
+    current_worker = index;
+    set_trace_thread_name("worker " + std::to_string(index));
+
+    std::function<void()> task;
+    while (true)
+    {
+        if (pop_local(index, task) || steal(index, task))
+        {
+            run_task(task);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex_);
+        wake_.wait(lock, [this]()
+                   { return stopping_.load() || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0)
+            return;
+    }
+}
+
+/**
+ * @brief Adds a node to the graph.
+ *
+ * @param name Trace event name of the node; must outlive the trace (a string literal).
+ * @param task Work of the node.
+ * @param dependencies Previously added nodes that must finish before this one starts.
+ * @return TaskGraph::NodeId The id of the new node.
+ */
+TaskGraph::NodeId TaskGraph::add(const char *name, std::function<void()> task, std::initializer_list<NodeId> dependencies)
+{
+    NodeId id = nodes_.size();
+    auto node = std::make_unique<Node>();
+    node->name = name;
+    node->task = std::move(task);
+    node->dependency_count = static_cast<int>(dependencies.size());
+    for (NodeId dependency : dependencies)
+    {
+        nodes_[dependency]->successors.push_back(id);
+    }
+    nodes_.push_back(std::move(node));
+    return id;
+}
+
+/**
+ * @brief Number of nodes in the graph.
+ *
+ * @return std::size_t The node count.
+ */
+std::size_t TaskGraph::size() const
+{
+    return nodes_.size();
+}
+
+/**
+ * @brief Queues a ready node on the graph's ready list and submits a pool task to take it.
+ *
+ * The task holds only the list and a pointer to the graph; if another thread has taken the
+ * node by the time it runs, it finds nothing to do and never touches the graph.
+ *
+ * @param pool Pool the task is submitted to.
+ * @param id Ready node.
+ */
+void TaskGraph::enqueue(WorkStealingPool &pool, NodeId id)
+{
+    {
+        std::lock_guard<std::mutex> lock(ready_->mutex);
+        ready_->nodes.push_back(id);
+    }
+    ready_->changed.notify_one();
+
+    pool.submit([this, &pool, ready = ready_]()
+                {
+                    NodeId next;
+                    if (take(*ready, next))
+                        run_from(pool, next);
+                });
+}
+
+/**
+ * @brief Takes the oldest node from a ready list.
+ *
+ * @param ready Ready list.
+ * @param id Receives the node.
+ * @return bool False if the list is empty.
+ */
+bool TaskGraph::take(ReadyList &ready, NodeId &id)
+{
+    std::lock_guard<std::mutex> lock(ready.mutex);
+    if (ready.nodes.empty())
+        return false;
+    id = ready.nodes.front();
+    ready.nodes.pop_front();
+    return true;
+}
+
+/**
+ * @brief Runs a node, then keeps running the first successor each node makes ready and queues the rest.
+ *
+ * @param pool Pool the other ready successors are taken from.
+ * @param id Node to start with.
+ */
+void TaskGraph::run_from(WorkStealingPool &pool, NodeId id)
+{
+    // The graph may be gone as soon as the last node is counted, so the final wakeup goes through a reference of our own
+    std::shared_ptr<ReadyList> ready = ready_;
+    while (true)
+    {
+        Node &node = *nodes_[id];
+        {
+            TRACE_SCOPE(node.name);
+            node.task();
+        }
+
+        bool has_next = false;
+        NodeId next = 0;
+        for (NodeId successor : node.successors)
+        {
+            if (nodes_[successor]->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                continue;
+
+            if (!has_next)
+            {
+                next = successor;
+                has_next = true;
+            }
+            else
+            {
+                enqueue(pool, successor);
+            }
+        }
+
+        if (remaining_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            // Locked so the waiter cannot miss the wakeup between checking remaining_ and sleeping
+            std::lock_guard<std::mutex> lock(ready->mutex);
+            ready->changed.notify_all();
+        }
+        if (!has_next)
+            return;
+        id = next;
+    }
+}
+
+/**
+ * @brief Runs every node once and returns when all of them have finished.
+ *
+ * The first node without dependencies starts on the calling thread, which then takes ready
+ * nodes of this graph until none is left and sleeps while the remaining ones run elsewhere; it
+ * never picks up unrelated pool tasks. Without a pool the nodes run on the calling thread in
+ * insertion order. The graph can be run again once run() has returned.
+ *
+ * @param pool Pool the nodes run on, or nullptr to run them serially.
+ */
+void TaskGraph::run(WorkStealingPool *pool)
+{
+    if (pool == nullptr)
+    {
+        for (const std::unique_ptr<Node> &node : nodes_)
+        {
+            TRACE_SCOPE(node->name);
+            node->task();
+        }
+        return;
+    }
+
+    remaining_.store(nodes_.size(), std::memory_order_relaxed);
+    for (const std::unique_ptr<Node> &node : nodes_)
+    {
+        node->pending.store(node->dependency_count, std::memory_order_relaxed);
+    }
+
+    bool has_first = false;
+    NodeId first = 0;
+    for (NodeId id = 0; id < nodes_.size(); ++id)
+    {
+        if (nodes_[id]->dependency_count != 0)
+            continue;
+
+        if (!has_first)
+        {
+            first = id;
+            has_first = true;
+        }
+        else
+        {
+            enqueue(*pool, id);
+        }
+    }
+
+    if (has_first)
+    {
+        run_from(*pool, first);
+    }
+
+    while (true)
+    {
+        NodeId next;
+        {
+            std::unique_lock<std::mutex> lock(ready_->mutex);
+            ready_->changed.wait(lock, [this]()
+                                 { return !ready_->nodes.empty() || remaining_.load(std::memory_order_acquire) == 0; });
+            if (ready_->nodes.empty())
+                return;
+            next = ready_->nodes.front();
+            ready_->nodes.pop_front();
+        }
+        run_from(*pool, next);
+    }
+}
+
+/**
+ * @brief Runs one cycle of jobs on the pool and waits for it to finish.
+ *
+ * The jobs are submitted starting at position rotation (modulo the job count), so that
+ * rotating the offset every cycle moves each job through the front of the queue in turn and
+ * none is always last. A job that has not started by the deadline is skipped; a job that
+ * finishes after it is counted as overrunning. Running jobs are never interrupted.
+ *
+ * @param pool Pool to run the jobs on.
+ * @param jobs Jobs of the cycle.
+ * @param rotation Offset of the first job to submit.
+ * @param deadline Time budget of the cycle, measured from its start; zero disables it.
+ * @return CycleStats Counts of completed, expired and overrunning jobs.
+ */
+CycleStats run_job_cycle(WorkStealingPool &pool, const std::vector<std::function<void()>> &jobs, std::size_t rotation, std::chrono::milliseconds deadline)
+{
+    using Clock = std::chrono::steady_clock;
+
+    Clock::time_point start = Clock::now();
+    Clock::time_point due = start + deadline;
+    bool has_deadline = deadline.count() > 0;
+
+    std::atomic<std::size_t> completed(0);
+    std::atomic<std::size_t> expired(0);
+    std::atomic<std::size_t> overran(0);
+
+    std::size_t n = jobs.size();
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const std::function<void()> *job = &jobs[(rotation + i) % n];
+        pool.submit([job, has_deadline, due, &completed, &expired, &overran]()
+                    {
+                        if (has_deadline && Clock::now() > due)
+                        {
+                            expired.fetch_add(1);
+                            return;
+                        }
+
+                        (*job)();
+                        completed.fetch_add(1);
+                        if (has_deadline && Clock::now() > due)
+                        {
+                            overran.fetch_add(1);
+                        }
+                    });
+    }
+
+    pool.wait_idle();
+
+    CycleStats stats;
+    stats.completed = completed.load();
+    stats.expired = expired.load();
+    stats.overran = overran.load();
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,211 @@
+#include "smile_surface.h"
+#include "interpolations.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Normalizes strikes to [0.5, 1.5] over their range and takes the log, as both fits expect.
+ *
+ * @param strikes Strike prices of the chain.
+ * @return SmileCoordinates The strike range and the normalized and log-normalized strikes.
+ */
+SmileCoordinates make_smile_coordinates(const Eigen::Ref<const Eigen::VectorXd> &strikes)
+{
+    SmileCoordinates coordinates;
+    coordinates.x_min = strikes.minCoeff();
+    coordinates.x_max = strikes.maxCoeff();
+    coordinates.x_normalized = (strikes.array() - coordinates.x_min) / (coordinates.x_max - coordinates.x_min) + 0.5;
+    coordinates.log_x_normalized = coordinates.x_normalized.array().log();
+    return coordinates;
+}
+
+/**
+ * @brief Fits the RBF part of a smile.
+ *
+ * @param coordinates Fit coordinates of the strikes.
+ * @param mid_iv Mid implied volatilities, one per strike.
+ * @param cache_key Key identifying the chain, used to reuse its factorization.
+ * @return std::shared_ptr<const RBFInterpolator> The fitted interpolator.
+ */
+std::shared_ptr<const RBFInterpolator> fit_smile_rbf(
+    const SmileCoordinates &coordinates,
+    const Eigen::Ref<const Eigen::VectorXd> &mid_iv,
+    const std::string &cache_key)
+{
+    return fit_rbf(coordinates.log_x_normalized, mid_iv, 0.5, cache_key);
+}
+
+/**
+ * @brief Fits the RFV part of a smile.
+ *
+ * @param coordinates Fit coordinates of the strikes.
+ * @param mid_iv Mid implied volatilities, one per strike.
+ * @param bid_iv Bid implied volatilities, one per strike.
+ * @param ask_iv Ask implied volatilities, one per strike.
+ * @param cache_key Key identifying the chain, used to warm-start the fit.
+ * @param fit_stats Optional output for the minimizer evaluations and iterations spent.
+ * @return Eigen::VectorXd The RFV parameters [a, b, c, d, e].
+ */
+Eigen::VectorXd fit_smile_rfv(
+    const SmileCoordinates &coordinates,
+    const Eigen::Ref<const Eigen::VectorXd> &mid_iv,
+    const Eigen::Ref<const Eigen::VectorXd> &bid_iv,
+    const Eigen::Ref<const Eigen::VectorXd> &ask_iv,
+    const std::string &cache_key,
+    RFVFitStats *fit_stats)
+{
+    return fit_model(coordinates.x_normalized, mid_iv, bid_iv, ask_iv, cache_key, fit_stats);
+}
+
+/**
+ * @brief Fits the RFV and RBF models of a chain, one after the other.
+ *
+ * @param strikes Strike prices of the chain.
+ * @param mid_iv Mid implied volatilities, one per strike.
+ * @param bid_iv Bid implied volatilities, one per strike.
+ * @param ask_iv Ask implied volatilities, one per strike.
+ * @param cache_key Key identifying the chain, used to warm-start both fits.
+ * @param trace Optional output for the duration of each fit and the RFV minimizer work.
+ */
+SmileSurface::SmileSurface(
+    const Eigen::Ref<const Eigen::VectorXd> &strikes,
+    const Eigen::Ref<const Eigen::VectorXd> &mid_iv,
+    const Eigen::Ref<const Eigen::VectorXd> &bid_iv,
+    const Eigen::Ref<const Eigen::VectorXd> &ask_iv,
+    const std::string &cache_key,
+    SmileFitTrace *trace)
+{
+    SmileCoordinates coordinates = make_smile_coordinates(strikes);
+    x_min_ = coordinates.x_min;
+    x_max_ = coordinates.x_max;
+
+    auto start = std::chrono::steady_clock::now();
+    rbf_ = fit_smile_rbf(coordinates, mid_iv, cache_key);
+    auto rbf_done = std::chrono::steady_clock::now();
+
+    RFVFitStats rfv_stats;
+    rfv_params_ = fit_smile_rfv(coordinates, mid_iv, bid_iv, ask_iv, cache_key, &rfv_stats);
+
+    if (trace)
+    {
+        trace->rbf_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(rbf_done - start).count();
+        trace->rfv_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - rbf_done).count();
+        trace->rfv = rfv_stats;
+    }
+}
+
+/**
+ * @brief Combines RFV and RBF fits that were run separately.
+ *
+ * @param coordinates Fit coordinates of the strikes both models were fitted to.
+ * @param rfv_params RFV parameters from fit_smile_rfv.
+ * @param rbf Interpolator from fit_smile_rbf.
+ */
+SmileSurface::SmileSurface(
+    const SmileCoordinates &coordinates,
+    Eigen::VectorXd rfv_params,
+    std::shared_ptr<const RBFInterpolator> rbf)
+    : x_min_(coordinates.x_min), x_max_(coordinates.x_max), rfv_params_(std::move(rfv_params)), rbf_(std::move(rbf))
+{
+}
+
+/**
+ * @brief Maps a strike to the log-moneyness coordinate the models were fitted in.
+ *
+ * @param strike Strike price, clamped to the fitted range.
+ * @return double Log of the normalized strike.
+ */
+double SmileSurface::log_moneyness(double strike) const
+{
+    double clamped = std::clamp(strike, x_min_, x_max_);
+    return std::log((clamped - x_min_) / (x_max_ - x_min_) + 0.5);
+}
+
+/**
+ * @brief Evaluates the blended implied volatility at a single strike.
+ *
+ * @param strike Strike price.
+ * @return double The implied volatility of the smile at that strike.
+ */
+double SmileSurface::evaluate(double strike) const
+{
+    double k = log_moneyness(strike);
+    return SMILE_RFV_WEIGHT * rfv_model(k, rfv_params_) + (1.0 - SMILE_RFV_WEIGHT) * rbf_->interpolate(k);
+}
+
+/**
+ * @brief Evaluates the blended implied volatility at many strikes.
+ *
+ * @param strikes Strike prices.
+ * @return Eigen::VectorXd The implied volatility of the smile at each strike.
+ */
+Eigen::VectorXd SmileSurface::evaluate(const Eigen::Ref<const Eigen::VectorXd> &strikes) const
+{
+    Eigen::VectorXd k = ((strikes.array().max(x_min_).min(x_max_) - x_min_) / (x_max_ - x_min_) + 0.5).log();
+    return SMILE_RFV_WEIGHT * rfv_model(k, rfv_params_) + (1.0 - SMILE_RFV_WEIGHT) * rbf_->interpolate(k);
+}
+
+/**
+ * @brief Evenly spaced strikes over the fitted range, e.g. for plotting the smile.
+ *
+ * @param points Number of strikes.
+ * @return Eigen::VectorXd The strikes.
+ */
+Eigen::VectorXd SmileSurface::strike_grid(Eigen::Index points) const
+{
+    return Eigen::VectorXd::LinSpaced(points, x_min_, x_max_);
+}
+
+/**
+ * @brief Lowest fitted strike.
+ *
+ * @return double The strike.
+ */
+double SmileSurface::min_strike() const
+{
+    return x_min_;
+}
+
+/**
+ * @brief Highest fitted strike.
+ *
+ * @return double The strike.
+ */
+double SmileSurface::max_strike() const
+{
+    return x_max_;
+}
+
+/**
+ * @brief Parameters of the RFV fit.
+ *
+ * @return const Eigen::VectorXd& The parameters [a, b, c, d, e].
+ */
+const Eigen::VectorXd &SmileSurface::rfv_params() const
+{
+    return rfv_params_;
+}
+
+/**
+ * @brief RBF fit, centered on the log-moneyness of the fitted strikes.
+ *
+ * @return const RBFInterpolator& The interpolator.
+ */
+const RBFInterpolator &SmileSurface::rbf() const
+{
+    return *rbf_;
+}
+
+/**
+ * @brief Copy of the smile that does not share its RBF fit, for holders that outlive the fit.
+ *
+ * @return std::shared_ptr<const SmileSurface> A smile that evaluates like this one.
+ */
+std::shared_ptr<const SmileSurface> SmileSurface::snapshot() const
+{
+    auto copy = std::make_shared<SmileSurface>(*this);
+    copy->rbf_ = rbf_->snapshot();
+    return copy;
+}
@@ -0,0 +1,479 @@
+#include "snapshot_log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+/**
+ * @brief Magic bytes at the start of a snapshot log.
+ */
+static const char SNAPSHOT_MAGIC[8] = {'O', 'K', 'B', 'S', 'N', 'A', 'P', '1'};
+
+/**
+ * @brief Initial size of a new log; the mapping doubles whenever it fills up.
+ */
+constexpr std::size_t SNAPSHOT_INITIAL_CAPACITY = 1 << 20;
+
+/**
+ * @brief Column tag for values stored as raw doubles because no fixed-point scale fits.
+ */
+constexpr unsigned char SNAPSHOT_RAW_COLUMN = 0xFF;
+
+/**
+ * @brief Most decimals tried for the fixed-point encoding of a column.
+ */
+constexpr int SNAPSHOT_MAX_DECIMALS = 6;
+
+/**
+ * @brief Appends an unsigned LEB128 varint.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_varint(std::uint64_t value, std::string &out)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Appends a signed value as a zigzag varint, so small negative deltas stay short.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_zigzag(std::int64_t value, std::string &out)
+{
+    put_varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63), out);
+}
+
+/**
+ * @brief Appends a 64-bit word in little-endian order.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_fixed64(std::uint64_t value, std::string &out)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+/**
+ * @brief Appends the bits of a double in little-endian order.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_double(double value, std::string &out)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_fixed64(bits, out);
+}
+
+/**
+ * @brief Appends a length-prefixed string.
+ *
+ * @param value Value to append.
+ * @param out Output buffer.
+ */
+static void put_string(const std::string &value, std::string &out)
+{
+    put_varint(value.size(), out);
+    out += value;
+}
+
+/**
+ * @brief Bounds-checked reader over an encoded snapshot.
+ */
+struct SnapshotCursor
+{
+    const unsigned char *data;
+    std::size_t length;
+    std::size_t offset;
+    bool ok;
+
+    std::uint64_t varint()
+    {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64 && offset < length; shift += 7)
+        {
+            unsigned char byte = data[offset++];
+            value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::int64_t zigzag()
+    {
+        std::uint64_t value = varint();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+
+    std::uint64_t fixed64()
+    {
+        if (length - offset < 8)
+        {
+            ok = false;
+            return 0;
+        }
+        std::uint64_t value = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            value |= static_cast<std::uint64_t>(data[offset + i]) << (8 * i);
+        }
+        offset += 8;
+        return value;
+    }
+
+    double real()
+    {
+        std::uint64_t bits = fixed64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+
+    unsigned char byte()
+    {
+        if (offset >= length)
+        {
+            ok = false;
+            return 0;
+        }
+        return data[offset++];
+    }
+
+    std::string string()
+    {
+        std::uint64_t size = varint();
+        if (!ok || length - offset < size)
+        {
+            ok = false;
+            return std::string();
+        }
+        std::string value(reinterpret_cast<const char *>(data + offset), static_cast<std::size_t>(size));
+        offset += static_cast<std::size_t>(size);
+        return value;
+    }
+};
+
+/**
+ * @brief Finds the fewest decimals at which every value of a column is an exact fixed-point number.
+ *
+ * @param column Column values.
+ * @return int The number of decimals, or -1 if none up to SNAPSHOT_MAX_DECIMALS fits.
+ */
+static int fixed_point_decimals(const std::vector<double> &column)
+{
+    double scale = 1.0;
+    for (int decimals = 0; decimals <= SNAPSHOT_MAX_DECIMALS; ++decimals, scale *= 10.0)
+    {
+        bool exact = std::all_of(column.begin(), column.end(), [scale](double value)
+                                 {
+                                     double ticks = std::round(value * scale);
+                                     return std::abs(ticks) < 9007199254740992.0 && ticks / scale == value; });
+        if (exact)
+            return decimals;
+    }
+    return -1;
+}
+
+/**
+ * @brief Encodes one column, delta-encoded in fixed point when possible and raw otherwise.
+ *
+ * @param column Column values.
+ * @param out Buffer the encoding is appended to.
+ */
+static void put_column(const std::vector<double> &column, std::string &out)
+{
+    int decimals = fixed_point_decimals(column);
+    if (decimals < 0)
+    {
+        out.push_back(static_cast<char>(SNAPSHOT_RAW_COLUMN));
+        for (double value : column)
+        {
+            put_double(value, out);
+        }
+        return;
+    }
+
+    out.push_back(static_cast<char>(decimals));
+    double scale = std::pow(10.0, decimals);
+    std::int64_t previous = 0;
+    for (double value : column)
+    {
+        std::int64_t ticks = static_cast<std::int64_t>(std::round(value * scale));
+        put_zigzag(ticks - previous, out);
+        previous = ticks;
+    }
+}
+
+/**
+ * @brief Decodes one column written by put_column.
+ *
+ * @param cursor Encoded input.
+ * @param count Number of values.
+ * @param column Receives the values.
+ */
+static void get_column(SnapshotCursor &cursor, std::size_t count, std::vector<double> &column)
+{
+    column.resize(count);
+    unsigned char tag = cursor.byte();
+    if (tag == SNAPSHOT_RAW_COLUMN)
+    {
+        for (double &value : column)
+        {
+            value = cursor.real();
+        }
+        return;
+    }
+    if (tag > SNAPSHOT_MAX_DECIMALS)
+    {
+        cursor.ok = false;
+        return;
+    }
+
+    double scale = std::pow(10.0, tag);
+    std::int64_t ticks = 0;
+    for (double &value : column)
+    {
+        ticks += cursor.zigzag();
+        value = static_cast<double>(ticks) / scale;
+    }
+}
+
+/**
+ * @brief Serializes a snapshot. Only the quote columns of the chain are stored; the IV columns are outputs.
+ *
+ * @param snapshot Snapshot to encode.
+ * @param out Buffer the encoding is written to (cleared first).
+ */
+void encode_chain_snapshot(const ChainSnapshot &snapshot, std::string &out)
+{
+    out.clear();
+    put_zigzag(snapshot.timestamp_ms, out);
+    put_string(snapshot.entry.ticker, out);
+    put_zigzag(snapshot.entry.date_index, out);
+    put_string(snapshot.entry.date, out);
+    out.push_back(static_cast<char>(snapshot.entry.option_kind));
+    put_double(snapshot.entry.min_overpriced, out);
+    put_double(snapshot.entry.min_underpriced, out);
+    put_double(snapshot.entry.min_oi, out);
+    put_double(snapshot.S, out);
+    put_double(snapshot.T, out);
+    put_double(snapshot.q, out);
+    put_double(snapshot.r, out);
+
+    const OptionChain &chain = snapshot.chain;
+    put_varint(chain.size(), out);
+    put_column(chain.strike, out);
+    put_column(chain.bid, out);
+    put_column(chain.ask, out);
+    put_column(chain.mid, out);
+    put_column(chain.open_interest, out);
+}
+
+/**
+ * @brief Deserializes a snapshot written by encode_chain_snapshot.
+ *
+ * @param data Encoded bytes.
+ * @param length Number of bytes.
+ * @param snapshot Receives the snapshot; its IV columns are zeroed.
+ * @return bool False if the encoding is malformed.
+ */
+bool decode_chain_snapshot(const char *data, std::size_t length, ChainSnapshot &snapshot)
+{
+    SnapshotCursor cursor{reinterpret_cast<const unsigned char *>(data), length, 0, true};
+
+    snapshot.timestamp_ms = cursor.zigzag();
+    snapshot.entry.ticker = cursor.string();
+    snapshot.entry.date_index = static_cast<int>(cursor.zigzag());
+    snapshot.entry.date = cursor.string();
+    unsigned char kind = cursor.byte();
+    snapshot.entry.option_kind = kind == static_cast<unsigned char>(OptionKind::Put) ? OptionKind::Put : OptionKind::Call;
+    snapshot.entry.min_overpriced = cursor.real();
+    snapshot.entry.min_underpriced = cursor.real();
+    snapshot.entry.min_oi = cursor.real();
+    snapshot.S = cursor.real();
+    snapshot.T = cursor.real();
+    snapshot.q = cursor.real();
+    snapshot.r = cursor.real();
+
+    std::uint64_t count = cursor.varint();
+    if (!cursor.ok || count > length || kind > static_cast<unsigned char>(OptionKind::Put))
+        return false;
+
+    OptionChain &chain = snapshot.chain;
+    std::size_t rows = static_cast<std::size_t>(count);
+    get_column(cursor, rows, chain.strike);
+    get_column(cursor, rows, chain.bid);
+    get_column(cursor, rows, chain.ask);
+    get_column(cursor, rows, chain.mid);
+    get_column(cursor, rows, chain.open_interest);
+    chain.bid_iv.assign(rows, 0.0);
+    chain.ask_iv.assign(rows, 0.0);
+    chain.mid_iv.assign(rows, 0.0);
+
+    return cursor.ok && cursor.offset == length;
+}
+
+/**
+ * @brief Reads the 4-byte little-endian length of the record at an offset.
+ *
+ * @param data Mapped log.
+ * @param offset Record offset.
+ * @return std::uint32_t The payload length; 0 marks the end of the log.
+ */
+static std::uint32_t record_length(const char *data, std::size_t offset)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data + offset);
+    return static_cast<std::uint32_t>(bytes[0]) | (static_cast<std::uint32_t>(bytes[1]) << 8) |
+           (static_cast<std::uint32_t>(bytes[2]) << 16) | (static_cast<std::uint32_t>(bytes[3]) << 24);
+}
+
+/**
+ * @brief Finds the end of the last complete record of a log.
+ *
+ * @param file Mapped log, starting with the magic bytes.
+ * @return std::size_t Offset just past the last complete record.
+ */
+static std::size_t find_log_end(const MappedFile &file)
+{
+    std::size_t offset = sizeof(SNAPSHOT_MAGIC);
+    while (file.size() - offset >= 4)
+    {
+        std::uint32_t length = record_length(file.data(), offset);
+        if (length == 0 || file.size() - offset - 4 < length)
+            break;
+        offset += 4 + length;
+    }
+    return offset;
+}
+
+/**
+ * @brief Opens a log for appending, creating it if needed; new records go after the existing ones.
+ *
+ * @param file_path Path of the log.
+ */
+SnapshotRecorder::SnapshotRecorder(const std::string &file_path)
+    : used_(0)
+{
+    if (!file_.open(file_path, true))
+        return;
+
+    if (file_.size() == 0)
+    {
+        if (!file_.resize(SNAPSHOT_INITIAL_CAPACITY))
+        {
+            std::cerr << "Could not allocate snapshot log " << file_path << std::endl;
+            file_.close();
+            return;
+        }
+        std::memcpy(file_.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+        used_ = sizeof(SNAPSHOT_MAGIC);
+        return;
+    }
+
+    if (file_.size() < sizeof(SNAPSHOT_MAGIC) || std::memcmp(file_.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0)
+    {
+        std::cerr << "Not a snapshot log: " << file_path << std::endl;
+        file_.close();
+        return;
+    }
+    used_ = find_log_end(file_);
+}
+
+/**
+ * @brief Trims the log to its last record and closes it.
+ */
+SnapshotRecorder::~SnapshotRecorder()
+{
+    if (file_.is_open())
+    {
+        file_.resize(used_);
+        file_.close();
+    }
+}
+
+/**
+ * @brief Appends one snapshot. Safe to call from several threads.
+ *
+ * @param snapshot Snapshot to record.
+ */
+void SnapshotRecorder::append(const ChainSnapshot &snapshot)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_.is_open())
+        return;
+
+    encode_chain_snapshot(snapshot, scratch_);
+    std::size_t needed = used_ + 4 + scratch_.size();
+    if (needed > file_.size() && !file_.resize(std::max(needed, 2 * file_.size())))
+    {
+        std::cerr << "Could not grow snapshot log; recording stopped." << std::endl;
+        file_.close();
+        return;
+    }
+
+    char *record = file_.data() + used_;
+    std::memcpy(record + 4, scratch_.data(), scratch_.size());
+    std::uint32_t length = static_cast<std::uint32_t>(scratch_.size());
+    for (int i = 0; i < 4; ++i)
+    {
+        record[i] = static_cast<char>((length >> (8 * i)) & 0xFF);
+    }
+    used_ += 4 + scratch_.size();
+}
+
+/**
+ * @brief Opens a log for reading.
+ *
+ * @param file_path Path of the log.
+ */
+SnapshotReader::SnapshotReader(const std::string &file_path)
+    : offset_(sizeof(SNAPSHOT_MAGIC)), valid_(false)
+{
+    if (!file_.open(file_path, false))
+        return;
+
+    valid_ = file_.size() >= sizeof(SNAPSHOT_MAGIC) && std::memcmp(file_.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+    if (!valid_)
+    {
+        std::cerr << "Not a snapshot log: " << file_path << std::endl;
+    }
+}
+
+/**
+ * @brief Decodes the next snapshot.
+ *
+ * @param snapshot Receives the snapshot.
+ * @return bool False at the end of the log or on a malformed record.
+ */
+bool SnapshotReader::next(ChainSnapshot &snapshot)
+{
+    if (!valid_ || file_.size() - offset_ < 4)
+        return false;
+
+    std::uint32_t length = record_length(file_.data(), offset_);
+    if (length == 0 || file_.size() - offset_ - 4 < length)
+        return false;
+
+    if (!decode_chain_snapshot(file_.data() + offset_ + 4, length, snapshot))
+    {
+        std::cerr << "Malformed snapshot at offset " << offset_ << std::endl;
+        return false;
+    }
+    offset_ += 4 + length;
+    return true;
+}
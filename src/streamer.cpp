@@ -0,0 +1,526 @@
+#include "streamer.h"
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <random>
+#include "nlohmann/json.hpp"
+#include "quote_book.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <poll.h>
+#endif
+
+/**
+ * @brief Time to wait for the socket before checking for shutdown again, in milliseconds.
+ */
+constexpr int STREAM_POLL_INTERVAL_MS = 250;
+
+/**
+ * @brief Time allowed for the TCP connection and the WebSocket handshake, in milliseconds.
+ */
+constexpr int STREAM_HANDSHAKE_TIMEOUT_MS = 10000;
+
+/**
+ * @brief First and largest delay between reconnection attempts, in milliseconds.
+ */
+constexpr int STREAM_MIN_BACKOFF_MS = 1000;
+constexpr int STREAM_MAX_BACKOFF_MS = 30000;
+
+/**
+ * @brief Level-1 field numbers of the Schwab streamer.
+ */
+static const char *EQUITY_FIELDS = "0,1,2,3";   // symbol, bid, ask, last
+static const char *OPTION_FIELDS = "0,2,3,9";   // symbol, bid, ask, open interest
+
+/**
+ * @brief Join symbols into the comma-separated key list of a subscription request.
+ *
+ * @param symbols Symbols to join.
+ * @return std::string The key list.
+ */
+static std::string join_symbols(const std::vector<std::string> &symbols)
+{
+    std::string keys;
+    for (const std::string &symbol : symbols)
+    {
+        if (!keys.empty())
+            keys += ",";
+        keys += symbol;
+    }
+    return keys;
+}
+
+/**
+ * @brief Starts the I/O thread, which connects and keeps the stream alive until destruction.
+ *
+ * @param config Connection and subscription settings.
+ */
+StreamerClient::StreamerClient(StreamerConfig config)
+    : config_(std::move(config)), curl_(nullptr), request_id_(0), stopping_(false), has_data_(false)
+{
+    if (!config_.record_file.empty())
+    {
+        record_.open(config_.record_file, std::ios::app);
+        if (!record_.is_open())
+        {
+            std::cerr << "Could not open stream record file: " << config_.record_file << std::endl;
+        }
+    }
+
+    thread_ = std::thread([this]()
+                          { run(); });
+}
+
+/**
+ * @brief Closes the stream and joins the I/O thread.
+ */
+StreamerClient::~StreamerClient()
+{
+    stopping_ = true;
+    thread_.join();
+}
+
+/**
+ * @brief Blocks until the first data message has been applied to the quote book.
+ *
+ * @param timeout Longest time to wait.
+ * @return bool True if data arrived in time.
+ */
+bool StreamerClient::wait_for_data(std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(data_mutex_);
+    return data_ready_.wait_for(lock, timeout, [this]()
+                                { return has_data_; });
+}
+
+/**
+ * @brief I/O thread loop: connect, stream until the connection drops, back off and retry.
+ */
+void StreamerClient::run()
+{
+    int backoff_ms = STREAM_MIN_BACKOFF_MS;
+
+    while (!stopping_)
+    {
+        if (connect())
+        {
+            std::cout << "Streamer connected to " << config_.url << std::endl;
+            backoff_ms = STREAM_MIN_BACKOFF_MS;
+            stream();
+        }
+        disconnect();
+
+        if (stopping_)
+            break;
+
+        std::cerr << "Streamer disconnected, reconnecting in " << backoff_ms << " ms." << std::endl;
+        for (int waited = 0; waited < backoff_ms && !stopping_; waited += STREAM_POLL_INTERVAL_MS)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(STREAM_POLL_INTERVAL_MS));
+        }
+        backoff_ms = std::min(2 * backoff_ms, STREAM_MAX_BACKOFF_MS);
+    }
+}
+
+/**
+ * @brief Opens the TCP (or TLS) connection and performs the WebSocket handshake.
+ *
+ * libcurl only connects here (CURLOPT_CONNECT_ONLY), so the same code serves ws:// and wss://
+ * through curl's http and https transports, and the upgrade request and framing are done by hand.
+ *
+ * @return bool True if the connection is upgraded to a WebSocket.
+ */
+bool StreamerClient::connect()
+{
+    std::string url = config_.url;
+    if (url.rfind("wss://", 0) == 0)
+        url = "https://" + url.substr(6);
+    else if (url.rfind("ws://", 0) == 0)
+        url = "http://" + url.substr(5);
+
+    CURLU *parts = curl_url();
+    char *host = nullptr;
+    char *path = nullptr;
+    char *port = nullptr;
+    bool parsed = curl_url_set(parts, CURLUPART_URL, url.c_str(), 0) == CURLUE_OK &&
+                  curl_url_get(parts, CURLUPART_HOST, &host, 0) == CURLUE_OK &&
+                  curl_url_get(parts, CURLUPART_PATH, &path, 0) == CURLUE_OK;
+    std::string host_header = parsed ? host : "";
+    std::string target = parsed ? path : "/";
+    char *query = nullptr;
+    if (parsed && curl_url_get(parts, CURLUPART_QUERY, &query, 0) == CURLUE_OK)
+        target += std::string("?") + query;
+    if (parsed && curl_url_get(parts, CURLUPART_PORT, &port, 0) == CURLUE_OK)
+        host_header += std::string(":") + port;
+    curl_free(host);
+    curl_free(path);
+    curl_free(query);
+    curl_free(port);
+    curl_url_cleanup(parts);
+
+    if (!parsed)
+    {
+        std::cerr << "Invalid STREAM_URL: " << config_.url << std::endl;
+        return false;
+    }
+
+    curl_ = curl_easy_init();
+    if (!curl_)
+    {
+        std::cerr << "Failed to initialize CURL." << std::endl;
+        return false;
+    }
+
+    curl_easy_setopt(curl_, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl_, CURLOPT_CONNECT_ONLY, 1L);
+    curl_easy_setopt(curl_, CURLOPT_CONNECTTIMEOUT_MS, static_cast<long>(STREAM_HANDSHAKE_TIMEOUT_MS));
+
+    CURLcode res = curl_easy_perform(curl_);
+    if (res != CURLE_OK)
+    {
+        std::cerr << "CURL Error: " << curl_easy_strerror(res) << std::endl;
+        return false;
+    }
+
+    static thread_local std::mt19937 generator(std::random_device{}());
+    unsigned char nonce[16];
+    for (unsigned char &byte : nonce)
+    {
+        byte = static_cast<unsigned char>(generator());
+    }
+    std::string key = base64_encode(nonce, sizeof(nonce));
+
+    std::string request = "GET " + target + " HTTP/1.1\r\n"
+                          "Host: " + host_header + "\r\n"
+                          "Upgrade: websocket\r\n"
+                          "Connection: Upgrade\r\n"
+                          "Sec-WebSocket-Key: " + key + "\r\n"
+                          "Sec-WebSocket-Version: 13\r\n\r\n";
+    if (!send_all(request))
+        return false;
+
+    buffer_.clear();
+    fragments_.clear();
+    std::size_t header_end;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(STREAM_HANDSHAKE_TIMEOUT_MS);
+    while ((header_end = buffer_.find("\r\n\r\n")) == std::string::npos)
+    {
+        if (stopping_ || std::chrono::steady_clock::now() > deadline || !receive_some())
+        {
+            std::cerr << "WebSocket handshake with " << config_.url << " failed." << std::endl;
+            return false;
+        }
+    }
+
+    std::string header = buffer_.substr(0, header_end);
+    buffer_.erase(0, header_end + 4);
+    std::string lowered = header;
+    std::transform(lowered.begin(), lowered.end(), lowered.begin(), [](unsigned char c)
+                   { return static_cast<char>(std::tolower(c)); });
+
+    std::size_t accept = lowered.find("sec-websocket-accept:");
+    std::size_t value_start = accept == std::string::npos ? accept : header.find_first_not_of(' ', accept + 21);
+    std::size_t value_end = value_start == std::string::npos ? value_start : header.find("\r\n", value_start);
+    if (header.rfind("HTTP/1.1 101", 0) != 0 || value_start == std::string::npos ||
+        header.substr(value_start, value_end - value_start) != websocket_accept_key(key))
+    {
+        std::cerr << "WebSocket upgrade rejected by " << config_.url << ": " << header.substr(0, header.find("\r\n")) << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Releases the connection, if any.
+ */
+void StreamerClient::disconnect()
+{
+    if (curl_)
+    {
+        curl_easy_cleanup(curl_);
+        curl_ = nullptr;
+    }
+}
+
+/**
+ * @brief Waits until the socket is readable or writable.
+ *
+ * @param for_write Wait for writability instead of readability.
+ * @param timeout_ms Longest time to wait.
+ * @return bool False if the socket is gone or reported an error.
+ */
+bool StreamerClient::wait_socket(bool for_write, int timeout_ms)
+{
+    curl_socket_t socket = CURL_SOCKET_BAD;
+    if (curl_easy_getinfo(curl_, CURLINFO_ACTIVESOCKET, &socket) != CURLE_OK || socket == CURL_SOCKET_BAD)
+        return false;
+
+#ifdef _WIN32
+    WSAPOLLFD descriptor = {socket, static_cast<SHORT>(for_write ? POLLOUT : POLLIN), 0};
+    int ready = WSAPoll(&descriptor, 1, timeout_ms);
+#else
+    pollfd descriptor = {socket, static_cast<short>(for_write ? POLLOUT : POLLIN), 0};
+    int ready = poll(&descriptor, 1, timeout_ms);
+#endif
+    return ready >= 0 && !(descriptor.revents & POLLERR);
+}
+
+/**
+ * @brief Sends a buffer completely.
+ *
+ * @param data Bytes to send.
+ * @return bool False if the connection failed.
+ */
+bool StreamerClient::send_all(const std::string &data)
+{
+    std::size_t offset = 0;
+    while (offset < data.size())
+    {
+        std::size_t sent = 0;
+        CURLcode res = curl_easy_send(curl_, data.data() + offset, data.size() - offset, &sent);
+        if (res == CURLE_AGAIN)
+        {
+            if (stopping_ || !wait_socket(true, STREAM_POLL_INTERVAL_MS))
+                return false;
+            continue;
+        }
+        if (res != CURLE_OK)
+        {
+            std::cerr << "CURL Error: " << curl_easy_strerror(res) << std::endl;
+            return false;
+        }
+        offset += sent;
+    }
+    return true;
+}
+
+/**
+ * @brief Sends one masked frame.
+ *
+ * @param opcode Frame opcode.
+ * @param payload Frame payload.
+ * @return bool False if the connection failed.
+ */
+bool StreamerClient::send_frame(WebSocketOpcode opcode, const std::string &payload)
+{
+    std::string frame;
+    encode_websocket_frame(opcode, payload, true, frame);
+    return send_all(frame);
+}
+
+/**
+ * @brief Appends whatever the socket has to the receive buffer, waiting briefly if it has nothing.
+ *
+ * @return bool False if the peer closed the connection or it failed.
+ */
+bool StreamerClient::receive_some()
+{
+    char chunk[16384];
+    std::size_t received = 0;
+    CURLcode res = curl_easy_recv(curl_, chunk, sizeof(chunk), &received);
+    if (res == CURLE_AGAIN)
+        return wait_socket(false, STREAM_POLL_INTERVAL_MS);
+    if (res != CURLE_OK || received == 0)
+        return false;
+
+    buffer_.append(chunk, received);
+    return true;
+}
+
+/**
+ * @brief Logs in, then dispatches frames until the connection drops or the client is stopped.
+ *
+ * @return bool False once the connection is no longer usable.
+ */
+bool StreamerClient::stream()
+{
+    nlohmann::json login = {
+        {"requests", nlohmann::json::array({{{"service", "ADMIN"},
+                                             {"command", "LOGIN"},
+                                             {"requestid", std::to_string(request_id_++)},
+                                             {"SchwabClientCustomerId", config_.customer_id},
+                                             {"SchwabClientCorrelId", config_.correl_id},
+                                             {"parameters", {{"Authorization", config_.access_token}, {"SchwabClientChannel", config_.channel}, {"SchwabClientFunctionId", config_.function_id}}}}})}};
+    if (!send_frame(WebSocketOpcode::Text, login.dump()))
+        return false;
+
+    while (!stopping_)
+    {
+        WebSocketFrame frame;
+        std::size_t consumed;
+        while ((consumed = decode_websocket_frame(buffer_.data(), buffer_.size(), frame)) > 0)
+        {
+            buffer_.erase(0, consumed);
+            switch (frame.opcode)
+            {
+            case WebSocketOpcode::Text:
+            case WebSocketOpcode::Binary:
+            case WebSocketOpcode::Continuation:
+                fragments_ += frame.payload;
+                if (frame.fin)
+                {
+                    handle_message(fragments_);
+                    fragments_.clear();
+                }
+                break;
+            case WebSocketOpcode::Ping:
+                if (!send_frame(WebSocketOpcode::Pong, frame.payload))
+                    return false;
+                break;
+            case WebSocketOpcode::Close:
+                send_frame(WebSocketOpcode::Close, frame.payload.substr(0, 2));
+                return false;
+            default:
+                break;
+            }
+        }
+
+        if (!receive_some())
+            return false;
+    }
+
+    send_frame(WebSocketOpcode::Close, std::string("\x03\xE8", 2));
+    return false;
+}
+
+/**
+ * @brief Applies one streamer message: data updates go to the quote book, responses are checked.
+ *
+ * A successful login response triggers the level-1 subscriptions. Heartbeat notifications are ignored.
+ *
+ * @param message JSON text of the message.
+ */
+void StreamerClient::handle_message(const std::string &message)
+{
+    nlohmann::json json_data;
+    try
+    {
+        json_data = nlohmann::json::parse(message);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
+        return;
+    }
+
+    if (json_data.contains("response"))
+    {
+        for (const auto &response : json_data["response"])
+        {
+            int code = response["content"].value("code", -1);
+            std::string command = response.value("command", "");
+            if (code != 0)
+            {
+                std::cerr << "Streamer " << response.value("service", "") << " " << command << " failed: "
+                          << response["content"].value("msg", "") << std::endl;
+                continue;
+            }
+
+            if (command != "LOGIN")
+                continue;
+
+            nlohmann::json requests = nlohmann::json::array();
+            auto subscribe = [&](const char *service, const std::vector<std::string> &symbols, const char *fields)
+            {
+                if (symbols.empty())
+                    return;
+
+                requests.push_back({{"service", service},
+                                    {"command", "SUBS"},
+                                    {"requestid", std::to_string(request_id_++)},
+                                    {"SchwabClientCustomerId", config_.customer_id},
+                                    {"SchwabClientCorrelId", config_.correl_id},
+                                    {"parameters", {{"keys", join_symbols(symbols)}, {"fields", fields}}}});
+            };
+            subscribe("LEVELONE_EQUITIES", config_.equity_symbols, EQUITY_FIELDS);
+            subscribe("LEVELONE_OPTIONS", config_.option_symbols, OPTION_FIELDS);
+
+            if (!requests.empty())
+                send_frame(WebSocketOpcode::Text, nlohmann::json{{"requests", requests}}.dump());
+        }
+    }
+
+    if (!json_data.contains("data"))
+        return;
+
+    if (record_.is_open())
+        record_ << json_data.dump() << '\n';
+
+    try
+    {
+        for (const auto &item : json_data["data"])
+        {
+            std::string service = item.value("service", "");
+            bool options = service == "LEVELONE_OPTIONS";
+            if (!options && service != "LEVELONE_EQUITIES")
+                continue;
+
+            if (item.contains("timestamp"))
+                quote_book.set_as_of(item["timestamp"].get<std::int64_t>());
+
+            for (const auto &content : item["content"])
+            {
+                std::string key = content.value("key", "");
+                QuoteUpdate update{0, 0.0, 0.0, 0.0, 0.0};
+
+                if (options)
+                {
+                    OptionSymbol symbol;
+                    if (!parse_option_symbol(key, symbol))
+                        continue;
+
+                    if (content.contains("2"))
+                    {
+                        update.fields |= QUOTE_BID;
+                        update.bid = content["2"].get<double>();
+                    }
+                    if (content.contains("3"))
+                    {
+                        update.fields |= QUOTE_ASK;
+                        update.ask = content["3"].get<double>();
+                    }
+                    if (content.contains("9"))
+                    {
+                        update.fields |= QUOTE_OPEN_INTEREST;
+                        update.open_interest = content["9"].get<double>();
+                    }
+                    quote_book.apply_option_update(symbol, update);
+                }
+                else
+                {
+                    if (content.contains("1"))
+                    {
+                        update.fields |= QUOTE_BID;
+                        update.bid = content["1"].get<double>();
+                    }
+                    if (content.contains("2"))
+                    {
+                        update.fields |= QUOTE_ASK;
+                        update.ask = content["2"].get<double>();
+                    }
+                    if (content.contains("3"))
+                    {
+                        update.fields |= QUOTE_LAST;
+                        update.last = content["3"].get<double>();
+                    }
+                    quote_book.apply_equity_update(key, update);
+                }
+            }
+        }
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "Streamer data error: " << e.what() << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(data_mutex_);
+    if (!has_data_)
+    {
+        has_data_ = true;
+        data_ready_.notify_all();
+    }
+}
@@ -0,0 +1,485 @@
+#include "surface_store.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include "mapped_file.h"
+#include "trace.h"
+
+static_assert(std::endian::native == std::endian::little, "The surface store is written in native byte order");
+
+/**
+ * @brief Magic bytes at the start of a partition's row file.
+ */
+static const char SURFACE_STORE_MAGIC[8] = {'O', 'K', 'B', 'S', 'U', 'R', 'F', '1'};
+
+/**
+ * @brief Format version of the row file.
+ */
+constexpr std::uint32_t SURFACE_STORE_VERSION = 1;
+
+/**
+ * @brief Header of a partition's row file, followed by the rows.
+ */
+struct SurfaceStoreHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t row_size;
+    std::uint64_t row_count;
+};
+
+static_assert(sizeof(SurfaceStoreHeader) == 24, "SurfaceStoreHeader is part of the on-disk format");
+
+/**
+ * @brief Initial size of a new row or column file; the mapping doubles whenever it fills up.
+ */
+constexpr std::size_t SURFACE_STORE_INITIAL_CAPACITY = 1 << 18;
+
+/**
+ * @brief Column files of a partition, in the order of the SmileRecord vectors.
+ */
+static const char *const SURFACE_STORE_COLUMNS[4] = {"strikes.f64", "strike_ivs.f64", "rbf_weights.f64", "grid_ivs.f64"};
+
+/**
+ * @brief Last millisecond of the year 9999, the latest time a partition name can hold.
+ */
+constexpr std::int64_t SURFACE_STORE_MAX_TIMESTAMP_MS = 253402300799999;
+
+/**
+ * @brief UTC calendar day of a timestamp.
+ *
+ * @param timestamp_ms Milliseconds since the epoch.
+ * @return int The day as YYYYMMDD.
+ */
+static int utc_day(std::int64_t timestamp_ms)
+{
+    std::chrono::sys_days days = std::chrono::floor<std::chrono::days>(std::chrono::sys_time<std::chrono::milliseconds>(std::chrono::milliseconds(timestamp_ms)));
+    std::chrono::year_month_day date(days);
+    return static_cast<int>(date.year()) * 10000 + static_cast<int>(static_cast<unsigned>(date.month())) * 100 + static_cast<int>(static_cast<unsigned>(date.day()));
+}
+
+/**
+ * @brief Grows a writable mapping so that it holds at least the given number of bytes.
+ *
+ * @param file Mapped file.
+ * @param needed Bytes needed.
+ * @return bool False if the file could not be grown.
+ */
+static bool reserve(MappedFile &file, std::size_t needed)
+{
+    if (needed <= file.size())
+        return true;
+    return file.resize(std::max({needed, 2 * file.size(), SURFACE_STORE_INITIAL_CAPACITY}));
+}
+
+/**
+ * @brief Open partition of one ticker and day, appended to by SurfaceStore.
+ */
+class SurfacePartition
+{
+public:
+    SurfacePartition();
+    ~SurfacePartition();
+
+    bool open(const std::filesystem::path &path, int day);
+    void close();
+    bool append(SmileRecord &record);
+    bool is_open() const { return rows_.is_open(); }
+    int day() const { return day_; }
+
+private:
+    bool append_column(std::size_t column, const Eigen::VectorXd &values);
+
+    int day_;
+    MappedFile rows_;
+    std::uint64_t row_count_;
+    MappedFile columns_[4];
+    std::uint64_t column_used_[4];
+};
+
+/**
+ * @brief Creates a closed partition.
+ */
+SurfacePartition::SurfacePartition()
+    : day_(0), row_count_(0), column_used_{0, 0, 0, 0}
+{
+}
+
+/**
+ * @brief Trims and closes the files.
+ */
+SurfacePartition::~SurfacePartition()
+{
+    close();
+}
+
+/**
+ * @brief Opens a partition for appending, creating it if needed; new smiles go after the committed ones.
+ *
+ * @param path Directory of the partition.
+ * @param day Day of the partition as YYYYMMDD.
+ * @return bool True on success.
+ */
+bool SurfacePartition::open(const std::filesystem::path &path, int day)
+{
+    day_ = day;
+    std::error_code error;
+    std::filesystem::create_directories(path, error);
+    if (error || !rows_.open((path / "rows.bin").string(), true))
+    {
+        std::cerr << "Could not open surface store partition " << path.string() << std::endl;
+        return false;
+    }
+
+    if (rows_.size() == 0)
+    {
+        if (!reserve(rows_, SURFACE_STORE_INITIAL_CAPACITY))
+        {
+            rows_.close();
+            return false;
+        }
+        SurfaceStoreHeader header{};
+        std::memcpy(header.magic, SURFACE_STORE_MAGIC, sizeof(SURFACE_STORE_MAGIC));
+        header.version = SURFACE_STORE_VERSION;
+        header.row_size = sizeof(SurfaceStoreRow);
+        header.row_count = 0;
+        std::memcpy(rows_.data(), &header, sizeof(header));
+        row_count_ = 0;
+    }
+    else
+    {
+        SurfaceStoreHeader header;
+        if (rows_.size() < sizeof(header))
+        {
+            std::cerr << "Not a surface store partition: " << path.string() << std::endl;
+            rows_.close();
+            return false;
+        }
+        std::memcpy(&header, rows_.data(), sizeof(header));
+        if (std::memcmp(header.magic, SURFACE_STORE_MAGIC, sizeof(SURFACE_STORE_MAGIC)) != 0 || header.version != SURFACE_STORE_VERSION || header.row_size != sizeof(SurfaceStoreRow))
+        {
+            std::cerr << "Not a surface store partition: " << path.string() << std::endl;
+            rows_.close();
+            return false;
+        }
+        row_count_ = std::min<std::uint64_t>(header.row_count, (rows_.size() - sizeof(header)) / sizeof(SurfaceStoreRow));
+        if (row_count_ > 0)
+        {
+            SurfaceStoreRow last;
+            std::memcpy(&last, rows_.data() + sizeof(header) + (row_count_ - 1) * sizeof(SurfaceStoreRow), sizeof(last));
+            column_used_[0] = column_used_[1] = column_used_[2] = last.strike_offset + last.strike_count;
+            column_used_[3] = last.grid_offset + last.grid_count;
+        }
+    }
+
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        if (!columns_[i].open((path / SURFACE_STORE_COLUMNS[i]).string(), true))
+        {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Trims every file to its committed contents and closes it.
+ */
+void SurfacePartition::close()
+{
+    if (rows_.is_open())
+    {
+        rows_.resize(sizeof(SurfaceStoreHeader) + row_count_ * sizeof(SurfaceStoreRow));
+        rows_.close();
+    }
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        if (columns_[i].is_open())
+        {
+            columns_[i].resize(column_used_[i] * sizeof(double));
+            columns_[i].close();
+        }
+    }
+}
+
+/**
+ * @brief Appends the values of one column.
+ *
+ * @param column Index of the column file.
+ * @param values Values to append.
+ * @return bool False if the file could not be grown.
+ */
+bool SurfacePartition::append_column(std::size_t column, const Eigen::VectorXd &values)
+{
+    std::size_t used = column_used_[column] * sizeof(double);
+    std::size_t bytes = static_cast<std::size_t>(values.size()) * sizeof(double);
+    if (!reserve(columns_[column], used + bytes))
+        return false;
+    if (bytes > 0)
+        std::memcpy(columns_[column].data() + used, values.data(), bytes);
+    column_used_[column] += static_cast<std::uint64_t>(values.size());
+    return true;
+}
+
+/**
+ * @brief Appends one smile: its columns, then its row, then the new row count.
+ *
+ * @param record Smile to append; receives the offsets of its columns.
+ * @return bool False if a file could not be grown.
+ */
+bool SurfacePartition::append(SmileRecord &record)
+{
+    if (!rows_.is_open())
+        return false;
+
+    std::uint64_t strike_offset = column_used_[0];
+    std::uint64_t grid_offset = column_used_[3];
+    if (!append_column(0, record.strikes) || !append_column(1, record.strike_ivs) || !append_column(2, record.rbf_weights) || !append_column(3, record.grid_ivs))
+        return false;
+
+    std::size_t row_end = sizeof(SurfaceStoreHeader) + (row_count_ + 1) * sizeof(SurfaceStoreRow);
+    if (!reserve(rows_, row_end))
+        return false;
+
+    record.row.strike_offset = strike_offset;
+    record.row.strike_count = static_cast<std::uint32_t>(record.strikes.size());
+    record.row.grid_offset = grid_offset;
+    record.row.grid_count = static_cast<std::uint32_t>(record.grid_ivs.size());
+    std::memcpy(rows_.data() + row_end - sizeof(SurfaceStoreRow), &record.row, sizeof(SurfaceStoreRow));
+
+    // Publish the row only once everything it points to is in place
+    std::atomic_thread_fence(std::memory_order_release);
+    ++row_count_;
+    std::memcpy(rows_.data() + offsetof(SurfaceStoreHeader, row_count), &row_count_, sizeof(row_count_));
+    return true;
+}
+
+/**
+ * @brief Grid strikes of a stored smile.
+ *
+ * @param record Stored smile.
+ * @return Eigen::VectorXd row.grid_count evenly spaced strikes over the fitted range.
+ */
+Eigen::VectorXd stored_grid_strikes(const SmileRecord &record)
+{
+    return Eigen::VectorXd::LinSpaced(record.row.grid_count, record.row.x_min, record.row.x_max);
+}
+
+/**
+ * @brief Creates a closed store.
+ */
+SurfaceStore::SurfaceStore() = default;
+
+/**
+ * @brief Trims and closes every open partition.
+ */
+SurfaceStore::~SurfaceStore()
+{
+    close();
+}
+
+/**
+ * @brief Opens a store, creating its directory if needed.
+ *
+ * @param directory Root directory of the store.
+ * @return bool True on success.
+ */
+bool SurfaceStore::open(const std::string &directory)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (error)
+    {
+        std::cerr << "Could not create surface store " << directory << ": " << error.message() << std::endl;
+        return false;
+    }
+    directory_ = directory;
+    return true;
+}
+
+/**
+ * @brief Trims and closes every open partition.
+ */
+void SurfaceStore::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    partitions_.clear();
+    directory_.clear();
+}
+
+/**
+ * @brief Appends a smile to the partition of its ticker and day. Safe to call from several threads.
+ *
+ * A ticker's previous partition is closed when its first smile of a new day arrives.
+ *
+ * @param record Smile to append; receives the offsets of its columns.
+ */
+void SurfaceStore::append(SmileRecord &record)
+{
+    TRACE_SCOPE("surface_store_append");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (directory_.empty())
+        return;
+
+    int day = utc_day(record.row.timestamp_ms);
+    std::unique_ptr<SurfacePartition> &partition = partitions_[record.ticker];
+    if (!partition || partition->day() != day)
+    {
+        partition = std::make_unique<SurfacePartition>();
+        partition->open(std::filesystem::path(directory_) / record.ticker / std::to_string(day), day);
+    }
+
+    if (partition->is_open() && !partition->append(record))
+    {
+        std::cerr << "Could not grow surface store partition of " << record.ticker << "; its smiles are dropped for the day." << std::endl;
+        partition->close();
+    }
+}
+
+/**
+ * @brief Reads the committed smiles of one partition that fall in a time range.
+ *
+ * @param path Directory of the partition.
+ * @param ticker Ticker of the partition.
+ * @param from_ms Start of the range, inclusive.
+ * @param to_ms End of the range, inclusive.
+ * @param records Receives the smiles, in append order.
+ */
+static void read_partition(
+    const std::filesystem::path &path,
+    const std::string &ticker,
+    std::int64_t from_ms,
+    std::int64_t to_ms,
+    std::vector<SmileRecord> &records)
+{
+    MappedFile rows;
+    if (!rows.open((path / "rows.bin").string(), false))
+        return;
+
+    SurfaceStoreHeader header;
+    if (rows.size() < sizeof(header))
+        return;
+    std::memcpy(&header, rows.data(), sizeof(header));
+    if (std::memcmp(header.magic, SURFACE_STORE_MAGIC, sizeof(SURFACE_STORE_MAGIC)) != 0 || header.version != SURFACE_STORE_VERSION || header.row_size != sizeof(SurfaceStoreRow))
+    {
+        std::cerr << "Not a surface store partition: " << path.string() << std::endl;
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    std::uint64_t row_count = std::min<std::uint64_t>(header.row_count, (rows.size() - sizeof(header)) / sizeof(SurfaceStoreRow));
+
+    // Mapped after the row count was read, so they hold at least what the committed rows point to
+    MappedFile columns[4];
+    for (std::size_t i = 0; i < 4; ++i)
+    {
+        if (!columns[i].open((path / SURFACE_STORE_COLUMNS[i]).string(), false))
+            return;
+    }
+
+    auto column_slice = [&](std::size_t column, std::uint64_t offset, std::uint32_t count, Eigen::VectorXd &out) -> bool
+    {
+        if ((offset + count) * sizeof(double) > columns[column].size())
+            return false;
+        out.resize(count);
+        if (count > 0)
+            std::memcpy(out.data(), columns[column].data() + offset * sizeof(double), count * sizeof(double));
+        return true;
+    };
+
+    for (std::uint64_t i = 0; i < row_count; ++i)
+    {
+        SurfaceStoreRow row;
+        std::memcpy(&row, rows.data() + sizeof(header) + i * sizeof(SurfaceStoreRow), sizeof(row));
+        if (row.timestamp_ms < from_ms || row.timestamp_ms > to_ms)
+            continue;
+
+        SmileRecord record;
+        record.ticker = ticker;
+        record.row = row;
+        if (!column_slice(0, row.strike_offset, row.strike_count, record.strikes) ||
+            !column_slice(1, row.strike_offset, row.strike_count, record.strike_ivs) ||
+            !column_slice(2, row.strike_offset, row.strike_count, record.rbf_weights) ||
+            !column_slice(3, row.grid_offset, row.grid_count, record.grid_ivs))
+        {
+            std::cerr << "Malformed surface store row " << i << " in " << path.string() << std::endl;
+            return;
+        }
+        records.push_back(std::move(record));
+    }
+}
+
+/**
+ * @brief Creates a reader of a store.
+ *
+ * @param directory Root directory of the store.
+ */
+SurfaceStoreReader::SurfaceStoreReader(const std::string &directory)
+    : directory_(directory)
+{
+}
+
+/**
+ * @brief Tickers that have at least one partition.
+ *
+ * @return std::vector<std::string> The tickers, sorted.
+ */
+std::vector<std::string> SurfaceStoreReader::tickers() const
+{
+    std::vector<std::string> result;
+    std::error_code error;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(directory_, error))
+    {
+        if (entry.is_directory())
+            result.push_back(entry.path().filename().string());
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+/**
+ * @brief Reads the smiles of a ticker within a time range.
+ *
+ * @param ticker Ticker, as in the watch list.
+ * @param from_ms Start of the range in milliseconds since the epoch, inclusive.
+ * @param to_ms End of the range in milliseconds since the epoch, inclusive.
+ * @param records Receives the smiles, ordered by day and then in append order.
+ * @return std::size_t Number of smiles added to records.
+ */
+std::size_t SurfaceStoreReader::query(
+    const std::string &ticker,
+    std::int64_t from_ms,
+    std::int64_t to_ms,
+    std::vector<SmileRecord> &records) const
+{
+    TRACE_SCOPE("surface_store_query");
+    int from_day = utc_day(std::clamp(from_ms, std::int64_t(0), SURFACE_STORE_MAX_TIMESTAMP_MS));
+    int to_day = utc_day(std::clamp(to_ms, std::int64_t(0), SURFACE_STORE_MAX_TIMESTAMP_MS));
+
+    std::vector<int> days;
+    std::error_code error;
+    for (const std::filesystem::directory_entry &entry : std::filesystem::directory_iterator(std::filesystem::path(directory_) / ticker, error))
+    {
+        const std::string name = entry.path().filename().string();
+        if (!entry.is_directory() || name.size() != 8 || !std::all_of(name.begin(), name.end(), [](char c)
+                                                                        { return c >= '0' && c <= '9'; }))
+            continue;
+        int day = std::stoi(name);
+        if (day >= from_day && day <= to_day)
+            days.push_back(day);
+    }
+    std::sort(days.begin(), days.end());
+
+    std::size_t before = records.size();
+    for (int day : days)
+    {
+        read_partition(std::filesystem::path(directory_) / ticker / std::to_string(day), ticker, from_ms, to_ms, records);
+    }
+    return records.size() - before;
+}
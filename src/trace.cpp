@@ -0,0 +1,198 @@
+#include "trace.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Events kept per thread; older events are overwritten once a buffer is full.
+ */
+constexpr std::size_t TRACE_BUFFER_EVENTS = std::size_t{1} << 16;
+
+/**
+ * @brief Global flag that turns TRACE_SCOPE recording on.
+ */
+std::atomic<bool> trace_enabled(false);
+
+/**
+ * @brief One completed scope.
+ */
+struct TraceEvent
+{
+    const char *name;
+    std::int64_t begin_ns;
+    std::int64_t end_ns;
+};
+
+/**
+ * @brief Ring buffer slot, atomic so write_chrome_trace can copy it while its thread writes.
+ */
+struct TraceSlot
+{
+    std::atomic<const char *> name{nullptr};
+    std::atomic<std::int64_t> begin_ns{0};
+    std::atomic<std::int64_t> end_ns{0};
+};
+
+/**
+ * @brief Ring buffer of the events of one thread, written only by that thread.
+ *
+ * started counts the events whose slot the thread has begun to write and written those it has
+ * finished, so a reader can tell which slots it copied may have been overwritten meanwhile.
+ */
+struct ThreadTraceBuffer
+{
+    std::unique_ptr<TraceSlot[]> events{new TraceSlot[TRACE_BUFFER_EVENTS]};
+    std::atomic<std::uint64_t> started{0};
+    std::atomic<std::uint64_t> written{0};
+    unsigned int tid = 0;
+    std::string thread_name;
+};
+
+/**
+ * @brief Buffers of every thread that recorded an event, kept after the thread exits.
+ */
+static std::vector<std::shared_ptr<ThreadTraceBuffer>> trace_buffers;
+static std::mutex trace_buffers_mutex;
+
+/**
+ * @brief Buffer of the calling thread, created on its first event.
+ */
+static thread_local ThreadTraceBuffer *thread_trace_buffer = nullptr;
+
+/**
+ * @brief Name of the calling thread, applied to its buffer when that is created.
+ */
+static thread_local std::string thread_trace_name;
+
+/**
+ * @brief Names the calling thread in the trace.
+ *
+ * Cheap to call with tracing off: the buffer is only allocated once the thread records an event.
+ *
+ * @param name Thread name shown by the trace viewer.
+ */
+void set_trace_thread_name(const std::string &name)
+{
+    thread_trace_name = name;
+    if (thread_trace_buffer)
+    {
+        std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+        thread_trace_buffer->thread_name = name;
+    }
+}
+
+/**
+ * @brief Appends an event to the calling thread's ring buffer.
+ *
+ * @param name Event name.
+ * @param begin_ns Start on the trace clock.
+ * @param end_ns End on the trace clock.
+ */
+void record_trace_event(const char *name, std::int64_t begin_ns, std::int64_t end_ns)
+{
+    if (!thread_trace_buffer)
+    {
+        auto buffer = std::make_shared<ThreadTraceBuffer>();
+        buffer->thread_name = thread_trace_name;
+
+        std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+        buffer->tid = static_cast<unsigned int>(trace_buffers.size()) + 1;
+        trace_buffers.push_back(buffer);
+        thread_trace_buffer = buffer.get();
+    }
+
+    ThreadTraceBuffer &buffer = *thread_trace_buffer;
+    std::uint64_t index = buffer.written.load(std::memory_order_relaxed);
+    buffer.started.store(index + 1, std::memory_order_relaxed);
+
+    // Release stores: a reader that sees any of them also sees the started count above
+    TraceSlot &slot = buffer.events[index % TRACE_BUFFER_EVENTS];
+    slot.name.store(name, std::memory_order_release);
+    slot.begin_ns.store(begin_ns, std::memory_order_release);
+    slot.end_ns.store(end_ns, std::memory_order_release);
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Writes the buffered events of every thread as Chrome trace-event JSON.
+ *
+ * The file opens in Perfetto or chrome://tracing. Each scope is a complete ("X") event with
+ * microsecond timestamps relative to the earliest buffered event. Threads may keep recording
+ * while this runs: the slots are copied like a seqlock, and any slot its thread started to
+ * overwrite during the copy is dropped.
+ *
+ * @param file_path Path of the JSON file.
+ * @return bool False if the file cannot be written.
+ */
+bool write_chrome_trace(const std::string &file_path)
+{
+    std::vector<std::pair<std::shared_ptr<ThreadTraceBuffer>, std::string>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(trace_buffers_mutex);
+        for (const std::shared_ptr<ThreadTraceBuffer> &buffer : trace_buffers)
+        {
+            buffers.emplace_back(buffer, buffer->thread_name);
+        }
+    }
+
+    std::vector<std::vector<TraceEvent>> events(buffers.size());
+    std::int64_t origin_ns = std::numeric_limits<std::int64_t>::max();
+    for (std::size_t i = 0; i < buffers.size(); ++i)
+    {
+        const ThreadTraceBuffer &buffer = *buffers[i].first;
+        std::uint64_t end = buffer.written.load(std::memory_order_acquire);
+        std::uint64_t begin = end > TRACE_BUFFER_EVENTS ? end - TRACE_BUFFER_EVENTS : 0;
+        for (std::uint64_t j = begin; j < end; ++j)
+        {
+            const TraceSlot &slot = buffer.events[j % TRACE_BUFFER_EVENTS];
+            events[i].push_back(TraceEvent{slot.name.load(std::memory_order_acquire), slot.begin_ns.load(std::memory_order_acquire),
+                                           slot.end_ns.load(std::memory_order_acquire)});
+        }
+
+        // Any slot read above that was being rewritten is now counted in started
+        std::uint64_t overwritten = buffer.started.load(std::memory_order_relaxed);
+        if (overwritten > TRACE_BUFFER_EVENTS && overwritten - TRACE_BUFFER_EVENTS > begin)
+        {
+            std::size_t stale = static_cast<std::size_t>(std::min(overwritten - TRACE_BUFFER_EVENTS - begin, end - begin));
+            events[i].erase(events[i].begin(), events[i].begin() + static_cast<std::ptrdiff_t>(stale));
+        }
+
+        for (const TraceEvent &event : events[i])
+        {
+            origin_ns = std::min(origin_ns, event.begin_ns);
+        }
+    }
+
+    std::ofstream file(file_path, std::ios::trunc);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not write trace file: " << file_path << std::endl;
+        return false;
+    }
+
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    file << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"OptionsKillerBotCPP\"}}";
+    file.precision(3);
+    file << std::fixed;
+    for (std::size_t i = 0; i < buffers.size(); ++i)
+    {
+        unsigned int tid = buffers[i].first->tid;
+        if (!buffers[i].second.empty())
+        {
+            file << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                 << ",\"args\":{\"name\":\"" << buffers[i].second << "\"}}";
+        }
+        for (const TraceEvent &event : events[i])
+        {
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                 << ",\"ts\":" << (event.begin_ns - origin_ns) / 1000.0
+                 << ",\"dur\":" << (event.end_ns - event.begin_ns) / 1000.0 << "}";
+        }
+    }
+    file << "]}\n";
+    return true;
+}
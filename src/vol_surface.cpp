@@ -0,0 +1,157 @@
+#include "vol_surface.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <mutex>
+#include <utility>
+
+/**
+ * @brief Latest surface of every (underlying, option type), replaced as a whole on each refit.
+ */
+static std::map<std::pair<std::string, OptionKind>, std::shared_ptr<const VolSurface>> vol_surfaces;
+
+/**
+ * @brief Guards swaps and reads of vol_surfaces.
+ */
+static std::mutex vol_surfaces_mutex;
+
+/**
+ * @brief Creates an empty surface.
+ *
+ * @param underlying Underlying symbol.
+ * @param kind Option type of the fitted chains.
+ * @param S Underlying price every slice was fitted against.
+ */
+VolSurface::VolSurface(const std::string &underlying, OptionKind kind, double S)
+    : underlying_(underlying), kind_(kind), S_(S)
+{
+}
+
+/**
+ * @brief Adds the fitted smile of one expiry, keeping the slices ordered by time to expiry.
+ *
+ * @param expiry Expiry as YYYYMMDD.
+ * @param T Time to expiry in years.
+ * @param smile Fitted smile of the expiry.
+ */
+void VolSurface::add_slice(int expiry, double T, std::shared_ptr<const SmileSurface> smile)
+{
+    auto position = std::upper_bound(slices_.begin(), slices_.end(), T, [](double value, const VolSurfaceSlice &slice)
+                                     { return value < slice.T; });
+    slices_.insert(position, VolSurfaceSlice{expiry, T, std::move(smile)});
+}
+
+/**
+ * @brief Evaluates the surface at any strike and time to expiry.
+ *
+ * @param strike Strike price; each smile clamps it to its own fitted range.
+ * @param T Time to expiry in years.
+ * @return double The implied volatility, or 0 if the surface has no slices.
+ */
+double VolSurface::implied_volatility(double strike, double T) const
+{
+    if (slices_.empty())
+        return 0.0;
+    if (T <= slices_.front().T)
+        return slices_.front().smile->evaluate(strike);
+    if (T >= slices_.back().T)
+        return slices_.back().smile->evaluate(strike);
+
+    auto upper = std::upper_bound(slices_.begin(), slices_.end(), T, [](double value, const VolSurfaceSlice &slice)
+                                  { return value < slice.T; });
+    const VolSurfaceSlice &after = *upper;
+    const VolSurfaceSlice &before = *(upper - 1);
+
+    double sigma_before = before.smile->evaluate(strike);
+    double sigma_after = after.smile->evaluate(strike);
+    double w_before = sigma_before * sigma_before * before.T;
+    double w_after = sigma_after * sigma_after * after.T;
+
+    double weight = (T - before.T) / (after.T - before.T);
+    double w = std::max(0.0, w_before + weight * (w_after - w_before));
+    return std::sqrt(w / T);
+}
+
+/**
+ * @brief Looks up the slice of an expiry.
+ *
+ * @param expiry Expiry as YYYYMMDD.
+ * @return const VolSurfaceSlice* The slice, or nullptr if the expiry was not fitted.
+ */
+const VolSurfaceSlice *VolSurface::find_slice(int expiry) const
+{
+    for (const VolSurfaceSlice &slice : slices_)
+    {
+        if (slice.expiry == expiry)
+            return &slice;
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Fitted slices, nearest expiry first.
+ *
+ * @return const std::vector<VolSurfaceSlice>& The slices.
+ */
+const std::vector<VolSurfaceSlice> &VolSurface::slices() const
+{
+    return slices_;
+}
+
+/**
+ * @brief Underlying symbol of the surface.
+ *
+ * @return const std::string& The symbol.
+ */
+const std::string &VolSurface::underlying() const
+{
+    return underlying_;
+}
+
+/**
+ * @brief Option type of the fitted chains.
+ *
+ * @return OptionKind The option type.
+ */
+OptionKind VolSurface::kind() const
+{
+    return kind_;
+}
+
+/**
+ * @brief Underlying price the slices were fitted against.
+ *
+ * @return double The price.
+ */
+double VolSurface::spot() const
+{
+    return S_;
+}
+
+/**
+ * @brief Makes a freshly fitted surface the current one for its underlying and option type.
+ *
+ * Readers holding the previous surface keep using it until they release it.
+ *
+ * @param surface The fitted surface.
+ */
+void publish_vol_surface(std::shared_ptr<const VolSurface> surface)
+{
+    std::pair<std::string, OptionKind> key(surface->underlying(), surface->kind());
+    std::lock_guard<std::mutex> lock(vol_surfaces_mutex);
+    vol_surfaces[key] = std::move(surface);
+}
+
+/**
+ * @brief Latest surface of an underlying and option type.
+ *
+ * @param underlying Underlying symbol, as in the watch list.
+ * @param kind Option type.
+ * @return std::shared_ptr<const VolSurface> The surface, or nullptr if none has been fitted yet.
+ */
+std::shared_ptr<const VolSurface> current_vol_surface(const std::string &underlying, OptionKind kind)
+{
+    std::lock_guard<std::mutex> lock(vol_surfaces_mutex);
+    auto it = vol_surfaces.find(std::make_pair(underlying, kind));
+    return it != vol_surfaces.end() ? it->second : nullptr;
+}
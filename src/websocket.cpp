@@ -0,0 +1,273 @@
+#include "websocket.h"
+#include <random>
+
+/**
+ * @brief GUID appended to the client key to form the handshake accept key (RFC 6455, section 1.3).
+ */
+static const char *WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+/**
+ * @brief Encode binary data as standard base64 with padding.
+ *
+ * @param data Bytes to encode.
+ * @param length Number of bytes.
+ * @return std::string The base64 text.
+ */
+std::string base64_encode(const unsigned char *data, std::size_t length)
+{
+    static const char *alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    std::string encoded;
+    encoded.reserve((length + 2) / 3 * 4);
+    for (std::size_t i = 0; i < length; i += 3)
+    {
+        std::uint32_t chunk = static_cast<std::uint32_t>(data[i]) << 16;
+        if (i + 1 < length)
+            chunk |= static_cast<std::uint32_t>(data[i + 1]) << 8;
+        if (i + 2 < length)
+            chunk |= static_cast<std::uint32_t>(data[i + 2]);
+
+        encoded.push_back(alphabet[(chunk >> 18) & 0x3F]);
+        encoded.push_back(alphabet[(chunk >> 12) & 0x3F]);
+        encoded.push_back(i + 1 < length ? alphabet[(chunk >> 6) & 0x3F] : '=');
+        encoded.push_back(i + 2 < length ? alphabet[chunk & 0x3F] : '=');
+    }
+    return encoded;
+}
+
+/**
+ * @brief Rotate a 32-bit word left.
+ *
+ * @param value Word to rotate.
+ * @param bits Number of bits.
+ * @return std::uint32_t The rotated word.
+ */
+static inline std::uint32_t rotate_left(std::uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+/**
+ * @brief Compute the SHA-1 digest of a message.
+ *
+ * Only used for the WebSocket handshake, which mandates SHA-1.
+ *
+ * @param message Message to hash.
+ * @return std::string The 20-byte binary digest.
+ */
+std::string sha1_digest(const std::string &message)
+{
+    std::uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    std::string padded = message;
+    std::uint64_t bit_length = static_cast<std::uint64_t>(message.size()) * 8;
+    padded.push_back(static_cast<char>(0x80));
+    while (padded.size() % 64 != 56)
+    {
+        padded.push_back('\0');
+    }
+    for (int i = 7; i >= 0; --i)
+    {
+        padded.push_back(static_cast<char>((bit_length >> (8 * i)) & 0xFF));
+    }
+
+    for (std::size_t block = 0; block < padded.size(); block += 64)
+    {
+        std::uint32_t w[80];
+        for (int i = 0; i < 16; ++i)
+        {
+            const unsigned char *p = reinterpret_cast<const unsigned char *>(padded.data() + block + 4 * i);
+            w[i] = (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+                   (static_cast<std::uint32_t>(p[2]) << 8) | static_cast<std::uint32_t>(p[3]);
+        }
+        for (int i = 16; i < 80; ++i)
+        {
+            w[i] = rotate_left(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; ++i)
+        {
+            std::uint32_t f, k;
+            if (i < 20)
+            {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            }
+            else if (i < 40)
+            {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            }
+            else if (i < 60)
+            {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            }
+            else
+            {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+
+            std::uint32_t temp = rotate_left(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotate_left(b, 30);
+            b = a;
+            a = temp;
+        }
+
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    std::string digest(20, '\0');
+    for (int i = 0; i < 5; ++i)
+    {
+        digest[4 * i] = static_cast<char>((h[i] >> 24) & 0xFF);
+        digest[4 * i + 1] = static_cast<char>((h[i] >> 16) & 0xFF);
+        digest[4 * i + 2] = static_cast<char>((h[i] >> 8) & 0xFF);
+        digest[4 * i + 3] = static_cast<char>(h[i] & 0xFF);
+    }
+    return digest;
+}
+
+/**
+ * @brief Compute the Sec-WebSocket-Accept value for a Sec-WebSocket-Key.
+ *
+ * @param client_key The key sent by the client.
+ * @return std::string The accept key the server must answer with.
+ */
+std::string websocket_accept_key(const std::string &client_key)
+{
+    std::string digest = sha1_digest(client_key + WEBSOCKET_GUID);
+    return base64_encode(reinterpret_cast<const unsigned char *>(digest.data()), digest.size());
+}
+
+/**
+ * @brief Append one complete (FIN) frame to an output buffer.
+ *
+ * @param opcode Frame opcode.
+ * @param payload Frame payload.
+ * @param masked Whether to mask the payload; frames sent by a client must be masked.
+ * @param out Buffer the encoded frame is appended to.
+ */
+void encode_websocket_frame(WebSocketOpcode opcode, const std::string &payload, bool masked, std::string &out)
+{
+    std::size_t length = payload.size();
+    out.push_back(static_cast<char>(0x80 | static_cast<std::uint8_t>(opcode)));
+
+    std::uint8_t mask_bit = masked ? 0x80 : 0x00;
+    if (length < 126)
+    {
+        out.push_back(static_cast<char>(mask_bit | length));
+    }
+    else if (length <= 0xFFFF)
+    {
+        out.push_back(static_cast<char>(mask_bit | 126));
+        out.push_back(static_cast<char>((length >> 8) & 0xFF));
+        out.push_back(static_cast<char>(length & 0xFF));
+    }
+    else
+    {
+        out.push_back(static_cast<char>(mask_bit | 127));
+        for (int i = 7; i >= 0; --i)
+        {
+            out.push_back(static_cast<char>((static_cast<std::uint64_t>(length) >> (8 * i)) & 0xFF));
+        }
+    }
+
+    if (!masked)
+    {
+        out += payload;
+        return;
+    }
+
+    static thread_local std::mt19937 generator(std::random_device{}());
+    std::uint32_t mask_word = generator();
+    char mask[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        mask[i] = static_cast<char>((mask_word >> (8 * i)) & 0xFF);
+        out.push_back(mask[i]);
+    }
+
+    std::size_t start = out.size();
+    out += payload;
+    for (std::size_t i = 0; i < length; ++i)
+    {
+        out[start + i] = static_cast<char>(out[start + i] ^ mask[i % 4]);
+    }
+}
+
+/**
+ * @brief Decode one frame from the front of a buffer.
+ *
+ * Masked payloads are unmasked.
+ *
+ * @param data Received bytes.
+ * @param length Number of received bytes.
+ * @param frame Receives the decoded frame.
+ * @return std::size_t Number of bytes the frame occupied, or 0 if the buffer does not hold a complete frame yet.
+ */
+std::size_t decode_websocket_frame(const char *data, std::size_t length, WebSocketFrame &frame)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    if (length < 2)
+        return 0;
+
+    bool masked = (bytes[1] & 0x80) != 0;
+    std::uint64_t payload_length = bytes[1] & 0x7F;
+    std::size_t offset = 2;
+
+    if (payload_length == 126)
+    {
+        if (length < offset + 2)
+            return 0;
+        payload_length = (static_cast<std::uint64_t>(bytes[2]) << 8) | bytes[3];
+        offset += 2;
+    }
+    else if (payload_length == 127)
+    {
+        if (length < offset + 8)
+            return 0;
+        payload_length = 0;
+        for (int i = 0; i < 8; ++i)
+        {
+            payload_length = (payload_length << 8) | bytes[2 + i];
+        }
+        offset += 8;
+    }
+
+    unsigned char mask[4] = {0, 0, 0, 0};
+    if (masked)
+    {
+        if (length < offset + 4)
+            return 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            mask[i] = bytes[offset + i];
+        }
+        offset += 4;
+    }
+
+    if (length - offset < payload_length)
+        return 0;
+
+    frame.fin = (bytes[0] & 0x80) != 0;
+    frame.opcode = static_cast<WebSocketOpcode>(bytes[0] & 0x0F);
+    frame.payload.assign(data + offset, static_cast<std::size_t>(payload_length));
+    if (masked)
+    {
+        for (std::size_t i = 0; i < frame.payload.size(); ++i)
+        {
+            frame.payload[i] = static_cast<char>(frame.payload[i] ^ mask[i % 4]);
+        }
+    }
+
+    return offset + static_cast<std::size_t>(payload_length);
+}
@@ -0,0 +1,70 @@
+import os
+from datetime import datetime, timezone
+
+import numpy as np
+import pandas as pd
+
+# Layout of the surface store written by the bot (see include/surface_store.h):
+# <store>/<ticker>/<YYYYMMDD>/rows.bin holds a 24-byte header (magic, version, row size, row count)
+# followed by fixed-width rows; the float64 columns of every row are in the other files.
+MAGIC = b'OKBSURF1'
+HEADER_DTYPE = np.dtype([('magic', 'S8'), ('version', '<u4'), ('row_size', '<u4'), ('row_count', '<u8')])
+ROW_DTYPE = np.dtype([
+    ('timestamp_ms', '<i8'), ('expiry', '<i4'), ('option_kind', '<i4'),
+    ('S', '<f8'), ('T', '<f8'), ('r', '<f8'), ('q', '<f8'), ('rmse', '<f8'),
+    ('x_min', '<f8'), ('x_max', '<f8'),
+    ('rfv_a', '<f8'), ('rfv_b', '<f8'), ('rfv_c', '<f8'), ('rfv_d', '<f8'), ('rfv_e', '<f8'),
+    ('rbf_epsilon', '<f8'),
+    ('strike_offset', '<u8'), ('strike_count', '<u4'), ('grid_count', '<u4'), ('grid_offset', '<u8'),
+])
+COLUMNS = ('strikes', 'strike_ivs', 'rbf_weights', 'grid_ivs')
+
+
+def _map(path, dtype, offset=0):
+    # Files being appended to are larger than their contents, and not always by whole items
+    count = (os.path.getsize(path) - offset) // np.dtype(dtype).itemsize
+    if count <= 0:
+        return np.empty(0, dtype)
+    return np.memmap(path, dtype, 'r', offset, (count,))
+
+
+def _day(timestamp_ms):
+    return datetime.fromtimestamp(min(max(timestamp_ms, 0), 253402300799999) / 1000, timezone.utc).strftime('%Y%m%d')
+
+
+def read_partition(path):
+    """Maps one partition: returns its committed rows as a DataFrame and its columns as float64 arrays."""
+    header = np.fromfile(os.path.join(path, 'rows.bin'), HEADER_DTYPE, 1)[0]
+    if header['magic'] != MAGIC or header['version'] != 1 or header['row_size'] != ROW_DTYPE.itemsize:
+        raise ValueError(path + ' is not a surface store partition')
+    rows = _map(os.path.join(path, 'rows.bin'), ROW_DTYPE, HEADER_DTYPE.itemsize)[:int(header['row_count'])]
+    columns = {name: _map(os.path.join(path, name + '.f64'), '<f8') for name in COLUMNS}
+    return pd.DataFrame(rows), columns
+
+
+def query(store, ticker, start_ms, end_ms):
+    """Smiles of a ticker with start_ms <= timestamp_ms <= end_ms, one per row.
+
+    The row fields are columns; strikes, strike_ivs, rbf_weights, grid_strikes and grid_ivs
+    hold one array per smile.
+    """
+    start_day = _day(start_ms)
+    end_day = _day(end_ms)
+    ticker_dir = os.path.join(store, ticker)
+    days = sorted(day for day in (os.listdir(ticker_dir) if os.path.isdir(ticker_dir) else []) if len(day) == 8 and day.isdigit() and start_day <= day <= end_day)
+
+    frames = []
+    for day in days:
+        rows, columns = read_partition(os.path.join(ticker_dir, day))
+        rows = rows[(rows['timestamp_ms'] >= start_ms) & (rows['timestamp_ms'] <= end_ms)].reset_index(drop=True)
+        strike_slices = [slice(int(o), int(o) + int(n)) for o, n in zip(rows['strike_offset'], rows['strike_count'])]
+        grid_slices = [slice(int(o), int(o) + int(n)) for o, n in zip(rows['grid_offset'], rows['grid_count'])]
+        for name in ('strikes', 'strike_ivs', 'rbf_weights'):
+            rows[name] = [np.array(columns[name][s]) for s in strike_slices]
+        rows['grid_ivs'] = [np.array(columns['grid_ivs'][s]) for s in grid_slices]
+        rows['grid_strikes'] = [np.linspace(lo, hi, int(n)) for lo, hi, n in zip(rows['x_min'], rows['x_max'], rows['grid_count'])]
+        frames.append(rows)
+
+    if not frames:
+        return pd.DataFrame(columns=list(ROW_DTYPE.names) + ['strikes', 'grid_strikes'] + list(COLUMNS))
+    return pd.concat(frames, ignore_index=True)
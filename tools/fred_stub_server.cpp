@@ -0,0 +1,148 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+/**
+ * @brief Sends a buffer completely on a blocking socket.
+ *
+ * @param fd Connected socket.
+ * @param data Bytes to send.
+ * @return bool False if the peer is gone.
+ */
+static bool send_all(int fd, const std::string &data)
+{
+    std::size_t offset = 0;
+    while (offset < data.size())
+    {
+        ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent <= 0)
+            return false;
+        offset += static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * @brief Reads an HTTP request up to the end of its headers.
+ *
+ * @param fd Connected socket.
+ * @param request Receives the request line and headers.
+ * @return bool False if the peer closed the connection first.
+ */
+static bool read_request(int fd, std::string &request)
+{
+    char chunk[4096];
+    while (request.find("\r\n\r\n") == std::string::npos)
+    {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return false;
+        request.append(chunk, static_cast<std::size_t>(received));
+    }
+    return true;
+}
+
+/**
+ * @brief Builds a FRED observations response, newest first, the way FRED answers sort_order=desc.
+ *
+ * The newest observation has no value ("."), as on a day without a fixing.
+ *
+ * @param rate SOFR in percent reported for the latest fixing.
+ * @return std::string The JSON body.
+ */
+static std::string observations_body(double rate)
+{
+    std::ostringstream body;
+    body << "{\"realtime_start\":\"2024-08-12\",\"realtime_end\":\"2024-08-12\",\"sort_order\":\"desc\",\"count\":3,\"observations\":["
+         << "{\"date\":\"2024-08-12\",\"value\":\".\"},"
+         << "{\"date\":\"2024-08-09\",\"value\":\"" << rate << "\"},"
+         << "{\"date\":\"2024-08-08\",\"value\":\"" << rate + 0.01 << "\"}]}";
+    return body.str();
+}
+
+/**
+ * @brief Local stand-in for the FRED observations API, for testing the risk-free rate service.
+ *
+ * Usage: fred_stub_server [port] [--rate R] [--step S] [--delay-ms N] [--fail]
+ *
+ * Answers every request with SOFR observations whose latest fixing is R percent (5.31 by
+ * default), adding S to R after each request. --delay-ms holds each response back to emulate a
+ * slow network, and --fail answers with HTTP 500 instead. Request lines are logged.
+ *
+ * @return int Exit status code.
+ */
+int main(int argc, char *argv[])
+{
+    int port = 8798;
+    double rate = 5.31;
+    double step = 0.0;
+    int delay_ms = 0;
+    bool fail = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--rate" && i + 1 < argc)
+            rate = std::stod(argv[++i]);
+        else if (arg == "--step" && i + 1 < argc)
+            step = std::stod(argv[++i]);
+        else if (arg == "--delay-ms" && i + 1 < argc)
+            delay_ms = std::stoi(argv[++i]);
+        else if (arg == "--fail")
+            fail = true;
+        else if (!arg.empty() && arg[0] != '-')
+            port = std::stoi(arg);
+        else
+        {
+            std::cerr << "Usage: " << argv[0] << " [port] [--rate R] [--step S] [--delay-ms N] [--fail]" << std::endl;
+            return 1;
+        }
+    }
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 4) < 0)
+    {
+        std::cerr << "Could not listen on port " << port << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::cout << "Listening on http://127.0.0.1:" << port << " with SOFR " << rate << "%." << std::endl;
+    while (true)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        std::string request;
+        if (read_request(client, request))
+        {
+            std::cout << request.substr(0, request.find("\r\n")) << std::endl;
+            if (delay_ms > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms));
+
+            std::string body = fail ? "{\"error_code\":500,\"error_message\":\"Internal Server Error\"}" : observations_body(rate);
+            send_all(client, std::string(fail ? "HTTP/1.1 500 Internal Server Error" : "HTTP/1.1 200 OK") +
+                                 "\r\nContent-Type: application/json\r\nContent-Length: " + std::to_string(body.size()) +
+                                 "\r\nConnection: close\r\n\r\n" + body);
+            rate += step;
+        }
+        close(client);
+    }
+}
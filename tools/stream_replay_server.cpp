@@ -0,0 +1,334 @@
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "nlohmann/json.hpp"
+#include "websocket.h"
+
+/**
+ * @brief One recorded data message and its feed timestamp.
+ */
+struct RecordedMessage
+{
+    std::int64_t timestamp;
+    std::string text;
+};
+
+/**
+ * @brief Loads a recording written through STREAM_RECORD_FILE (one JSON data message per line).
+ *
+ * @param file_path Path of the recording.
+ * @param messages Receives the messages in file order.
+ * @return bool False if the file cannot be read.
+ */
+static bool load_recording(const std::string &file_path, std::vector<RecordedMessage> &messages)
+{
+    std::ifstream file(file_path);
+    if (!file.is_open())
+    {
+        std::cerr << "Could not open recording: " << file_path << std::endl;
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty())
+            continue;
+
+        try
+        {
+            nlohmann::json json_data = nlohmann::json::parse(line);
+            std::int64_t timestamp = json_data["data"].at(0).value("timestamp", std::int64_t{0});
+            messages.push_back({timestamp, json_data.dump()});
+        }
+        catch (const std::exception &e)
+        {
+            std::cerr << "Skipping malformed recording line: " << e.what() << std::endl;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Sends a buffer completely on a blocking socket.
+ *
+ * @param fd Connected socket.
+ * @param data Bytes to send.
+ * @return bool False if the peer is gone.
+ */
+static bool send_all(int fd, const std::string &data)
+{
+    std::size_t offset = 0;
+    while (offset < data.size())
+    {
+        ssize_t sent = send(fd, data.data() + offset, data.size() - offset, MSG_NOSIGNAL);
+        if (sent <= 0)
+            return false;
+        offset += static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+/**
+ * @brief Sends one unmasked text frame.
+ *
+ * @param fd Connected socket.
+ * @param text Frame payload.
+ * @return bool False if the peer is gone.
+ */
+static bool send_text(int fd, const std::string &text)
+{
+    std::string frame;
+    encode_websocket_frame(WebSocketOpcode::Text, text, false, frame);
+    return send_all(fd, frame);
+}
+
+/**
+ * @brief Reads the HTTP upgrade request and answers it.
+ *
+ * @param fd Connected socket.
+ * @param buffer Receives any bytes that followed the request.
+ * @return bool False if the request is not a WebSocket upgrade.
+ */
+static bool accept_handshake(int fd, std::string &buffer)
+{
+    char chunk[4096];
+    std::size_t header_end;
+    while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos)
+    {
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return false;
+        buffer.append(chunk, static_cast<std::size_t>(received));
+    }
+
+    std::string header = buffer.substr(0, header_end);
+    buffer.erase(0, header_end + 4);
+
+    std::size_t key_start = header.find("Sec-WebSocket-Key:");
+    if (key_start == std::string::npos)
+    {
+        send_all(fd, "HTTP/1.1 400 Bad Request\r\nContent-Length: 0\r\n\r\n");
+        return false;
+    }
+    key_start = header.find_first_not_of(' ', key_start + 18);
+    std::string key = header.substr(key_start, header.find("\r\n", key_start) - key_start);
+
+    return send_all(fd, "HTTP/1.1 101 Switching Protocols\r\n"
+                        "Upgrade: websocket\r\n"
+                        "Connection: Upgrade\r\n"
+                        "Sec-WebSocket-Accept: " + websocket_accept_key(key) + "\r\n\r\n");
+}
+
+/**
+ * @brief Answers every request of a client message with a success response.
+ *
+ * @param fd Connected socket.
+ * @param message Client message.
+ * @param subscribed Set once a SUBS request has been seen.
+ * @return bool False if the peer is gone.
+ */
+static bool answer_requests(int fd, const std::string &message, bool &subscribed)
+{
+    nlohmann::json json_data;
+    try
+    {
+        json_data = nlohmann::json::parse(message);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << "JSON Parsing Error: " << e.what() << std::endl;
+        return true;
+    }
+
+    nlohmann::json responses = nlohmann::json::array();
+    for (const auto &request : json_data.value("requests", nlohmann::json::array()))
+    {
+        std::string command = request.value("command", "");
+        std::cout << "Request: " << request.value("service", "") << " " << command << std::endl;
+        subscribed = subscribed || command == "SUBS";
+
+        std::int64_t now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+        responses.push_back({{"service", request.value("service", "")},
+                             {"command", command},
+                             {"requestid", request.value("requestid", "")},
+                             {"SchwabClientCorrelId", request.value("SchwabClientCorrelId", "")},
+                             {"timestamp", now},
+                             {"content", {{"code", 0}, {"msg", command + " succeeded"}}}});
+    }
+
+    return responses.empty() || send_text(fd, nlohmann::json{{"response", responses}}.dump());
+}
+
+/**
+ * @brief Serves one client: handshake, login and subscription, then the paced replay.
+ *
+ * @param fd Connected socket.
+ * @param messages Recorded messages.
+ * @param speed Replay speed relative to the recording; 0 replays without pauses.
+ * @param loop Whether to start over at the end of the recording.
+ */
+static void serve_client(int fd, const std::vector<RecordedMessage> &messages, double speed, bool loop)
+{
+    std::string buffer;
+    if (!accept_handshake(fd, buffer))
+        return;
+
+    bool subscribed = false;
+    std::size_t next = 0;
+    std::chrono::steady_clock::time_point replay_start;
+    std::string fragments;
+
+    while (true)
+    {
+        int timeout_ms = -1;
+        if (subscribed && next < messages.size())
+        {
+            double offset_ms = speed > 0 ? (messages[next].timestamp - messages.front().timestamp) / speed : 0.0;
+            auto due = replay_start + std::chrono::microseconds(static_cast<std::int64_t>(offset_ms * 1000));
+            auto now = std::chrono::steady_clock::now();
+            timeout_ms = due <= now ? 0 : static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(due - now).count()) + 1;
+
+            if (due <= now)
+            {
+                if (!send_text(fd, messages[next].text))
+                    return;
+                if (++next == messages.size() && loop)
+                {
+                    next = 0;
+                    replay_start = std::chrono::steady_clock::now();
+                }
+                continue;
+            }
+        }
+
+        pollfd descriptor = {fd, POLLIN, 0};
+        if (poll(&descriptor, 1, timeout_ms) < 0)
+            return;
+        if (!(descriptor.revents & (POLLIN | POLLHUP | POLLERR)))
+            continue;
+
+        char chunk[4096];
+        ssize_t received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            return;
+        buffer.append(chunk, static_cast<std::size_t>(received));
+
+        WebSocketFrame frame;
+        std::size_t consumed;
+        while ((consumed = decode_websocket_frame(buffer.data(), buffer.size(), frame)) > 0)
+        {
+            buffer.erase(0, consumed);
+            if (frame.opcode == WebSocketOpcode::Close)
+            {
+                std::string reply;
+                encode_websocket_frame(WebSocketOpcode::Close, frame.payload.substr(0, 2), false, reply);
+                send_all(fd, reply);
+                return;
+            }
+            if (frame.opcode == WebSocketOpcode::Ping)
+            {
+                std::string reply;
+                encode_websocket_frame(WebSocketOpcode::Pong, frame.payload, false, reply);
+                if (!send_all(fd, reply))
+                    return;
+                continue;
+            }
+            if (frame.opcode != WebSocketOpcode::Text && frame.opcode != WebSocketOpcode::Continuation)
+                continue;
+
+            fragments += frame.payload;
+            if (!frame.fin)
+                continue;
+
+            bool was_subscribed = subscribed;
+            if (!answer_requests(fd, fragments, subscribed))
+                return;
+            fragments.clear();
+
+            if (subscribed && !was_subscribed)
+            {
+                std::cout << "Replaying " << messages.size() << " messages." << std::endl;
+                replay_start = std::chrono::steady_clock::now();
+            }
+        }
+    }
+}
+
+/**
+ * @brief Local stand-in for the Schwab streamer that replays a recording.
+ *
+ * Usage: stream_replay_server <recording.jsonl> [port] [--speed X | --fast] [--loop]
+ *
+ * The recording is played back with its original spacing scaled by 1 / speed, starting when the
+ * client subscribes. Any login and subscription request is accepted.
+ *
+ * @return int Exit status code.
+ */
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " <recording.jsonl> [port] [--speed X | --fast] [--loop]" << std::endl;
+        return 1;
+    }
+
+    int port = 8765;
+    double speed = 1.0;
+    bool loop = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (arg == "--fast")
+            speed = 0.0;
+        else if (arg == "--loop")
+            loop = true;
+        else if (arg == "--speed" && i + 1 < argc)
+            speed = std::stod(argv[++i]);
+        else
+            port = std::stoi(arg);
+    }
+
+    std::vector<RecordedMessage> messages;
+    if (!load_recording(argv[1], messages))
+        return 1;
+
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = htons(static_cast<std::uint16_t>(port));
+    if (bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) < 0 || listen(listener, 4) < 0)
+    {
+        std::cerr << "Could not listen on port " << port << ": " << std::strerror(errno) << std::endl;
+        return 1;
+    }
+
+    std::cout << "Listening on ws://127.0.0.1:" << port << " with " << messages.size() << " recorded messages." << std::endl;
+    while (true)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+            continue;
+
+        std::cout << "Client connected." << std::endl;
+        serve_client(client, messages, speed, loop);
+        close(client);
+        std::cout << "Client disconnected." << std::endl;
+    }
+}